@@ -0,0 +1,199 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// MathBench times the SIMD math kernels against plain glm over the same
+// arrays of transforms, at every SIMD level the CPU supports, and checks
+// each level's results against glm's. It finishes with a full transform
+// graph update of every node, the per-frame work of a scene where all of
+// them are animated. The number of transforms defaults to 100000 and can be
+// given as the only argument.
+#include "../Project1/JobSystem.h"
+#include "../Project1/SimdMath.h"
+#include "../Project1/TransformGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtx/transform.hpp>
+
+namespace {
+  // Runs of each timing, the fastest of which is reported
+  const int kRuns = 20;
+
+  // Largest difference from glm's result allowed, relative to the size of
+  // the value
+  const float kTolerance = 1e-4f;
+
+  // Fastest of kRuns runs of work, in milliseconds
+  double TimeMs(const std::function<void()>& work) {
+    double best = 0.0;
+    for (int run = 0; run < kRuns; ++run) {
+      std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+      work();
+      std::chrono::duration<double, std::milli> ms =
+        std::chrono::steady_clock::now() - start;
+      if (run == 0 || ms.count() < best) {
+        best = ms.count();
+      }
+    }
+    return best;
+  }
+
+  // Largest relative difference between two arrays of floats
+  float MaxError(const float* a, const float* b, size_t count) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+      float error = std::fabs(a[i] - b[i]) / (1.0f + std::fabs(b[i]));
+      worst = std::max(worst, error);
+    }
+    return worst;
+  }
+
+  // Scale, rotation about a random axis, and translation, like a model
+  // matrix placed by hand
+  glm::mat4 RandomTransform(std::mt19937* rng) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+    glm::vec3 axis(unit(*rng), unit(*rng), unit(*rng));
+    if (glm::length(axis) < 0.01f) {
+      axis = glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    return glm::translate(glm::vec3(unit(*rng), unit(*rng), unit(*rng)) *
+                          50.0f)
+         * glm::rotate(unit(*rng) * 3.14159f, glm::normalize(axis))
+         * glm::scale(glm::vec3(scale(*rng), scale(*rng), scale(*rng)));
+  }
+
+  void Report(const std::string& name, double ms, double baseMs,
+              float error) {
+    std::cout << "  " << std::left << std::setw(22) << name << std::right
+              << std::fixed << std::setprecision(3) << std::setw(9) << ms
+              << " ms" << std::setprecision(2) << std::setw(8)
+              << baseMs / ms << "x";
+    if (error >= 0.0f) {
+      std::cout << std::scientific << std::setprecision(1)
+                << "   max error " << error
+                << (error > kTolerance ? "  MISMATCH" : "");
+    }
+    std::cout << std::endl;
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t count = 100000;
+  if (argc > 1) {
+    count = static_cast<uint32_t>(std::max(1L, std::atol(argv[1])));
+  }
+
+  // Random transforms, each with a random earlier one as its parent
+  std::mt19937 rng(330);
+  std::vector<glm::mat4> parents(count);
+  std::vector<glm::mat4> locals(count);
+  std::vector<uint32_t> parentIdx(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    parents[i] = RandomTransform(&rng);
+    locals[i] = RandomTransform(&rng);
+    parentIdx[i] = rng() % count;
+  }
+
+  // glm's results, which every level is checked against
+  std::vector<glm::mat4> glmProducts(count);
+  std::vector<glm::mat3> glmNormals(count);
+  std::vector<glm::mat4> glmInverses(count);
+  double glmMultiplyMs = TimeMs([&] {
+    for (uint32_t i = 0; i < count; ++i) {
+      glmProducts[i] = parents[parentIdx[i]] * locals[i];
+    }
+  });
+  double glmNormalMs = TimeMs([&] {
+    for (uint32_t i = 0; i < count; ++i) {
+      glmNormals[i] = glm::transpose(glm::inverse(glm::mat3(locals[i])));
+    }
+  });
+  double glmInverseMs = TimeMs([&] {
+    for (uint32_t i = 0; i < count; ++i) {
+      glmInverses[i] = glm::affineInverse(locals[i]);
+    }
+  });
+
+  std::cout << count << " transforms, best of " << kRuns << " runs"
+            << std::endl << "glm" << std::endl;
+  Report("multiply", glmMultiplyMs, glmMultiplyMs, -1.0f);
+  Report("normal matrix", glmNormalMs, glmNormalMs, -1.0f);
+  Report("affine inverse", glmInverseMs, glmInverseMs, -1.0f);
+
+  // Each level from scalar up to the best the CPU has
+  std::vector<glm::mat4> products(count);
+  std::vector<glm::mat3> normals(count);
+  std::vector<glm::mat4> inverses(count);
+  SimdLevel best = DetectSimdLevel();
+  for (int level = SIMD_SCALAR; level <= best; ++level) {
+    SetSimdLevel(static_cast<SimdLevel>(level));
+    std::cout << SimdLevelName(GetSimdLevel()) << std::endl;
+
+    double ms = TimeMs([&] {
+      MultiplyMat4(parents.data(), parentIdx.data(), locals.data(),
+                   products.data(), count);
+    });
+    Report("multiply", ms, glmMultiplyMs,
+           MaxError(&products[0][0][0], &glmProducts[0][0][0],
+                    count * 16));
+    ms = TimeMs([&] {
+      NormalMats(locals.data(), normals.data(), count);
+    });
+    Report("normal matrix", ms, glmNormalMs,
+           MaxError(&normals[0][0][0], &glmNormals[0][0][0], count * 9));
+    ms = TimeMs([&] {
+      AffineInverse(locals.data(), inverses.data(), count);
+    });
+    Report("affine inverse", ms, glmInverseMs,
+           MaxError(&inverses[0][0][0], &glmInverses[0][0][0],
+                    count * 16));
+  }
+  SetSimdLevel(best);
+
+  // A graph of a few hundred assemblies, each a root with parts up to three
+  // levels under it, fully dirtied each time as if every node were animated
+  TransformGraph graph;
+  std::vector<TransformGraph::NodeId> level;
+  for (uint32_t i = 0; i < count; ++i) {
+    TransformGraph::NodeId parent = TransformGraph::kNoNode;
+    if (i % 256 != 0) {
+      parent = level[rng() % level.size()];
+    } else {
+      level.clear();
+    }
+    TransformGraph::NodeId node = graph.AddNode(parent, locals[i]);
+    if (level.size() < 16) {
+      level.push_back(node);
+    }
+  }
+  JobSystem jobs;
+  jobs.Start();
+  for (int pass = 0; pass < 2; ++pass) {
+    JobSystem* passJobs = pass == 0 ? nullptr : &jobs;
+    double ms = TimeMs([&] {
+      for (uint32_t node = 0; node < count; ++node) {
+        graph.SetLocal(node, locals[node]);
+      }
+      graph.Update(passJobs);
+    });
+    std::cout << "Graph update, every node dirty, "
+              << (pass == 0 ? 1 : jobs.NumThreads()) << " thread(s): "
+              << std::fixed << std::setprecision(3) << ms << " ms"
+              << std::endl;
+  }
+  return 0;
+}
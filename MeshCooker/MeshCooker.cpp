@@ -0,0 +1,54 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// MeshCooker is the offline half of the cooked mesh pipeline. It runs the
+// same Assimp import the renderer would, then writes each mesh out as a
+// .mesh file the renderer can map at startup instead of parsing COLLADA.
+// Run it from the Project1 directory. With no arguments it cooks every .DAE
+// in mesh/, otherwise only the .DAE filenames given.
+#include "../Project1/MeshCook.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+  // Filenames of meshes to cook, relative to mesh/
+  std::vector<std::string> meshFiles;
+
+  if (argc > 1) {
+    // Cook only what was asked for
+    for (int i = 1; i < argc; ++i) {
+      meshFiles.push_back(argv[i]);
+    }
+  } else {
+    // Cook everything in the mesh directory
+    std::error_code err;
+    std::filesystem::directory_iterator dirIter("mesh", err);
+    if (err) {
+      std::cerr << "No mesh directory found. Run from Project1." << std::endl;
+      return 1;
+    }
+    for (const std::filesystem::directory_entry& entry : dirIter) {
+      if (entry.path().extension() == ".dae") {
+        meshFiles.push_back(entry.path().filename().string());
+      }
+    }
+  }
+
+  // Importing and writing cooked files, reusing one importer. No OpenGL
+  // context is needed.
+  Assimp::Importer importer;
+  int failures = 0;
+  std::vector<std::string>::iterator fileIter = meshFiles.begin();
+  for (; fileIter != meshFiles.end(); ++fileIter) {
+    if (!WriteCookedMesh(*fileIter, &importer)) {
+      std::cerr << "Skipping " << *fileIter << std::endl;
+      ++failures;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
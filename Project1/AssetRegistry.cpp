@@ -0,0 +1,21 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The AssetRegistry class maps a content hash to one shared, reference
+// counted copy of an asset (a GL texture, a mesh's buffers). Anything that
+// hashes the same is loaded once and handed out by reference, no matter how
+// many textures or meshes name it or what file it came from.
+#include "AssetRegistry.h"
+
+// FNV-1a: xor in each byte, then multiply by the FNV prime
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  uint64_t hash = seed;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
@@ -0,0 +1,88 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The AssetRegistry class maps a content hash to one shared, reference
+// counted copy of an asset (a GL texture, a mesh's buffers). Anything that
+// hashes the same is loaded once and handed out by reference, no matter how
+// many textures or meshes name it or what file it came from.
+#pragma once
+#ifndef ASSET_REG
+#define ASSET_REG
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+// 64-bit FNV-1a hash of a byte range. Chain calls by passing the previous
+// result as the seed.
+uint64_t HashBytes(const void* data, size_t size,
+                   uint64_t seed = 0xcbf29ce484222325ULL);
+
+// Registry of shared assets of type T, keyed by content hash. Not thread
+// safe; only the thread that owns the GL context touches it.
+template <typename T>
+class AssetRegistry {
+ private:
+  struct Entry {
+    T asset;
+    int refCount = 0;
+  };
+
+  std::map<uint64_t, Entry> entries;
+
+ public:
+  // Finds an asset and adds a reference to it. nullptr if not registered.
+  T* Acquire(uint64_t key) {
+    typename std::map<uint64_t, Entry>::iterator entry = entries.find(key);
+    if (entry == entries.end()) {
+      return nullptr;
+    }
+    ++entry->second.refCount;
+    return &entry->second.asset;
+  }
+
+  // Finds an asset without taking a reference. nullptr if not registered.
+  const T* Find(uint64_t key) const {
+    typename std::map<uint64_t, Entry>::const_iterator entry =
+      entries.find(key);
+    if (entry == entries.end()) {
+      return nullptr;
+    }
+    return &entry->second.asset;
+  }
+
+  // Registers a newly loaded asset with no references. Users take theirs
+  // with Acquire.
+  void Insert(uint64_t key, T asset) {
+    Entry* entry = &entries[key];
+    entry->asset = std::move(asset);
+    entry->refCount = 0;
+  }
+
+  // Drops a reference. Returns true and moves the asset into out when that
+  // was the last one, so the caller can free its GL objects.
+  bool Release(uint64_t key, T* out) {
+    typename std::map<uint64_t, Entry>::iterator entry = entries.find(key);
+    if (entry == entries.end() || --entry->second.refCount > 0) {
+      return false;
+    }
+    *out = std::move(entry->second.asset);
+    entries.erase(entry);
+    return true;
+  }
+
+  // True if an asset with this hash is registered
+  bool Contains(uint64_t key) const {
+    return entries.count(key) != 0;
+  }
+
+  // Number of unique assets currently registered
+  size_t Size() const {
+    return entries.size();
+  }
+};
+#endif
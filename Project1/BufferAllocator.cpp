@@ -0,0 +1,317 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The BufferAllocator class hands out ranges of a buffer that lives somewhere
+// else (here, a GL buffer object). It only does the bookkeeping, so it works
+// in whatever units its owner likes: vertices, bytes. Free ranges are kept
+// in two-level segregated fit lists (TLSF, Masmano et al. 2004), so
+// allocating and freeing take constant time, and freed ranges merge with
+// free neighbors straight away.
+#include "BufferAllocator.h"
+
+#include <algorithm>
+
+namespace {
+  // Index of the lowest set bit. x must not be 0.
+  uint32_t LowestBit(uint32_t x) {
+    uint32_t bit = 0;
+    while ((x & 1u) == 0) {
+      x >>= 1;
+      ++bit;
+    }
+    return bit;
+  }
+
+  // Index of the highest set bit. x must not be 0.
+  uint32_t HighestBit(uint32_t x) {
+    uint32_t bit = 0;
+    while (x >>= 1) {
+      ++bit;
+    }
+    return bit;
+  }
+}  // namespace
+
+BufferAllocator::BufferAllocator(uint32_t size) {
+  for (uint32_t fl = 0; fl < kFlCount; ++fl) {
+    slBitmaps[fl] = 0;
+    for (uint32_t sl = 0; sl < kSlCount; ++sl) {
+      freeHeads[fl][sl] = kNoBlock;
+    }
+  }
+  Grow(size);
+}
+
+// Small sizes get a list each; larger ones are split by their top bit
+// (first level) and the kSlBits bits below it (second level)
+void BufferAllocator::MapInsert(uint32_t size, uint32_t* fl, uint32_t* sl) {
+  if (size < kSlCount) {
+    *fl = 0;
+    *sl = size;
+  } else {
+    uint32_t topBit = HighestBit(size);
+    *sl = (size >> (topBit - kSlBits)) ^ kSlCount;
+    *fl = topBit - kSlBits + 1;
+  }
+}
+
+// Rounding up to the next list boundary first, so any block in the list
+// found is big enough without searching it
+void BufferAllocator::MapSearch(uint32_t size, uint32_t* fl, uint32_t* sl) {
+  uint64_t rounded = size;
+  if (size >= kSlCount) {
+    rounded += (1u << (HighestBit(size) - kSlBits)) - 1;
+  }
+  if (rounded > 0xffffffffULL) {
+    *fl = kFlCount;
+    *sl = 0;
+    return;
+  }
+  MapInsert(static_cast<uint32_t>(rounded), fl, sl);
+}
+
+// Any free range at least this big lands in the class MapSearch picks or
+// a later one
+uint32_t BufferAllocator::SearchSize(uint32_t size) {
+  if (size == 0) {
+    size = 1;
+  }
+  uint64_t rounded = size;
+  if (size >= kSlCount) {
+    rounded += (1u << (HighestBit(size) - kSlBits)) - 1;
+  }
+  return static_cast<uint32_t>(std::min<uint64_t>(rounded, 0xffffffffULL));
+}
+
+// Reuses a spare slot if there is one
+uint32_t BufferAllocator::NewBlock() {
+  if (!spareBlocks.empty()) {
+    uint32_t block = spareBlocks.back();
+    spareBlocks.pop_back();
+    blocks[block] = Block();
+    return block;
+  }
+  blocks.push_back(Block());
+  return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+// Pushes block onto the front of its size class list
+void BufferAllocator::InsertFree(uint32_t block) {
+  uint32_t fl = 0;
+  uint32_t sl = 0;
+  MapInsert(blocks[block].size, &fl, &sl);
+  uint32_t head = freeHeads[fl][sl];
+  blocks[block].free = true;
+  blocks[block].prevFree = kNoBlock;
+  blocks[block].nextFree = head;
+  if (head != kNoBlock) {
+    blocks[head].prevFree = block;
+  }
+  freeHeads[fl][sl] = block;
+  flBitmap |= 1u << fl;
+  slBitmaps[fl] |= 1u << sl;
+}
+
+// Unlinks block from its size class list, clearing bits of emptied lists
+void BufferAllocator::RemoveFree(uint32_t block) {
+  uint32_t fl = 0;
+  uint32_t sl = 0;
+  MapInsert(blocks[block].size, &fl, &sl);
+  uint32_t prev = blocks[block].prevFree;
+  uint32_t next = blocks[block].nextFree;
+  if (prev != kNoBlock) {
+    blocks[prev].nextFree = next;
+  }
+  if (next != kNoBlock) {
+    blocks[next].prevFree = prev;
+  }
+  if (freeHeads[fl][sl] == block) {
+    freeHeads[fl][sl] = next;
+    if (next == kNoBlock) {
+      slBitmaps[fl] &= ~(1u << sl);
+      if (slBitmaps[fl] == 0) {
+        flBitmap &= ~(1u << fl);
+      }
+    }
+  }
+  blocks[block].free = false;
+  blocks[block].prevFree = kNoBlock;
+  blocks[block].nextFree = kNoBlock;
+}
+
+// Takes over next neighbor's range and physical links
+void BufferAllocator::AbsorbNext(uint32_t block) {
+  uint32_t next = blocks[block].nextPhys;
+  uint32_t afterNext = blocks[next].nextPhys;
+  blocks[block].size += blocks[next].size;
+  blocks[block].nextPhys = afterNext;
+  if (afterNext != kNoBlock) {
+    blocks[afterNext].prevPhys = block;
+  } else {
+    lastBlock = block;
+  }
+  blocks[next] = Block();
+  spareBlocks.push_back(next);
+}
+
+// Finds a free block in the smallest non-empty size class that fits,
+// splitting off whatever's left over
+uint32_t BufferAllocator::Allocate(uint32_t size) {
+  if (size == 0) {
+    size = 1;
+  }
+
+  // Searching this size class and up, then larger powers of two
+  uint32_t fl = 0;
+  uint32_t sl = 0;
+  MapSearch(size, &fl, &sl);
+  if (fl >= kFlCount) {
+    return kNoBlock;
+  }
+  uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+  if (slMap == 0) {
+    uint32_t flMap = fl + 1 < 32 ? flBitmap & (~0u << (fl + 1)) : 0;
+    if (flMap == 0) {
+      return kNoBlock;
+    }
+    fl = LowestBit(flMap);
+    slMap = slBitmaps[fl];
+  }
+  sl = LowestBit(slMap);
+  uint32_t block = freeHeads[fl][sl];
+  RemoveFree(block);
+
+  // Returning the tail to the free lists as its own block
+  if (blocks[block].size > size) {
+    uint32_t rest = NewBlock();
+    blocks[rest].offset = blocks[block].offset + size;
+    blocks[rest].size = blocks[block].size - size;
+    blocks[rest].prevPhys = block;
+    blocks[rest].nextPhys = blocks[block].nextPhys;
+    if (blocks[rest].nextPhys != kNoBlock) {
+      blocks[blocks[rest].nextPhys].prevPhys = rest;
+    } else {
+      lastBlock = rest;
+    }
+    blocks[block].nextPhys = rest;
+    blocks[block].size = size;
+    InsertFree(rest);
+  }
+
+  used += size;
+  ++numAllocs;
+  return block;
+}
+
+// Merging with free neighbors before going back on a list
+void BufferAllocator::Free(uint32_t block) {
+  used -= blocks[block].size;
+  --numAllocs;
+
+  uint32_t next = blocks[block].nextPhys;
+  if (next != kNoBlock && blocks[next].free) {
+    RemoveFree(next);
+    AbsorbNext(block);
+  }
+  uint32_t prev = blocks[block].prevPhys;
+  if (prev != kNoBlock && blocks[prev].free) {
+    RemoveFree(prev);
+    AbsorbNext(prev);
+    block = prev;
+  }
+  InsertFree(block);
+}
+
+uint32_t BufferAllocator::Offset(uint32_t block) const {
+  return blocks[block].offset;
+}
+
+uint32_t BufferAllocator::Size(uint32_t block) const {
+  return blocks[block].size;
+}
+
+// Extends the last block if it's free, otherwise adds a new one after it
+void BufferAllocator::Grow(uint32_t newSize) {
+  if (newSize <= capacity) {
+    return;
+  }
+  uint32_t extra = newSize - capacity;
+  if (lastBlock != kNoBlock && blocks[lastBlock].free) {
+    RemoveFree(lastBlock);
+    blocks[lastBlock].size += extra;
+    InsertFree(lastBlock);
+  } else {
+    uint32_t block = NewBlock();
+    blocks[block].offset = capacity;
+    blocks[block].size = extra;
+    blocks[block].prevPhys = lastBlock;
+    if (lastBlock != kNoBlock) {
+      blocks[lastBlock].nextPhys = block;
+    } else {
+      firstBlock = block;
+    }
+    lastBlock = block;
+    InsertFree(block);
+  }
+  capacity = newSize;
+}
+
+// Relinks allocated blocks back to back, dropping free ones, then adds the
+// space freed up as one block at the end
+void BufferAllocator::Compact(std::vector<Move>* moves) {
+  uint32_t nextOffset = 0;
+  uint32_t prev = kNoBlock;
+  uint32_t block = firstBlock;
+  firstBlock = kNoBlock;
+  while (block != kNoBlock) {
+    uint32_t next = blocks[block].nextPhys;
+    if (blocks[block].free) {
+      RemoveFree(block);
+      blocks[block] = Block();
+      spareBlocks.push_back(block);
+    } else {
+      if (blocks[block].offset != nextOffset) {
+        moves->push_back(Move{ blocks[block].offset, nextOffset,
+                               blocks[block].size });
+        blocks[block].offset = nextOffset;
+      }
+      nextOffset += blocks[block].size;
+      blocks[block].prevPhys = prev;
+      if (prev != kNoBlock) {
+        blocks[prev].nextPhys = block;
+      } else {
+        firstBlock = block;
+      }
+      prev = block;
+    }
+    block = next;
+  }
+  if (prev != kNoBlock) {
+    blocks[prev].nextPhys = kNoBlock;
+  }
+  lastBlock = prev;
+
+  // Everything past the last allocation is free again
+  uint32_t fullSize = capacity;
+  capacity = nextOffset;
+  Grow(fullSize);
+}
+
+// Largest block is somewhere in the highest non-empty list
+uint32_t BufferAllocator::LargestFree() const {
+  if (flBitmap == 0) {
+    return 0;
+  }
+  uint32_t fl = HighestBit(flBitmap);
+  uint32_t sl = HighestBit(slBitmaps[fl]);
+  uint32_t largest = 0;
+  uint32_t block = freeHeads[fl][sl];
+  for (; block != kNoBlock; block = blocks[block].nextFree) {
+    if (blocks[block].size > largest) {
+      largest = blocks[block].size;
+    }
+  }
+  return largest;
+}
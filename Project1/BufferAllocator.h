@@ -0,0 +1,119 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The BufferAllocator class hands out ranges of a buffer that lives somewhere
+// else (here, a GL buffer object). It only does the bookkeeping, so it works
+// in whatever units its owner likes: vertices, bytes. Free ranges are kept
+// in two-level segregated fit lists (TLSF, Masmano et al. 2004), so
+// allocating and freeing take constant time, and freed ranges merge with
+// free neighbors straight away.
+#pragma once
+#ifndef BUFF_ALLOC
+#define BUFF_ALLOC
+
+#include <cstdint>
+#include <vector>
+
+class BufferAllocator {
+ public:
+  // Returned by Allocate when nothing fits
+  static const uint32_t kNoBlock = ~0u;
+
+  // A live range moved by Compact, for the owner to copy its data
+  struct Move {
+    uint32_t srcOffset = 0;
+    uint32_t dstOffset = 0;
+    uint32_t size = 0;
+  };
+
+ private:
+  // Second level lists per power of two: sizes between 2^n and 2^(n+1) are
+  // split into 2^kSlBits lists, so a list's blocks differ by at most 1/16
+  static const uint32_t kSlBits = 4;
+  static const uint32_t kSlCount = 1u << kSlBits;
+  static const uint32_t kFlCount = 32 - kSlBits + 1;
+
+  // One range of the buffer, free or allocated. Physical links run through
+  // neighbors in offset order; free links run through its size class list.
+  struct Block {
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    uint32_t prevPhys = kNoBlock;
+    uint32_t nextPhys = kNoBlock;
+    uint32_t prevFree = kNoBlock;
+    uint32_t nextFree = kNoBlock;
+    bool free = false;
+  };
+
+  // Every block, indexed by handle, and handles of unused slots
+  std::vector<Block> blocks;
+  std::vector<uint32_t> spareBlocks;
+
+  // Heads of the free lists, and bitmaps of which lists are non-empty
+  uint32_t freeHeads[kFlCount][kSlCount];
+  uint32_t flBitmap = 0;
+  uint32_t slBitmaps[kFlCount];
+
+  // Block at offset 0 and block at the end
+  uint32_t firstBlock = kNoBlock;
+  uint32_t lastBlock = kNoBlock;
+
+  uint32_t capacity = 0;
+  uint32_t used = 0;
+  uint32_t numAllocs = 0;
+
+  // Size class of a free block of this size
+  static void MapInsert(uint32_t size, uint32_t* fl, uint32_t* sl);
+
+  // Smallest size class whose blocks are all at least this size
+  static void MapSearch(uint32_t size, uint32_t* fl, uint32_t* sl);
+
+  // Takes a slot for a new block, reusing freed ones
+  uint32_t NewBlock();
+
+  // Adds or removes a free block from its size class list
+  void InsertFree(uint32_t block);
+  void RemoveFree(uint32_t block);
+
+  // Merges a free block into its next physical neighbor's range. The
+  // neighbor's slot is returned to the spares.
+  void AbsorbNext(uint32_t block);
+
+ public:
+  // Manages ranges of a buffer of the given size
+  explicit BufferAllocator(uint32_t size = 0);
+
+  // Takes size units, returning a handle for the range or kNoBlock if no
+  // free range is big enough. Handles stay valid until freed, even across
+  // Grow and Compact.
+  uint32_t Allocate(uint32_t size);
+
+  // Free range size Allocate(size) is sure to find. Allocate only searches
+  // size classes whose every block fits, so a free range barely bigger
+  // than size can still be passed over.
+  static uint32_t SearchSize(uint32_t size);
+
+  // Returns a range, merging it with free neighbors
+  void Free(uint32_t block);
+
+  // Current offset and size of an allocated range
+  uint32_t Offset(uint32_t block) const;
+  uint32_t Size(uint32_t block) const;
+
+  // Extends the buffer to newSize units. The new space is free.
+  void Grow(uint32_t newSize);
+
+  // Slides every allocated range down to close the gaps between them,
+  // leaving one free range at the end. Appends a move for each range that
+  // changed offset, in offset order, for the owner to copy its data.
+  void Compact(std::vector<Move>* moves);
+
+  // Usage, for deciding when to compact or grow
+  uint32_t Capacity() const { return capacity; }
+  uint32_t Used() const { return used; }
+  uint32_t NumAllocs() const { return numAllocs; }
+  uint32_t LargestFree() const;
+};
+#endif
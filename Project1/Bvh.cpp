@@ -0,0 +1,355 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The Bvh class is a bounding volume hierarchy over axis-aligned boxes, each
+// tagged with a caller's item number. Nodes live in one flat array and refer
+// to their children by index; a fresh build lays them out depth first, so a
+// node's first child sits right after it. Builds split by the surface area
+// heuristic (SAH), which puts the cut where the chance of a query visiting
+// each side, times the boxes on that side, is smallest. After a build, boxes
+// can be inserted and removed one at a time (an insert walks down picking
+// the sibling that grows the tree's total area least) and moved either by
+// refitting their ancestors, which is cheap, or by removing and inserting
+// again, which keeps the tree tighter. All queries go through Query, with a
+// volume that says how each node's box relates to it.
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace {
+  // Buckets that box centers are sorted into along the split axis. Only
+  // cuts between buckets are costed, which is nearly as good as trying
+  // every box and much cheaper.
+  const int kNumBins = 16;
+}  // namespace
+
+float Bvh::Area(const Aabb& box) {
+  glm::vec3 size = box.max - box.min;
+  return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+Bvh::Aabb Bvh::Union(const Aabb& a, const Aabb& b) {
+  Aabb box;
+  box.min = glm::min(a.min, b.min);
+  box.max = glm::max(a.max, b.max);
+  return box;
+}
+
+uint32_t Bvh::AllocNode() {
+  uint32_t node = 0;
+  if (!freeNodes.empty()) {
+    node = freeNodes.back();
+    freeNodes.pop_back();
+    nodes[node] = Node();
+  } else {
+    node = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node());
+    parents.push_back(0);
+  }
+  parents[node] = kNoNode;
+  return node;
+}
+
+void Bvh::FreeNode(uint32_t node) {
+  freeNodes.push_back(node);
+}
+
+void Bvh::RefitFrom(uint32_t node) {
+  while (node != kNoNode) {
+    nodes[node].box = Union(nodes[nodes[node].left].box,
+                            nodes[nodes[node].right].box);
+    node = parents[node];
+  }
+}
+
+// Reserving every node up front so the depth-first build never reallocates
+void Bvh::Build(const Aabb* boxes, const uint32_t* items, uint32_t count,
+                uint32_t* leaves) {
+  Clear();
+  if (count == 0) {
+    return;
+  }
+  nodes.reserve(2 * count - 1);
+  parents.reserve(2 * count - 1);
+
+  std::vector<Aabb> boxCopy(boxes, boxes + count);
+  std::vector<glm::vec3> centers(count);
+  std::vector<uint32_t> order(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    centers[i] = (boxes[i].min + boxes[i].max) * 0.5f;
+    order[i] = i;
+  }
+  root = BuildRange(boxCopy, centers, items, order.data(), 0, count, leaves);
+}
+
+// Splitting at the cheapest bucket boundary along the axis the centers
+// spread furthest on. Falls back to an even split by count when every
+// center is in one place or every cut leaves a side empty.
+uint32_t Bvh::BuildRange(const std::vector<Aabb>& boxes,
+                         const std::vector<glm::vec3>& centers,
+                         const uint32_t* items, uint32_t* order,
+                         uint32_t begin, uint32_t end, uint32_t* leaves) {
+  uint32_t nodeIdx = AllocNode();
+  if (end - begin == 1) {
+    uint32_t boxIdx = order[begin];
+    nodes[nodeIdx].box = boxes[boxIdx];
+    nodes[nodeIdx].left = kNoNode;
+    nodes[nodeIdx].right = items[boxIdx];
+    leaves[boxIdx] = nodeIdx;
+    return nodeIdx;
+  }
+
+  // Bounds of the boxes, and of their centers
+  Aabb bounds = boxes[order[begin]];
+  Aabb centerBounds;
+  centerBounds.min = centers[order[begin]];
+  centerBounds.max = centerBounds.min;
+  for (uint32_t i = begin + 1; i < end; ++i) {
+    bounds = Union(bounds, boxes[order[i]]);
+    centerBounds.min = glm::min(centerBounds.min, centers[order[i]]);
+    centerBounds.max = glm::max(centerBounds.max, centers[order[i]]);
+  }
+  glm::vec3 spread = centerBounds.max - centerBounds.min;
+  int axis = 0;
+  if (spread.y > spread[axis]) {
+    axis = 1;
+  }
+  if (spread.z > spread[axis]) {
+    axis = 2;
+  }
+
+  uint32_t mid = begin;
+  if (spread[axis] > 0.0f) {
+    // Dropping centers into buckets
+    float binScale = kNumBins / spread[axis];
+    float axisMin = centerBounds.min[axis];
+    Aabb binBoxes[kNumBins];
+    uint32_t binCounts[kNumBins] = {};
+    for (uint32_t i = begin; i < end; ++i) {
+      int bin = std::min(kNumBins - 1, static_cast<int>(
+                  (centers[order[i]][axis] - axisMin) * binScale));
+      binBoxes[bin] = binCounts[bin] == 0 ? boxes[order[i]]
+                                          : Union(binBoxes[bin],
+                                                  boxes[order[i]]);
+      ++binCounts[bin];
+    }
+
+    // Cost of everything right of each boundary, swept from the right
+    float rightCosts[kNumBins] = {};
+    Aabb sideBox;
+    uint32_t sideCount = 0;
+    for (int bin = kNumBins - 1; bin > 0; --bin) {
+      if (binCounts[bin] > 0) {
+        sideBox = sideCount == 0 ? binBoxes[bin]
+                                 : Union(sideBox, binBoxes[bin]);
+        sideCount += binCounts[bin];
+      }
+      rightCosts[bin] = sideCount == 0 ? FLT_MAX : Area(sideBox) * sideCount;
+    }
+
+    // Adding the left side's cost while sweeping back from the left
+    float bestCost = FLT_MAX;
+    int bestBin = -1;
+    sideCount = 0;
+    for (int bin = 0; bin < kNumBins - 1; ++bin) {
+      if (binCounts[bin] > 0) {
+        sideBox = sideCount == 0 ? binBoxes[bin]
+                                 : Union(sideBox, binBoxes[bin]);
+        sideCount += binCounts[bin];
+      }
+      if (sideCount == 0 || rightCosts[bin + 1] == FLT_MAX) {
+        continue;
+      }
+      float cost = Area(sideBox) * sideCount + rightCosts[bin + 1];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestBin = bin;
+      }
+    }
+
+    if (bestBin >= 0) {
+      uint32_t* split = std::partition(
+        order + begin, order + end, [&](uint32_t boxIdx) {
+          int bin = std::min(kNumBins - 1, static_cast<int>(
+                      (centers[boxIdx][axis] - axisMin) * binScale));
+          return bin <= bestBin;
+        });
+      mid = static_cast<uint32_t>(split - order);
+    }
+  }
+  if (mid == begin || mid == end) {
+    mid = begin + (end - begin) / 2;
+    std::nth_element(order + begin, order + mid, order + end,
+                     [&](uint32_t a, uint32_t b) {
+                       return centers[a][axis] < centers[b][axis];
+                     });
+  }
+
+  // Children are built after their parent, so the first child lands right
+  // after it in the array
+  uint32_t left = BuildRange(boxes, centers, items, order, begin, mid,
+                             leaves);
+  uint32_t right = BuildRange(boxes, centers, items, order, mid, end,
+                              leaves);
+  nodes[nodeIdx].box = bounds;
+  nodes[nodeIdx].left = left;
+  nodes[nodeIdx].right = right;
+  parents[left] = nodeIdx;
+  parents[right] = nodeIdx;
+  return nodeIdx;
+}
+
+// Walking down from the root while splitting off a child is cheaper than
+// pairing the new leaf with the current node. Every node passed on the way
+// down grows to hold the new box, which is the inherited cost.
+uint32_t Bvh::Insert(const Aabb& box, uint32_t item) {
+  uint32_t leaf = AllocNode();
+  nodes[leaf].box = box;
+  nodes[leaf].left = kNoNode;
+  nodes[leaf].right = item;
+  if (root == kNoNode) {
+    root = leaf;
+    return leaf;
+  }
+
+  uint32_t sibling = root;
+  while (nodes[sibling].left != kNoNode) {
+    const Node& node = nodes[sibling];
+    float combinedArea = Area(Union(node.box, box));
+    float pairCost = 2.0f * combinedArea;
+    float inheritCost = 2.0f * (combinedArea - Area(node.box));
+
+    float childCosts[2] = {};
+    uint32_t children[2] = { node.left, node.right };
+    for (int i = 0; i < 2; ++i) {
+      const Node& child = nodes[children[i]];
+      float grownArea = Area(Union(child.box, box));
+      if (child.left != kNoNode) {
+        grownArea -= Area(child.box);
+      }
+      childCosts[i] = grownArea + inheritCost;
+    }
+    if (pairCost < childCosts[0] && pairCost < childCosts[1]) {
+      break;
+    }
+    sibling = childCosts[0] <= childCosts[1] ? children[0] : children[1];
+  }
+
+  // New parent takes the sibling's place, with the sibling and new leaf
+  // as its children
+  uint32_t oldParent = parents[sibling];
+  uint32_t newParent = AllocNode();
+  nodes[newParent].box = Union(nodes[sibling].box, box);
+  nodes[newParent].left = sibling;
+  nodes[newParent].right = leaf;
+  parents[newParent] = oldParent;
+  parents[sibling] = newParent;
+  parents[leaf] = newParent;
+  if (oldParent == kNoNode) {
+    root = newParent;
+  } else {
+    if (nodes[oldParent].left == sibling) {
+      nodes[oldParent].left = newParent;
+    } else {
+      nodes[oldParent].right = newParent;
+    }
+    RefitFrom(oldParent);
+  }
+  return leaf;
+}
+
+// Pulling the leaf's sibling up into their parent's place
+void Bvh::Remove(uint32_t leaf) {
+  if (leaf == root) {
+    root = kNoNode;
+    FreeNode(leaf);
+    return;
+  }
+  uint32_t parent = parents[leaf];
+  uint32_t grandparent = parents[parent];
+  uint32_t sibling = nodes[parent].left == leaf ? nodes[parent].right
+                                                : nodes[parent].left;
+  parents[sibling] = grandparent;
+  if (grandparent == kNoNode) {
+    root = sibling;
+  } else {
+    if (nodes[grandparent].left == parent) {
+      nodes[grandparent].left = sibling;
+    } else {
+      nodes[grandparent].right = sibling;
+    }
+    RefitFrom(grandparent);
+  }
+  FreeNode(parent);
+  FreeNode(leaf);
+}
+
+void Bvh::Refit(uint32_t leaf, const Aabb& box) {
+  nodes[leaf].box = box;
+  RefitFrom(parents[leaf]);
+}
+
+void Bvh::SetItem(uint32_t leaf, uint32_t item) {
+  nodes[leaf].right = item;
+}
+
+void Bvh::Clear() {
+  nodes.clear();
+  parents.clear();
+  freeNodes.clear();
+  root = kNoNode;
+}
+
+uint32_t Bvh::NumNodes() const {
+  return static_cast<uint32_t>(nodes.size() - freeNodes.size());
+}
+
+// Outside if behind any plane by more than the box reaches toward it;
+// inside if in front of every plane by at least that much
+Bvh::Overlap FrustumVolume::Classify(const Bvh::Aabb& box) const {
+  glm::vec3 center = (box.min + box.max) * 0.5f;
+  glm::vec3 extent = (box.max - box.min) * 0.5f;
+  Bvh::Overlap overlap = Bvh::INSIDE;
+  for (int p = 0; p < 6; ++p) {
+    glm::vec3 normal = glm::vec3(planes[p]);
+    float dist = glm::dot(normal, center) + planes[p].w;
+    float reach = glm::dot(glm::abs(normal), extent);
+    if (dist + reach < 0.0f) {
+      return Bvh::OUTSIDE;
+    }
+    if (dist - reach < 0.0f) {
+      overlap = Bvh::PARTIAL;
+    }
+  }
+  return overlap;
+}
+
+RayVolume::RayVolume(glm::vec3 origin, glm::vec3 dir, float maxDist)
+    : origin(origin), invDir(1.0f / dir), maxDist(maxDist) {}
+
+// Slab test: the ray is inside the box between the last entry and the
+// first exit across the three pairs of planes
+Bvh::Overlap RayVolume::Classify(const Bvh::Aabb& box) const {
+  glm::vec3 t1 = (box.min - origin) * invDir;
+  glm::vec3 t2 = (box.max - origin) * invDir;
+  glm::vec3 tNear = glm::min(t1, t2);
+  glm::vec3 tFar = glm::max(t1, t2);
+  float entry = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+  float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDist));
+  return entry <= exit ? Bvh::PARTIAL : Bvh::OUTSIDE;
+}
+
+Bvh::Overlap BoxVolume::Classify(const Bvh::Aabb& other) const {
+  if (glm::any(glm::lessThan(other.max, box.min)) ||
+      glm::any(glm::greaterThan(other.min, box.max))) {
+    return Bvh::OUTSIDE;
+  }
+  if (glm::all(glm::greaterThanEqual(other.min, box.min)) &&
+      glm::all(glm::lessThanEqual(other.max, box.max))) {
+    return Bvh::INSIDE;
+  }
+  return Bvh::PARTIAL;
+}
@@ -0,0 +1,192 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The Bvh class is a bounding volume hierarchy over axis-aligned boxes, each
+// tagged with a caller's item number. Nodes live in one flat array and refer
+// to their children by index; a fresh build lays them out depth first, so a
+// node's first child sits right after it. Builds split by the surface area
+// heuristic (SAH), which puts the cut where the chance of a query visiting
+// each side, times the boxes on that side, is smallest. After a build, boxes
+// can be inserted and removed one at a time (an insert walks down picking
+// the sibling that grows the tree's total area least) and moved either by
+// refitting their ancestors, which is cheap, or by removing and inserting
+// again, which keeps the tree tighter. All queries go through Query, with a
+// volume that says how each node's box relates to it.
+#pragma once
+#ifndef BVH
+#define BVH
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Bvh {
+ public:
+  // Returned for nodes that don't exist
+  static const uint32_t kNoNode = ~0u;
+
+  // Axis-aligned box
+  struct Aabb {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+  };
+
+  // How a node's box relates to a query volume. Nodes fully inside have
+  // every leaf under them taken without testing further.
+  enum Overlap {
+    OUTSIDE,
+    PARTIAL,
+    INSIDE
+  };
+
+ private:
+  // A node's box and children. Leaves have no first child, and keep their
+  // item where the second child would be. 32 bytes, so two share a cache
+  // line.
+  struct Node {
+    Aabb box;
+    uint32_t left = kNoNode;
+    uint32_t right = 0;
+  };
+
+  std::vector<Node> nodes;
+
+  // Parent of each node, kept apart from nodes since queries never read it
+  std::vector<uint32_t> parents;
+
+  // Unused positions in nodes, reused before the array grows
+  std::vector<uint32_t> freeNodes;
+
+  uint32_t root = kNoNode;
+
+  // Nodes still to visit during a query. Kept between queries so they
+  // don't allocate once it has grown to the tree's depth, which is why one
+  // tree can't run two queries at once.
+  mutable std::vector<uint32_t> queryStack;
+
+  // Gets an unused node, reusing a freed one if there is one
+  uint32_t AllocNode();
+
+  // Returns a node to the free list
+  void FreeNode(uint32_t node);
+
+  // Recomputes boxes from node up to the root
+  void RefitFrom(uint32_t node);
+
+  // Builds a subtree over positions [begin, end) of the build order,
+  // returning its root
+  uint32_t BuildRange(const std::vector<Aabb>& boxes,
+                      const std::vector<glm::vec3>& centers,
+                      const uint32_t* items, uint32_t* order,
+                      uint32_t begin, uint32_t end, uint32_t* leaves);
+
+ public:
+  // Half the surface area of a box; SAH only compares areas, so the
+  // constant factor doesn't matter
+  static float Area(const Aabb& box);
+
+  // Smallest box holding both
+  static Aabb Union(const Aabb& a, const Aabb& b);
+
+  // Replaces the tree with one built over count boxes, each tagged with the
+  // matching item. leaves[i] is set to the leaf holding boxes[i].
+  void Build(const Aabb* boxes, const uint32_t* items, uint32_t count,
+             uint32_t* leaves);
+
+  // Adds one box, returning its leaf
+  uint32_t Insert(const Aabb& box, uint32_t item);
+
+  // Removes a leaf from the tree
+  void Remove(uint32_t leaf);
+
+  // Gives a leaf a new box and refits its ancestors around it. Fast, but
+  // boxes that move far leave loose nodes behind; Remove and Insert again
+  // for those.
+  void Refit(uint32_t leaf, const Aabb& box);
+
+  // Changes the item a leaf reports, for callers whose item numbers move
+  void SetItem(uint32_t leaf, uint32_t item);
+
+  // Empties the tree
+  void Clear();
+
+  // Number of leaves plus internal nodes
+  uint32_t NumNodes() const;
+
+  // Appends the item of every leaf whose box the volume overlaps. Volume
+  // needs an Overlap Classify(const Aabb&) const. Not safe to call from
+  // more than one thread at a time.
+  template <typename Volume>
+  void Query(const Volume& volume, std::vector<uint32_t>* items) const;
+};
+
+// Query volumes
+
+// View frustum, as six inward facing planes from Camera::FrustumPlanes
+struct FrustumVolume {
+  const glm::vec4* planes = nullptr;
+  Bvh::Overlap Classify(const Bvh::Aabb& box) const;
+};
+
+// Ray segment from origin along dir, out to maxDist times dir's length
+struct RayVolume {
+  glm::vec3 origin = glm::vec3(0.0f);
+  glm::vec3 invDir = glm::vec3(0.0f);  // 1 / dir, per component
+  float maxDist = 0.0f;
+  RayVolume(glm::vec3 origin, glm::vec3 dir, float maxDist);
+  Bvh::Overlap Classify(const Bvh::Aabb& box) const;
+};
+
+// Another box
+struct BoxVolume {
+  Bvh::Aabb box;
+  Bvh::Overlap Classify(const Bvh::Aabb& other) const;
+};
+
+// Walking down from the root with an explicit stack, skipping subtrees the
+// volume misses and taking whole subtrees it contains
+template <typename Volume>
+void Bvh::Query(const Volume& volume, std::vector<uint32_t>* items) const {
+  if (root == kNoNode) {
+    return;
+  }
+  std::vector<uint32_t>& stack = queryStack;
+  stack.clear();
+  stack.push_back(root);
+  while (!stack.empty()) {
+    uint32_t nodeIdx = stack.back();
+    stack.pop_back();
+    const Node& node = nodes[nodeIdx];
+    Overlap overlap = volume.Classify(node.box);
+    if (overlap == OUTSIDE) {
+      continue;
+    }
+    if (node.left == kNoNode) {
+      items->push_back(node.right);
+      continue;
+    }
+    if (overlap == PARTIAL) {
+      stack.push_back(node.right);
+      stack.push_back(node.left);
+      continue;
+    }
+
+    // Whole subtree is in, so just collect its leaves
+    size_t base = stack.size();
+    stack.push_back(nodeIdx);
+    while (stack.size() > base) {
+      const Node& inner = nodes[stack.back()];
+      stack.pop_back();
+      if (inner.left == kNoNode) {
+        items->push_back(inner.right);
+      } else {
+        stack.push_back(inner.right);
+        stack.push_back(inner.left);
+      }
+    }
+  }
+}
+#endif
@@ -12,18 +12,17 @@
 #include "Camera.h"
 #include "Shader.h"
 
-Camera::Camera(glm::vec3 pos, glm::vec3 tar, GLfloat width, GLfloat height) {
-  // id of buffer for camera data
-  camDataUBO = 0;
+#include <glm/gtc/matrix_access.hpp>
 
+Camera::Camera(glm::vec3 pos, glm::vec3 tar, GLfloat width, GLfloat height) {
   // Time variables
   time = static_cast<float>(glfwGetTime());  // Last time value
   deltaTime = 0;                             // Time since last frame
   projSwTime = 0.0f;                         // Last projection switch time.
 
   //  Camera Booleans
-  firstLook = true;   // (Tries to) prevent weirdness on first move.
   ortho = false;      // Determines whether to load ortho or perspective proj.
+  viewStale = false;  // View matrix is built below
 
   //  Camera Movement Speed Variables
   minSpeed = 2.50f;
@@ -34,17 +33,13 @@ Camera::Camera(glm::vec3 pos, glm::vec3 tar, GLfloat width, GLfloat height) {
   lookSens = 0.1f;     //  How much mouse movement affects view movement
   yaw = -90.0f;        //  Default yaw angle, negative due to convention
   pitch = 0.0f;        //  Default pitch angle
-  lastX = width / 2;   // Default coordinates: center of screen
-  lastY = height / 2;  // Default coordinates: center of screen
 
 
   //  Camera Vectors
-  camVecs = new glm::vec3[4]{
-    glm::vec3(0.0f, 1.0f, 0.0f),   // RIGHT
-    glm::vec3(0.0f, 0.0f, -1.0f),  // FRONT
-    glm::vec3(0.0f, 1.0f, 0.0f),   // UP
-    pos                            // POSITION
-  };
+  camVecs[RIGHT] = glm::vec3(0.0f, 1.0f, 0.0f);
+  camVecs[FRONT] = glm::vec3(0.0f, 0.0f, -1.0f);
+  camVecs[UP] = glm::vec3(0.0f, 1.0f, 0.0f);
+  camVecs[POSITION] = pos;
 
   // Calculating view matrix
   view = glm::lookAt(camVecs[POSITION],
@@ -53,90 +48,70 @@ Camera::Camera(glm::vec3 pos, glm::vec3 tar, GLfloat width, GLfloat height) {
 
   // Calculating perspective and orthographig projections
   float aspectRatio = width / height;
-  perspProj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 150.0f);
-  orthoProj = glm::ortho(-30.00f, 30.00f, -20.00f, 20.00f, 0.1f, 100.0f);
+  viewHeight = height;
+  fovY = glm::radians(45.0f);
+  nearZ = 0.1f;
+  perspFarZ = 150.0f;
+  orthoFarZ = 100.0f;
+  perspProj = glm::perspective(fovY, aspectRatio, nearZ, perspFarZ);
+  orthoProj = glm::ortho(-30.00f, 30.00f, -20.00f, 20.00f, nearZ, orthoFarZ);
 }
 
-// Recalculates and reloads view matrix into camera data buffer
+// Recalculates view matrix. It reaches the shaders with the rest of the
+// frame's uniforms, when the model manager writes them to its uniform ring.
 void Camera::updateViewMat() {
-  // Recalculating new view matrix
   view = glm::lookAt(camVecs[POSITION],
                      camVecs[POSITION] + camVecs[FRONT],
                      camVecs[UP]);
-
-  // Bind UBO for camera data
-  glBindBuffer(GL_UNIFORM_BUFFER, camDataUBO);
-
-  // Load view matrix (64 bytes) into buffer, starting at byte 0.
-  glBufferSubData(GL_UNIFORM_BUFFER, 0, 64, glm::value_ptr(view));
-
-  // Unbind camera data ubo.
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
-// Generates buffer, binds buffers and uniform blocks to a ubo, and loads
-// initial camera data
+// Binds both shaders' camera data blocks to the camera's binding point.
+// The model manager binds each frame's camera data to that point.
 void Camera::BindCamData(GLFWwindow* window) {
   void** objArr = reinterpret_cast<void**>(glfwGetWindowUserPointer(window));
   Shader* imgMatShader = reinterpret_cast<Shader*>(objArr[2]);
   Shader* propMatShader = reinterpret_cast<Shader*>(objArr[3]);
 
-  // Get block indices for both shaders' camera data uniform blocks
-  GLuint iCamDataIndex = glGetUniformBlockIndex(imgMatShader->id, "camData");
-  GLuint pCamDataIndex = glGetUniformBlockIndex(propMatShader->id, "camData");
-
-  // Binding uniform blocks to index 2 (0 and 1 are taken by the light UBOs)
-  glUniformBlockBinding(imgMatShader->id, iCamDataIndex, 2);
-  glUniformBlockBinding(propMatShader->id, pCamDataIndex, 2);
-
-  // Generating buffer for UBO and binding
-  glGenBuffers(1, &camDataUBO);
-  glBindBuffer(GL_UNIFORM_BUFFER, camDataUBO);
-
-  // Create buffer of 144 bytes, filled with NULL
-  // 16 floats (view mat) +
-  // 16 floats (proj mat) +
-  //  4 floats (cam pos) = 36 * 4 (bytes/float) 144 bytes
-  glBufferData(GL_UNIFORM_BUFFER, 144, NULL, GL_STATIC_DRAW);
-
-  // Load view matrix data (64 bytes) into buffer starting at byte 0
-  glBufferSubData(GL_UNIFORM_BUFFER, 0, 64, glm::value_ptr(view));
-
-  // Loading projection matrix depending on whether ortho is on or not.
-  // Loads projection matrix data (64 bytes) into buffer starting at byte 64
-  if (ortho) {
-    glBufferSubData(GL_UNIFORM_BUFFER, 64, 64, glm::value_ptr(orthoProj));
-  } else {
-    glBufferSubData(GL_UNIFORM_BUFFER, 64, 64, glm::value_ptr(perspProj));
-  }
-
-  // Get pointer to camera position, pack to vec4, and
-  // Load camera position into buffer (16 bytes) into buffer starting at 128.
-  const float* camPosPtr = glm::value_ptr(glm::vec4(camVecs[POSITION], 0.0f));
-  glBufferSubData(GL_UNIFORM_BUFFER, 128, 16, camPosPtr);
-
-  // Unbind buffer
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  // Binding both shaders' camera data uniform blocks
+  imgMatShader->BindBlock(HashUniform("camData"), kCamDataBinding);
+  propMatShader->BindBlock(HashUniform("camData"), kCamDataBinding);
+}
 
-  // Bind entire UBO to binding point 2.
-  glBindBufferBase(GL_UNIFORM_BUFFER, 2, camDataUBO);
+// Packing matrices and position in the camera data block's std140 layout
+Camera::CamData Camera::GetCamData() const {
+  CamData camData;
+  camData.view = view;
+  camData.proj = ortho ? orthoProj : perspProj;
+  camData.camPos = glm::vec4(camVecs[POSITION], 0.0f);
+  return camData;
 }
 
-// Updates camera view direction when called.
-void Camera::updateDir(float x, float y) {
-  // Check if camera has moved before, exit if so (preventing jumping)
-  if (firstLook) {
-    firstLook = false;
-    return;
+// Pulling planes out of the rows of the view-projection matrix. A point
+// is inside when -w <= x, y, z <= w in clip space, and each of those six
+// inequalities is a plane equation in world space.
+void Camera::FrustumPlanes(glm::vec4 planes[6]) const {
+  glm::mat4 viewProj = (ortho ? orthoProj : perspProj) * view;
+  glm::vec4 rowX = glm::row(viewProj, 0);
+  glm::vec4 rowY = glm::row(viewProj, 1);
+  glm::vec4 rowZ = glm::row(viewProj, 2);
+  glm::vec4 rowW = glm::row(viewProj, 3);
+  planes[0] = rowW + rowX;
+  planes[1] = rowW - rowX;
+  planes[2] = rowW + rowY;
+  planes[3] = rowW - rowY;
+  planes[4] = rowW + rowZ;
+  planes[5] = rowW - rowZ;
+  for (int i = 0; i < 6; ++i) {
+    planes[i] /= glm::length(glm::vec3(planes[i]));
   }
+}
 
+// Updates camera view direction when called. Offsets are in screen
+// coordinates, so moving the mouse down is a positive yOffset.
+void Camera::updateDir(float xOffset, float yOffset) {
   // Updating yaw and pitch based on change in cursor position
-  yaw += lookSens * (x - lastX);
-  pitch += lookSens * (lastY - y);
-
-  // Store last x and y.
-  lastX = x;
-  lastY = y;
+  yaw += lookSens * xOffset;
+  pitch -= lookSens * yOffset;
 
   // Limit pitch to <= straight up and >= straight down
   if (pitch > 89.0f) {
@@ -158,8 +133,8 @@ void Camera::updateDir(float x, float y) {
   camVecs[RIGHT] = glm::normalize(rightVec);
   camVecs[UP] = glm::normalize(glm::cross(camVecs[FRONT], camVecs[RIGHT]));
 
-  // Update view matrix since view vectors changed
-  updateViewMat();
+  // View matrix is rebuilt by resolveView, since view vectors changed
+  viewStale = true;
 }
 
 // Updates camera position when W/A/S/D/Q/E input is detected
@@ -180,19 +155,17 @@ void Camera::updatePos(unsigned int moveBits) {
     ((32 & moveBits) / 32) * -moveDist * globalY;
 
   camVecs[POSITION] += offset;
-  // Bind camera data buffer
-  glBindBuffer(GL_UNIFORM_BUFFER, camDataUBO);
 
-  // Get pointer to camera position, pack to a vec4, and update
-  // the camera view direction, loading vec4 (16 bytes) starting at byte 128.
-  const float* camPosPtr = glm::value_ptr(glm::vec4(camVecs[POSITION], 0.0f));
-  glBufferSubData(GL_UNIFORM_BUFFER, 128, 16, camPosPtr);
-
-  // Unbind buffer
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  // View matrix is rebuilt by resolveView, since camera position changed
+  viewStale = true;
+}
 
-  // Update view matrix since camera position changed
-  updateViewMat();
+// Rebuilds the view matrix once for all of a step's turning and moving
+void Camera::resolveView() {
+  if (viewStale) {
+    updateViewMat();
+    viewStale = false;
+  }
 }
 
 
@@ -208,6 +181,13 @@ void Camera::updateTime() {
   time = curr_time;
 }
 
+// Advances camera's time by a fixed step, so movement doesn't depend on
+// when the step happens to run
+void Camera::updateTime(float step) {
+  deltaTime = step;
+  time += step;
+}
+
 
 // Adjusts camera speed when scroll input is detected
 void Camera::adjustSpeed(float xOffset, float yOffset) {
@@ -223,24 +203,30 @@ void Camera::adjustSpeed(float xOffset, float yOffset) {
 void Camera::projSwitch() {
   // Time limit here to fix flickering (from reading multiple keystrokes/frame)
   if (static_cast<float>(glfwGetTime()) - projSwTime > 0.05) {
-    // Toggle ortho boolean
+    // Toggle ortho boolean. GetCamData picks the matching projection.
     ortho = !ortho;
-
-    // Bind cam data buffer
-    glBindBuffer(GL_UNIFORM_BUFFER, camDataUBO);
-
-    // Check new ortho value and load appropriate projection matrix (64 bytes)
-    // starting at position 64.
-    if (ortho) {
-      glBufferSubData(GL_UNIFORM_BUFFER, 64, 64, glm::value_ptr(orthoProj));
-    } else {
-      glBufferSubData(GL_UNIFORM_BUFFER, 64, 64, glm::value_ptr(perspProj));
-    }
-    // Unbind buffer
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
   }
 
   // Reset time since last projection switch
   projSwTime = static_cast<float>(glfwGetTime());
 }
 
+// Returns on-screen pixels per world unit at a point
+float Camera::PixelsPerUnit(glm::vec3 worldPos) {
+  // Orthographic: the view is 40 units tall no matter the distance
+  if (ortho) {
+    return viewHeight / 40.0f;
+  }
+
+  // Perspective: the view is 2 * tan(fov / 2) * distance units tall
+  float dist = glm::length(worldPos - camVecs[POSITION]);
+  dist = glm::max(dist, 0.1f);
+  return viewHeight / (2.0f * glm::tan(fovY / 2.0f) * dist);
+}
+
+// Calculates depth of a point between the near and far planes
+float Camera::DepthFraction(glm::vec3 worldPos) {
+  float depth = glm::dot(worldPos - camVecs[POSITION], camVecs[FRONT]);
+  float farZ = ortho ? orthoFarZ : perspFarZ;
+  return glm::clamp((depth - nearZ) / (farZ - nearZ), 0.0f, 1.0f);
+}
@@ -28,17 +28,14 @@ class Camera {
       POSITION = 3
     };
 
-    // Buffer IDs
-    GLuint camDataUBO;  // Camera data buffer ID
-
     // Time variables
     float time;               // last time value
     float deltaTime;          // change in time since last frame
     float projSwTime;  // time since last projection switch
 
     // Camera Booleans
-    bool firstLook;  // tracks first move of mouse
-    bool ortho;      // determines which perspective is loaded
+    bool ortho;       // determines which perspective is loaded
+    bool viewStale;   // vectors changed since the view matrix was built
 
     // Camera Movement Speed Variables
     float minSpeed;
@@ -49,11 +46,20 @@ class Camera {
     float lookSens;  // Look sensitivity for mouse movement
     float yaw;       // Left/Right look angle
     float pitch;     // Up/Down look angle
-    float lastX;     // Last X coordinate of mouse cursor
-    float lastY;     // Last Y coordinate of mouse cursor
 
-    // Camera Vectors
-    glm::vec3* camVecs;  // RIGHT, FRONT, UP, and POSITION vectors.
+    // Camera Vectors. Held by value so copies of the camera, such as the
+    // simulation's published snapshots, don't share them.
+    glm::vec3 camVecs[4];  // RIGHT, FRONT, UP, and POSITION vectors.
+
+    // Viewport height in pixels and vertical field of view in radians,
+    // for working out how big things look on screen
+    float viewHeight;
+    float fovY;
+
+    // Near plane, and far planes of each projection
+    float nearZ;
+    float perspFarZ;
+    float orthoFarZ;
 
     // Camera Matrices
     glm::mat4 view;       // View matrix of camera
@@ -61,10 +67,21 @@ class Camera {
     glm::mat4 orthoProj;  // orthographig projection
 
 
-    // Updates view matrix when vectors change
+    // Rebuilds view matrix from the vectors
     void updateViewMat();
 
  public:
+    // Uniform buffer binding point of the camera data block
+    // (0 and 1 are taken by the light UBOs)
+    static const GLuint kCamDataBinding = 2;
+
+    // Camera data block, laid out to match camData in the shaders (std140)
+    struct CamData {
+      glm::mat4 view;    // view matrix
+      glm::mat4 proj;    // active projection matrix
+      glm::vec4 camPos;  // camera position, w unused
+    };
+
     // Camera constructor
     Camera(glm::vec3 pos, glm::vec3 tar, GLfloat width, GLfloat height);
 
@@ -78,23 +95,47 @@ class Camera {
       POS_Y = 32,
     };
 
-    // Generates buffers, binds UBO to shader and buffer binding points,
-    // Loads intial camera data.
+    // Binds the shaders' camera data blocks to kCamDataBinding
     void BindCamData(GLFWwindow* window);
 
-    // Updates camera look direction on mouse movement
+    // Returns this frame's camera data block, for the uniform ring
+    CamData GetCamData() const;
+
+    // Fills planes with the view frustum's left, right, bottom, top, near,
+    // and far planes in world space, in whichever projection is active.
+    // Each is (normal, distance) with the normal pointing inward and unit
+    // length, so dot(normal, point) + distance is a signed distance.
+    void FrustumPlanes(glm::vec4 planes[6]) const;
+
+    // Turns camera look direction by how far the mouse moved
     void updateDir(float xOffset, float yOffset);
 
     // Update camera position on W/A/S/D/Q/E input
     void updatePos(unsigned int moveBits);
 
+    // Rebuilds the view matrix if turning or moving changed it. Called once
+    // after each step's input is applied, so the matrix is built once no
+    // matter how much input arrived.
+    void resolveView();
+
     // Updates camera time
     void updateTime();
 
+    // Advances camera time by a fixed step, for the simulation loop
+    void updateTime(float step);
+
     // Adjusts camera speed when scroll wheel is moved
     void adjustSpeed(float xOffset, float yOffset);
 
     // Switches which projection matrix is loaded by the camera
     void projSwitch();
+
+    // Returns how many pixels tall one world unit appears at a point, in
+    // whichever projection is active
+    float PixelsPerUnit(glm::vec3 worldPos);
+
+    // Returns how far a point is along the view direction, as a fraction of
+    // the distance from the near plane to the far plane (0 - 1, clamped)
+    float DepthFraction(glm::vec3 worldPos);
 };
 #endif
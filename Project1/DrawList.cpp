@@ -0,0 +1,56 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The DrawList class holds draw packets recorded off the GL thread. A
+// packet is one instanced draw call reduced to plain GL names and offsets:
+// program, textures, vertex array, index range, and where its uniform
+// blocks were packed in the uniform ring. Worker threads each record a list
+// for their share of the scene, with no GL calls and nothing shared between
+// them; the GL thread then merges the lists by sort key and replays the
+// packets, doing nothing but binds and draws.
+#include "DrawList.h"
+
+void DrawList::Clear() {
+  packets.clear();
+}
+
+void DrawList::Record(const Packet& packet) {
+  packets.push_back(packet);
+}
+
+const std::vector<DrawList::Packet>& DrawList::Packets() const {
+  return packets;
+}
+
+// Taking the lowest key among the lists' next packets each step. There is
+// one list per worker thread, so scanning their heads beats a heap.
+void DrawList::Merge(const std::vector<const DrawList*>& lists,
+                     std::vector<size_t>* heads,
+                     std::vector<const Packet*>* order) {
+  order->clear();
+  heads->assign(lists.size(), 0);
+  size_t total = 0;
+  std::vector<const DrawList*>::const_iterator listIter = lists.begin();
+  for (; listIter != lists.end(); ++listIter) {
+    total += (*listIter)->packets.size();
+  }
+  order->reserve(total);
+
+  while (order->size() < total) {
+    size_t best = lists.size();
+    for (size_t i = 0; i < lists.size(); ++i) {
+      if ((*heads)[i] == lists[i]->packets.size()) {
+        continue;
+      }
+      if (best == lists.size() ||
+          lists[i]->packets[(*heads)[i]].key <
+            lists[best]->packets[(*heads)[best]].key) {
+        best = i;
+      }
+    }
+    order->push_back(&lists[best]->packets[(*heads)[best]]);
+    ++(*heads)[best];
+  }
+}
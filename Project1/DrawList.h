@@ -0,0 +1,62 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The DrawList class holds draw packets recorded off the GL thread. A
+// packet is one instanced draw call reduced to plain GL names and offsets:
+// program, textures, vertex array, index range, and where its uniform
+// blocks were packed in the uniform ring. Worker threads each record a list
+// for their share of the scene, with no GL calls and nothing shared between
+// them; the GL thread then merges the lists by sort key and replays the
+// packets, doing nothing but binds and draws.
+#pragma once
+#ifndef DRAW_LIST
+#define DRAW_LIST
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+class DrawList {
+ public:
+  // One instanced draw call, ready to issue
+  struct Packet {
+    uint64_t key = 0;        // render queue key of the first instance
+    GLuint program = 0;
+    GLuint vertexArray = 0;
+    bool textured = false;   // binds both texture units, even to 0
+    GLuint diffTex = 0;      // 0 when untextured or its image failed
+    GLuint specTex = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    GLsizei numIndices = 0;
+    GLint baseVertex = 0;
+    GLsizei numInstances = 0;
+    GLintptr indexOffset = 0;  // bytes into the element array
+    GLintptr material = 0;     // uniform ring offsets
+    GLintptr objects = 0;
+  };
+
+ private:
+  std::vector<Packet> packets;
+
+ public:
+  // Empties the list, keeping its memory for the next frame
+  void Clear();
+
+  // Appends a packet. Packets should be recorded in key order for Merge.
+  void Record(const Packet& packet);
+
+  // Recorded packets, in recording order
+  const std::vector<Packet>& Packets() const;
+
+  // Interleaves the packets of lists that are each in key order into one
+  // key ordered sequence, so state sorting holds across the lists. heads is
+  // scratch space for the read position in each list; keep it between
+  // frames, along with order, so merging doesn't allocate.
+  static void Merge(const std::vector<const DrawList*>& lists,
+                    std::vector<size_t>* heads,
+                    std::vector<const Packet*>* order);
+};
+#endif
@@ -0,0 +1,98 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Frustum culling tests world space bounding boxes against the six planes of
+// the camera's view frustum. Boxes come in structure-of-arrays form (one
+// array per center and extent component) so four of them can be loaded into
+// SSE registers and tested against a plane at once. A box is culled only if
+// it lies wholly behind some plane; boxes near a frustum corner can pass
+// without being visible, which costs a draw but never drops a visible one.
+// Builds without SSE test one box at a time with the same math.
+#include "FrustumCull.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+  // A box is outside a plane if its center is further behind it than the
+  // box reaches: the reach is the extent projected onto the plane normal.
+  bool BoxVisible(const glm::vec4 planes[6], const BoxArrays& boxes,
+                  uint32_t i) {
+    for (int p = 0; p < 6; ++p) {
+      const glm::vec4& plane = planes[p];
+      float dist = plane.x * boxes.centerX[i] + plane.y * boxes.centerY[i] +
+                   plane.z * boxes.centerZ[i] + plane.w;
+      float reach = std::fabs(plane.x) * boxes.extentX[i] +
+                    std::fabs(plane.y) * boxes.extentY[i] +
+                    std::fabs(plane.z) * boxes.extentZ[i];
+      if (dist + reach < 0.0f) {
+        return false;
+      }
+    }
+    return true;
+  }
+}  // namespace
+
+// Testing four boxes per step, then finishing the remainder one at a time
+uint32_t CullBoxes(const glm::vec4 planes[6], const BoxArrays& boxes,
+                   uint32_t count, uint8_t* visible) {
+  uint32_t numVisible = 0;
+  uint32_t i = 0;
+
+#ifdef FRUSTUM_CULL_SSE
+  // Splatting each plane's components, and their absolute values, once
+  __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+  __m128 absX[6], absY[6], absZ[6];
+  for (int p = 0; p < 6; ++p) {
+    planeX[p] = _mm_set1_ps(planes[p].x);
+    planeY[p] = _mm_set1_ps(planes[p].y);
+    planeZ[p] = _mm_set1_ps(planes[p].z);
+    planeW[p] = _mm_set1_ps(planes[p].w);
+    absX[p] = _mm_set1_ps(std::fabs(planes[p].x));
+    absY[p] = _mm_set1_ps(std::fabs(planes[p].y));
+    absZ[p] = _mm_set1_ps(std::fabs(planes[p].z));
+  }
+
+  __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= count; i += 4) {
+    __m128 cx = _mm_loadu_ps(boxes.centerX + i);
+    __m128 cy = _mm_loadu_ps(boxes.centerY + i);
+    __m128 cz = _mm_loadu_ps(boxes.centerZ + i);
+    __m128 ex = _mm_loadu_ps(boxes.extentX + i);
+    __m128 ey = _mm_loadu_ps(boxes.extentY + i);
+    __m128 ez = _mm_loadu_ps(boxes.extentZ + i);
+
+    // Lanes stay all ones while their box is inside every plane so far
+    __m128 inside = _mm_cmpeq_ps(zero, zero);
+    for (int p = 0; p < 6; ++p) {
+      __m128 dist = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+        _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+      __m128 reach = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)),
+        _mm_mul_ps(absZ[p], ez));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, reach), zero));
+    }
+
+    int mask = _mm_movemask_ps(inside);
+    for (int lane = 0; lane < 4; ++lane) {
+      uint8_t laneVisible = (mask >> lane) & 1;
+      visible[i + lane] = laneVisible;
+      numVisible += laneVisible;
+    }
+  }
+#endif
+
+  for (; i < count; ++i) {
+    visible[i] = BoxVisible(planes, boxes, i) ? 1 : 0;
+    numVisible += visible[i];
+  }
+  return numVisible;
+}
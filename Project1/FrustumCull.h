@@ -0,0 +1,43 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Frustum culling tests world space bounding boxes against the six planes of
+// the camera's view frustum. Boxes come in structure-of-arrays form (one
+// array per center and extent component) so four of them can be loaded into
+// SSE registers and tested against a plane at once. A box is culled only if
+// it lies wholly behind some plane; boxes near a frustum corner can pass
+// without being visible, which costs a draw but never drops a visible one.
+// Builds without SSE test one box at a time with the same math.
+#pragma once
+#ifndef FRUSTUM_CULL
+#define FRUSTUM_CULL
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// World space boxes, as center and half extent along each axis. Each
+// pointer is an array of count floats.
+struct BoxArrays {
+  const float* centerX = nullptr;
+  const float* centerY = nullptr;
+  const float* centerZ = nullptr;
+  const float* extentX = nullptr;
+  const float* extentY = nullptr;
+  const float* extentZ = nullptr;
+};
+
+// Boxes tested and boxes that passed, for reporting
+struct CullStats {
+  uint32_t tested = 0;
+  uint32_t visible = 0;
+};
+
+// Sets visible[i] to 1 for each box at least partly inside all six planes,
+// and 0 for the rest. Planes are as from Camera::FrustumPlanes. Returns the
+// number of visible boxes.
+uint32_t CullBoxes(const glm::vec4 planes[6], const BoxArrays& boxes,
+                   uint32_t count, uint8_t* visible);
+#endif
@@ -0,0 +1,167 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The GLStateCache class sits in front of the GL calls that bind things:
+// programs, vertex arrays, textures, buffers, and uniform buffer ranges.
+// It remembers what each call last bound and drops calls that would bind
+// the same thing again, since the driver does real work even for those.
+// Every call issued or dropped is counted per frame, so the effect of
+// sorting and batching draws can be measured. Cached state is only right
+// if every bind goes through the cache; code that calls GL directly should
+// be followed by Invalidate.
+#include "GLStateCache.h"
+
+namespace {
+  // Stands in for any object name, so the next bind never matches it
+  const GLuint kUnknown = ~0u;
+}  // namespace
+
+GLStateCache::GLStateCache() {
+  Invalidate();
+}
+
+int GLStateCache::TargetSlot(GLenum target) {
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      return ARRAY_TARGET;
+    case GL_COPY_READ_BUFFER:
+      return COPY_READ_TARGET;
+    case GL_COPY_WRITE_BUFFER:
+      return COPY_WRITE_TARGET;
+    case GL_UNIFORM_BUFFER:
+      return UNIFORM_TARGET;
+    default:
+      return NUM_TARGETS;
+  }
+}
+
+void GLStateCache::ActiveTexture(GLuint unit) {
+  if (unit == activeUnit) {
+    ++frame.elided;
+    return;
+  }
+  glActiveTexture(GL_TEXTURE0 + unit);
+  activeUnit = unit;
+  ++frame.issued;
+}
+
+void GLStateCache::UseProgram(GLuint newProgram) {
+  if (newProgram == program) {
+    ++frame.elided;
+    return;
+  }
+  glUseProgram(newProgram);
+  program = newProgram;
+  ++frame.issued;
+  ++frame.programBinds;
+}
+
+void GLStateCache::BindVertexArray(GLuint newVertexArray) {
+  if (newVertexArray == vertexArray) {
+    ++frame.elided;
+    return;
+  }
+  glBindVertexArray(newVertexArray);
+  vertexArray = newVertexArray;
+  ++frame.issued;
+  ++frame.vertexArrayBinds;
+}
+
+// Switching units only if the texture on the unit has to change
+void GLStateCache::BindTexture(GLuint unit, GLuint texture) {
+  if (unit < kMaxTextureUnits && textures[unit] == texture) {
+    ++frame.elided;
+    return;
+  }
+  ActiveTexture(unit);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  if (unit < kMaxTextureUnits) {
+    textures[unit] = texture;
+  }
+  ++frame.issued;
+  ++frame.textureBinds;
+}
+
+void GLStateCache::BindBuffer(GLenum target, GLuint buffer) {
+  int slot = TargetSlot(target);
+  if (slot != NUM_TARGETS && buffers[slot] == buffer) {
+    ++frame.elided;
+    return;
+  }
+  glBindBuffer(target, buffer);
+  if (slot != NUM_TARGETS) {
+    buffers[slot] = buffer;
+  }
+  ++frame.issued;
+}
+
+// Binding a range also binds the buffer to the generic uniform target
+void GLStateCache::BindUniformRange(GLuint binding, GLuint buffer,
+                                    GLintptr offset, GLsizeiptr size) {
+  if (binding < kMaxUniformBindings) {
+    const Range& bound = uniformRanges[binding];
+    if (bound.buffer == buffer && bound.offset == offset &&
+        bound.size == size) {
+      ++frame.elided;
+      return;
+    }
+  }
+  glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+  if (binding < kMaxUniformBindings) {
+    uniformRanges[binding].buffer = buffer;
+    uniformRanges[binding].offset = offset;
+    uniformRanges[binding].size = size;
+  }
+  buffers[UNIFORM_TARGET] = buffer;
+  ++frame.issued;
+  ++frame.uniformCalls;
+}
+
+void GLStateCache::ForgetBuffer(GLuint buffer) {
+  for (int slot = 0; slot < NUM_TARGETS; ++slot) {
+    if (buffers[slot] == buffer) {
+      buffers[slot] = kUnknown;
+    }
+  }
+  for (GLuint binding = 0; binding < kMaxUniformBindings; ++binding) {
+    if (uniformRanges[binding].buffer == buffer) {
+      uniformRanges[binding].buffer = kUnknown;
+    }
+  }
+}
+
+void GLStateCache::ForgetTexture(GLuint texture) {
+  for (GLuint unit = 0; unit < kMaxTextureUnits; ++unit) {
+    if (textures[unit] == texture) {
+      textures[unit] = kUnknown;
+    }
+  }
+}
+
+void GLStateCache::ForgetVertexArray(GLuint oldVertexArray) {
+  if (vertexArray == oldVertexArray) {
+    vertexArray = kUnknown;
+  }
+}
+
+void GLStateCache::Invalidate() {
+  program = kUnknown;
+  vertexArray = kUnknown;
+  activeUnit = kUnknown;
+  for (GLuint unit = 0; unit < kMaxTextureUnits; ++unit) {
+    textures[unit] = kUnknown;
+  }
+  for (int slot = 0; slot < NUM_TARGETS; ++slot) {
+    buffers[slot] = kUnknown;
+  }
+  for (GLuint binding = 0; binding < kMaxUniformBindings; ++binding) {
+    uniformRanges[binding].buffer = kUnknown;
+  }
+}
+
+void GLStateCache::BeginFrame() {
+  lastFrame = frame;
+  frame = Counters();
+}
@@ -0,0 +1,120 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The GLStateCache class sits in front of the GL calls that bind things:
+// programs, vertex arrays, textures, buffers, and uniform buffer ranges.
+// It remembers what each call last bound and drops calls that would bind
+// the same thing again, since the driver does real work even for those.
+// Every call issued or dropped is counted per frame, along with draws and
+// bytes uploaded, so the effect of sorting and batching draws can be
+// measured. Cached state is only right
+// if every bind goes through the cache; code that calls GL directly should
+// be followed by Invalidate.
+#pragma once
+#ifndef GL_STATE_CACHE
+#define GL_STATE_CACHE
+
+#include <GL/glew.h>
+
+#include <cstdint>
+
+class GLStateCache {
+ public:
+  // Texture units and uniform buffer binding points that are cached.
+  // Higher ones are passed straight through.
+  static const GLuint kMaxTextureUnits = 16;
+  static const GLuint kMaxUniformBindings = 16;
+
+  // Calls counted over a frame
+  struct Counters {
+    uint32_t issued = 0;            // binding calls that reached GL
+    uint32_t elided = 0;            // binding calls dropped as redundant
+    uint32_t draws = 0;             // draw calls
+    uint64_t triangles = 0;         // triangles those draws submitted
+    uint32_t programBinds = 0;      // issued glUseProgram calls
+    uint32_t vertexArrayBinds = 0;  // issued glBindVertexArray calls
+    uint32_t textureBinds = 0;      // issued glBindTexture calls
+    uint32_t uniformCalls = 0;      // glUniform* and uniform range binds
+    uint64_t bufferBytes = 0;       // bytes written to buffers
+    uint64_t textureBytes = 0;      // bytes of texture images uploaded
+  };
+
+ private:
+  // Buffer targets whose bindings are cached. The element array binding
+  // belongs to the bound vertex array, so it isn't one of them.
+  enum BufferTarget {
+    ARRAY_TARGET,
+    COPY_READ_TARGET,
+    COPY_WRITE_TARGET,
+    UNIFORM_TARGET,
+    NUM_TARGETS
+  };
+
+  // A uniform buffer binding point's bound range
+  struct Range {
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+  };
+
+  // Bound objects, or kUnknown where the cache can't be sure
+  GLuint program = 0;
+  GLuint vertexArray = 0;
+  GLuint activeUnit = 0;
+  GLuint textures[kMaxTextureUnits] = {};
+  GLuint buffers[NUM_TARGETS] = {};
+  Range uniformRanges[kMaxUniformBindings];
+
+  // Counts for the frame in progress, and for the last finished one
+  Counters frame;
+  Counters lastFrame;
+
+  // Cached slot of a buffer target, or NUM_TARGETS if it isn't cached
+  static int TargetSlot(GLenum target);
+
+  // Makes a texture unit active, if it isn't already
+  void ActiveTexture(GLuint unit);
+
+ public:
+  // Bound state is unknown to start with
+  GLStateCache();
+
+  // Binding calls. Each one reaches GL only if it would change something.
+  void UseProgram(GLuint newProgram);
+  void BindVertexArray(GLuint newVertexArray);
+  void BindTexture(GLuint unit, GLuint texture);  // GL_TEXTURE_2D
+  void BindBuffer(GLenum target, GLuint buffer);
+  void BindUniformRange(GLuint binding, GLuint buffer, GLintptr offset,
+                        GLsizeiptr size);
+
+  // Drop a deleted object from the cache. GL unbinds a deleted object from
+  // everything it was bound to.
+  void ForgetBuffer(GLuint buffer);
+  void ForgetTexture(GLuint texture);
+  void ForgetVertexArray(GLuint oldVertexArray);
+
+  // Count work done outside the cache for the frame's counters
+  void CountDraw(uint64_t triangles) {
+    ++frame.draws;
+    frame.triangles += triangles;
+  }
+  void CountUniform() { ++frame.uniformCalls; }
+  void CountBufferUpload(GLsizeiptr bytes) { frame.bufferBytes += bytes; }
+  void CountTextureUpload(GLsizeiptr bytes) { frame.textureBytes += bytes; }
+
+  // Forgets all bound state, so the next call of each kind reaches GL
+  void Invalidate();
+
+  // Finishes the frame's counters and starts new ones
+  void BeginFrame();
+
+  // Counters of the last finished frame
+  const Counters& LastFrame() const { return lastFrame; }
+
+  // Counters gathered since BeginFrame. After drawing and before the next
+  // BeginFrame, that's the frame just drawn.
+  const Counters& ThisFrame() const { return frame; }
+};
+#endif
@@ -0,0 +1,125 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The GLStats class keeps the GL state cache's counters for a rolling
+// window of recent frames: draws and triangles, binds by kind, uniform
+// calls, and bytes uploaded. It reports the mean and peak of each over the
+// window, and writes the window to a CSV file, one row per frame, so
+// budgets can be set and regressions spotted when content changes.
+#include "GLStats.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace {
+  const char* kStatNames[GLStats::NUM_STATS] = {
+    "draws",
+    "triangles",
+    "program_binds",
+    "vertex_array_binds",
+    "texture_binds",
+    "uniform_calls",
+    "buffer_bytes",
+    "texture_bytes",
+    "binds_issued",
+    "binds_elided"
+  };
+}  // namespace
+
+void GLStats::Add(const GLStateCache::Counters& counters) {
+  Sample sample;
+  sample[DRAWS] = counters.draws;
+  sample[TRIANGLES] = counters.triangles;
+  sample[PROGRAM_BINDS] = counters.programBinds;
+  sample[VERTEX_ARRAY_BINDS] = counters.vertexArrayBinds;
+  sample[TEXTURE_BINDS] = counters.textureBinds;
+  sample[UNIFORM_CALLS] = counters.uniformCalls;
+  sample[BUFFER_BYTES] = counters.bufferBytes;
+  sample[TEXTURE_BYTES] = counters.textureBytes;
+  sample[BINDS_ISSUED] = counters.issued;
+  sample[BINDS_ELIDED] = counters.elided;
+
+  // Growing until the window is full, then replacing the oldest frame
+  if (samples.size() < kWindowFrames) {
+    samples.push_back(Sample());
+    frameNums.push_back(0);
+  } else {
+    for (int stat = 0; stat < NUM_STATS; ++stat) {
+      totals[stat] -= samples[next][stat];
+    }
+  }
+  for (int stat = 0; stat < NUM_STATS; ++stat) {
+    totals[stat] += sample[stat];
+  }
+  samples[next] = sample;
+  frameNums[next] = numFrames++;
+  next = (next + 1) % kWindowFrames;
+}
+
+uint32_t GLStats::Size() const {
+  return static_cast<uint32_t>(samples.size());
+}
+
+double GLStats::Mean(Stat stat) const {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  return static_cast<double>(totals[stat]) / samples.size();
+}
+
+uint64_t GLStats::Peak(Stat stat) const {
+  uint64_t peak = 0;
+  std::vector<Sample>::const_iterator sampleIter = samples.begin();
+  for (; sampleIter != samples.end(); ++sampleIter) {
+    peak = std::max(peak, (*sampleIter)[stat]);
+  }
+  return peak;
+}
+
+// The latest frame sits just before where the next one goes
+uint64_t GLStats::Last(Stat stat) const {
+  if (samples.empty()) {
+    return 0;
+  }
+  return samples[(next + kWindowFrames - 1) % kWindowFrames][stat];
+}
+
+const char* GLStats::Name(Stat stat) {
+  return kStatNames[stat];
+}
+
+// Until the window fills, the oldest frame is at the front; after, it's the
+// one the next frame will replace
+bool GLStats::WriteCsv(const std::string& path) const {
+  std::ofstream file(path);
+  if (!file) {
+    return false;
+  }
+  file << "frame";
+  for (int stat = 0; stat < NUM_STATS; ++stat) {
+    file << "," << kStatNames[stat];
+  }
+  file << "\n";
+
+  uint32_t oldest = samples.size() < kWindowFrames ? 0 : next;
+  for (uint32_t i = 0; i < samples.size(); ++i) {
+    uint32_t idx = (oldest + i) % samples.size();
+    file << frameNums[idx];
+    for (int stat = 0; stat < NUM_STATS; ++stat) {
+      file << "," << samples[idx][stat];
+    }
+    file << "\n";
+  }
+  file << "mean";
+  for (int stat = 0; stat < NUM_STATS; ++stat) {
+    file << "," << Mean(static_cast<Stat>(stat));
+  }
+  file << "\npeak";
+  for (int stat = 0; stat < NUM_STATS; ++stat) {
+    file << "," << Peak(static_cast<Stat>(stat));
+  }
+  file << "\n";
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,77 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The GLStats class keeps the GL state cache's counters for a rolling
+// window of recent frames: draws and triangles, binds by kind, uniform
+// calls, and bytes uploaded. It reports the mean and peak of each over the
+// window, and writes the window to a CSV file, one row per frame, so
+// budgets can be set and regressions spotted when content changes.
+#pragma once
+#ifndef GL_STATS
+#define GL_STATS
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GLStateCache.h"
+
+class GLStats {
+ public:
+    // Frames the window covers
+    static constexpr uint32_t kWindowFrames = 120;
+
+    // Each counter kept, in the order of the CSV file's columns
+    enum Stat {
+      DRAWS,
+      TRIANGLES,
+      PROGRAM_BINDS,
+      VERTEX_ARRAY_BINDS,
+      TEXTURE_BINDS,
+      UNIFORM_CALLS,
+      BUFFER_BYTES,
+      TEXTURE_BYTES,
+      BINDS_ISSUED,
+      BINDS_ELIDED,
+      NUM_STATS
+    };
+
+ private:
+    typedef std::array<uint64_t, NUM_STATS> Sample;
+
+    // Frames in the window, oldest overwritten first. next is where the
+    // next frame goes, and frameNums holds each one's frame number.
+    std::vector<Sample> samples;
+    std::vector<uint64_t> frameNums;
+    uint32_t next = 0;
+    uint64_t numFrames = 0;
+
+    // Totals over the window, kept up to date as frames come and go
+    Sample totals = {};
+
+ public:
+    // Adds a finished frame's counters, dropping the oldest frame once the
+    // window is full
+    void Add(const GLStateCache::Counters& counters);
+
+    // Frames in the window
+    uint32_t Size() const;
+
+    // Mean and peak of a counter over the window, and its latest value.
+    // All are 0 for an empty window.
+    double Mean(Stat stat) const;
+    uint64_t Peak(Stat stat) const;
+    uint64_t Last(Stat stat) const;
+
+    // Column name of a counter
+    static const char* Name(Stat stat);
+
+    // Writes the window to a CSV file: a header, a row per frame oldest
+    // first, then rows of the means and peaks. Returns false if the file
+    // can't be written.
+    bool WriteCsv(const std::string& path) const;
+};
+#endif
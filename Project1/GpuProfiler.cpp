@@ -0,0 +1,123 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The GpuProfiler class times scopes of GPU work with timestamp queries
+// while the Profiler is capturing. Each frame writes its queries into its
+// own pool, and a pool is only read when its turn to be reused comes round,
+// Profiler::kLateFrames frames later. By then the GPU has long finished, so
+// reading never waits on it; a pool that still isn't done is skipped.
+#include "GpuProfiler.h"
+#include "Profiler.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace {
+  // GPU scopes a frame can time; more than this go untimed
+  const uint32_t kMaxScopes = 32;
+
+  // Scope whose queries weren't issued
+  const uint32_t kNoEvent = ~0u;
+
+  // A timed scope: its name and the queries at its start and end
+  struct GpuEvent {
+    const char* name;
+    uint32_t beginQuery;
+    uint32_t endQuery;
+  };
+
+  // One frame's queries. clockOffset turns the GPU's timestamps into
+  // Profiler::Now's clock. lastIssued is the query most recently sent to
+  // the GPU, which with nested scopes is an outer scope's end, not the last
+  // query handed out.
+  struct QueryPool {
+    GLuint queries[kMaxScopes * 2] = {};
+    std::vector<GpuEvent> events;
+    uint32_t numQueries = 0;
+    uint32_t lastIssued = 0;
+    int64_t clockOffset = 0;
+  };
+
+  QueryPool pools[Profiler::kLateFrames];
+  uint32_t currPool = 0;
+  bool created = false;
+}  // namespace
+
+// Stamping the start of the scope. Timestamps, unlike GL_TIME_ELAPSED
+// queries, can nest.
+GpuProfiler::Scope::Scope(const char* name)
+    : pool(currPool), event(kNoEvent) {
+  if (!Profiler::Recording()) {
+    return;
+  }
+  if (!created) {
+    for (uint32_t i = 0; i < Profiler::kLateFrames; ++i) {
+      glGenQueries(kMaxScopes * 2, pools[i].queries);
+    }
+    created = true;
+  }
+  QueryPool& frame = pools[pool];
+  if (frame.numQueries == kMaxScopes * 2) {
+    return;
+  }
+
+  // Lining the GPU's clock up with the CPU's at the frame's first scope.
+  // Reading the current GPU time doesn't wait for queued work.
+  if (frame.events.empty()) {
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    frame.clockOffset = Profiler::Now() - gpuNow;
+  }
+  event = static_cast<uint32_t>(frame.events.size());
+  frame.events.push_back(
+    GpuEvent{name, frame.numQueries, frame.numQueries + 1});
+  frame.numQueries += 2;
+  frame.lastIssued = frame.events[event].beginQuery;
+  glQueryCounter(frame.queries[frame.lastIssued], GL_TIMESTAMP);
+}
+
+GpuProfiler::Scope::~Scope() {
+  if (event != kNoEvent) {
+    QueryPool& frame = pools[pool];
+    frame.lastIssued = frame.events[event].endQuery;
+    glQueryCounter(frame.queries[frame.lastIssued], GL_TIMESTAMP);
+  }
+}
+
+// Queries finish in the order they were issued, so once the pool's last
+// issued one is available all of them are
+void GpuProfiler::EndFrame() {
+  currPool = (currPool + 1) % Profiler::kLateFrames;
+  QueryPool& frame = pools[currPool];
+  if (!frame.events.empty()) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(frame.queries[frame.lastIssued],
+                        GL_QUERY_RESULT_AVAILABLE, &available);
+    std::vector<GpuEvent>::iterator eventIter = frame.events.begin();
+    for (; available && eventIter != frame.events.end(); ++eventIter) {
+      GLuint64 begin = 0;
+      GLuint64 end = 0;
+      glGetQueryObjectui64v(frame.queries[eventIter->beginQuery],
+                            GL_QUERY_RESULT, &begin);
+      glGetQueryObjectui64v(frame.queries[eventIter->endQuery],
+                            GL_QUERY_RESULT, &end);
+      Profiler::AddGpuEvent(eventIter->name,
+                            static_cast<int64_t>(begin) + frame.clockOffset,
+                            static_cast<int64_t>(end) + frame.clockOffset);
+    }
+    frame.events.clear();
+    frame.numQueries = 0;
+  }
+}
+
+void GpuProfiler::Release() {
+  if (created) {
+    for (uint32_t i = 0; i < Profiler::kLateFrames; ++i) {
+      glDeleteQueries(kMaxScopes * 2, pools[i].queries);
+    }
+    created = false;
+  }
+}
@@ -0,0 +1,40 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The GpuProfiler class times scopes of GPU work with timestamp queries
+// while the Profiler is capturing. Each frame writes its queries into its
+// own pool, and a pool is only read when its turn to be reused comes round,
+// Profiler::kLateFrames frames later. By then the GPU has long finished, so
+// reading never waits on it; a pool that still isn't done is skipped.
+#pragma once
+#ifndef GPU_PROFILER
+#define GPU_PROFILER
+
+#include <cstdint>
+
+class GpuProfiler {
+ public:
+    // Times the GPU work issued in the rest of the enclosing scope, if the
+    // Profiler is recording when it starts. The name must outlive the
+    // capture, which a string literal does. GL thread only.
+    class Scope {
+     private:
+        uint32_t pool;
+        uint32_t event;
+
+     public:
+        explicit Scope(const char* name);
+        ~Scope();
+    };
+
+    // Hands the oldest pool's timings to the Profiler and starts the next
+    // frame's pool. Called once a frame on the GL thread, after swapping
+    // buffers and before Profiler::EndFrame.
+    static void EndFrame();
+
+    // Deletes the query objects. The GL context must still be current.
+    static void Release();
+};
+#endif
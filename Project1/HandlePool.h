@@ -0,0 +1,116 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Generational handles for structure-of-arrays storage. A pool keeps each
+// field of its items in its own densely packed array (a column), so a loop
+// over one field touches only that field's memory. A HandleTable maps
+// stable handles to positions in those arrays: removing an item moves the
+// last one into its place, and the table follows the move. Each slot counts
+// how many times it's been freed, so a handle to a removed item never
+// finds whatever takes its slot next.
+#pragma once
+#ifndef HANDLE_POOL
+#define HANDLE_POOL
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Handle to an item in a pool. Tag keeps handles to different pools from
+// being mixed up. Generation 0 is never issued, so a default handle is null.
+template <typename Tag>
+struct Handle {
+  uint32_t index = 0;       // slot in the handle table
+  uint32_t generation = 0;  // slot's generation when this was issued
+
+  bool IsNull() const { return generation == 0; }
+  bool operator==(const Handle& other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Maps handles to dense array positions and back
+template <typename Tag>
+class HandleTable {
+ private:
+  struct Slot {
+    uint32_t dense = 0;
+    uint32_t generation = 1;
+  };
+
+  std::vector<Slot> slots;
+  std::vector<uint32_t> denseSlots;  // slot of each dense position
+  std::vector<uint32_t> freeSlots;
+
+ public:
+  // Issues a handle for a new item at the end of the dense arrays. The
+  // caller appends the item's fields to every column.
+  Handle<Tag> Create() {
+    uint32_t slot = 0;
+    if (!freeSlots.empty()) {
+      slot = freeSlots.back();
+      freeSlots.pop_back();
+    } else {
+      slot = static_cast<uint32_t>(slots.size());
+      slots.push_back(Slot());
+    }
+    slots[slot].dense = static_cast<uint32_t>(denseSlots.size());
+    denseSlots.push_back(slot);
+    return Handle<Tag>{ slot, slots[slot].generation };
+  }
+
+  // Frees a handle's slot, moving the last dense item into its position.
+  // Returns that position, for the caller to SwapRemove every column at.
+  uint32_t Destroy(Handle<Tag> handle) {
+    uint32_t dense = slots[handle.index].dense;
+    uint32_t lastSlot = denseSlots.back();
+    slots[lastSlot].dense = dense;
+    denseSlots[dense] = lastSlot;
+    denseSlots.pop_back();
+    ++slots[handle.index].generation;
+    freeSlots.push_back(handle.index);
+    return dense;
+  }
+
+  // True if the handle's item hasn't been removed
+  bool Valid(Handle<Tag> handle) const {
+    return handle.generation != 0 && handle.index < slots.size() &&
+           slots[handle.index].generation == handle.generation;
+  }
+
+  // Dense position of a valid handle's item
+  uint32_t Dense(Handle<Tag> handle) const {
+    return slots[handle.index].dense;
+  }
+
+  // Handle of the item at a dense position
+  Handle<Tag> At(uint32_t dense) const {
+    uint32_t slot = denseSlots[dense];
+    return Handle<Tag>{ slot, slots[slot].generation };
+  }
+
+  // Number of live items
+  uint32_t Size() const {
+    return static_cast<uint32_t>(denseSlots.size());
+  }
+};
+
+// Removes position dense from a column by moving its last element there
+template <typename T>
+void SwapRemoveOne(uint32_t dense, std::vector<T>* column) {
+  if (dense + 1 != column->size()) {
+    (*column)[dense] = std::move(column->back());
+  }
+  column->pop_back();
+}
+
+// Removes position dense from every column given, matching what
+// HandleTable::Destroy did to the dense order
+template <typename... Columns>
+void SwapRemove(uint32_t dense, Columns*... columns) {
+  (SwapRemoveOne(dense, columns), ...);
+}
+#endif
@@ -0,0 +1,240 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The JobSystem class runs small jobs on a fixed pool of threads. Each
+// thread has its own deque of jobs: it pushes and pops at the back, so the
+// jobs it just made run while their data is still in cache, and threads
+// with nothing to do steal from the front of other deques. Jobs count down
+// a Counter when they finish, and can be held back until another Counter
+// reaches zero, which is how dependencies are expressed. Jobs that call
+// OpenGL are marked for the main thread, which owns the context; they wait
+// in their own queue and only run when the main thread waits on something.
+// Waiting never just blocks: a waiting thread runs other jobs meanwhile.
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <string>
+#include <utility>
+
+namespace {
+  // Calling thread's position in the pool
+  thread_local unsigned int threadIndex = JobSystem::kNoThread;
+
+  // Longest a waiting thread sleeps before looking for jobs again. Wakeups
+  // are signalled, so this only bounds the cost of a missed one.
+  const std::chrono::milliseconds kMaxSleep(1);
+}  // namespace
+
+bool JobSystem::Counter::Done() const {
+  return pending.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::JobSystem() {
+  deques.push_back(std::make_unique<WorkDeque>());
+  threadIndex = 0;
+}
+
+// Adding every worker's deque before any worker starts, so the deques
+// never change while threads are stealing from them
+void JobSystem::Start(unsigned int numThreads) {
+  if (!workers.empty()) {
+    return;
+  }
+  if (numThreads == 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned int thread = 1; thread < numThreads; ++thread) {
+    deques.push_back(std::make_unique<WorkDeque>());
+  }
+  threadIndex = 0;
+  for (unsigned int thread = 1; thread < numThreads; ++thread) {
+    workers.emplace_back(&JobSystem::WorkerLoop, this, thread);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> guard(sleepLock);
+    stopping = true;
+  }
+  wake.notify_all();
+  std::vector<std::thread>::iterator workerIter = workers.begin();
+  for (; workerIter != workers.end(); ++workerIter) {
+    workerIter->join();
+  }
+}
+
+// Holding the job on after if it hasn't finished. The count is checked
+// again under after's lock, which Execute counts down under, so the job
+// is either held and then released, or submitted here.
+void JobSystem::Run(std::function<void()> work, Counter* counter,
+                    Counter* after, Affinity affinity) {
+  Job job;
+  job.work = std::move(work);
+  job.counter = counter;
+  job.affinity = affinity;
+  if (counter != nullptr) {
+    counter->pending.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (after != nullptr && !after->Done()) {
+    std::lock_guard<std::mutex> guard(after->lock);
+    if (!after->Done()) {
+      after->waiting.push_back(std::move(job));
+      return;
+    }
+  }
+  Submit(std::move(job));
+}
+
+// Jobs from outside the pool go to the main thread's deque, where any
+// thread can steal them
+void JobSystem::Submit(Job job) {
+  if (job.affinity == MAIN_THREAD) {
+    std::lock_guard<std::mutex> guard(mainLock);
+    mainJobs.push_back(std::move(job));
+    queuedMainJobs.fetch_add(1, std::memory_order_release);
+  } else {
+    unsigned int thread = threadIndex == kNoThread ? 0 : threadIndex;
+    WorkDeque& deque = *deques[thread];
+    std::lock_guard<std::mutex> guard(deque.lock);
+    deque.jobs.push_back(std::move(job));
+    queuedJobs.fetch_add(1, std::memory_order_release);
+  }
+
+  // Waking everyone, since only the main thread can take main jobs and
+  // waiters may be asleep
+  std::lock_guard<std::mutex> guard(sleepLock);
+  wake.notify_all();
+}
+
+bool JobSystem::FindJob(unsigned int thread, Job* job) {
+  if (queuedJobs.load(std::memory_order_acquire) == 0 &&
+      (thread != 0 || queuedMainJobs.load(std::memory_order_acquire) == 0)) {
+    return false;
+  }
+
+  // Own newest job first
+  if (thread != kNoThread) {
+    WorkDeque& own = *deques[thread];
+    std::lock_guard<std::mutex> guard(own.lock);
+    if (!own.jobs.empty()) {
+      *job = std::move(own.jobs.back());
+      own.jobs.pop_back();
+      queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  // Then GL jobs, on the main thread
+  if (thread == 0) {
+    std::lock_guard<std::mutex> guard(mainLock);
+    if (!mainJobs.empty()) {
+      *job = std::move(mainJobs.front());
+      mainJobs.pop_front();
+      queuedMainJobs.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  // Then stealing the oldest job of the next thread along that has one
+  unsigned int numThreads = NumThreads();
+  unsigned int start = thread == kNoThread ? 0 : thread + 1;
+  for (unsigned int i = 0; i < numThreads; ++i) {
+    unsigned int victim = (start + i) % numThreads;
+    if (victim == thread) {
+      continue;
+    }
+    WorkDeque& other = *deques[victim];
+    std::lock_guard<std::mutex> guard(other.lock);
+    if (!other.jobs.empty()) {
+      *job = std::move(other.jobs.front());
+      other.jobs.pop_front();
+      queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Counting down under the counter's lock, so Run sees the count and the
+// held jobs change together, and Wait can't return and free the counter
+// while this still has it locked
+void JobSystem::Execute(Job* job) {
+  {
+    Profiler::Scope cpuScope("Job");
+    job->work();
+  }
+  Counter* counter = job->counter;
+  if (counter == nullptr) {
+    return;
+  }
+  std::vector<Job> released;
+  {
+    std::lock_guard<std::mutex> guard(counter->lock);
+    if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    released.swap(counter->waiting);
+  }
+
+  // Last job on the counter: releasing what was held on it, and waking
+  // anyone waiting for it
+  std::vector<Job>::iterator jobIter = released.begin();
+  for (; jobIter != released.end(); ++jobIter) {
+    Submit(std::move(*jobIter));
+  }
+  std::lock_guard<std::mutex> guard(sleepLock);
+  wake.notify_all();
+}
+
+void JobSystem::WorkerLoop(unsigned int thread) {
+  threadIndex = thread;
+  Profiler::SetThreadName("Worker " + std::to_string(thread));
+  while (true) {
+    Job job;
+    if (FindJob(thread, &job)) {
+      Execute(&job);
+      continue;
+    }
+    std::unique_lock<std::mutex> guard(sleepLock);
+    if (stopping && queuedJobs.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+    wake.wait_for(guard, kMaxSleep, [this] {
+      return stopping || queuedJobs.load(std::memory_order_acquire) != 0;
+    });
+  }
+}
+
+void JobSystem::Wait(Counter* counter) {
+  unsigned int thread = threadIndex;
+  while (!counter->Done()) {
+    Job job;
+    if (FindJob(thread, &job)) {
+      Execute(&job);
+      continue;
+    }
+    std::unique_lock<std::mutex> guard(sleepLock);
+    wake.wait_for(guard, kMaxSleep, [this, counter, thread] {
+      return counter->Done() ||
+             queuedJobs.load(std::memory_order_acquire) != 0 ||
+             (thread == 0 &&
+              queuedMainJobs.load(std::memory_order_acquire) != 0);
+    });
+  }
+
+  // The last job may still hold the lock it counted down under; the caller
+  // is free to destroy the counter once it's let go
+  std::lock_guard<std::mutex> guard(counter->lock);
+}
+
+unsigned int JobSystem::NumThreads() const {
+  return static_cast<unsigned int>(deques.size());
+}
+
+unsigned int JobSystem::ThreadIndex() {
+  return threadIndex;
+}
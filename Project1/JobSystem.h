@@ -0,0 +1,160 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The JobSystem class runs small jobs on a fixed pool of threads. Each
+// thread has its own deque of jobs: it pushes and pops at the back, so the
+// jobs it just made run while their data is still in cache, and threads
+// with nothing to do steal from the front of other deques. Jobs count down
+// a Counter when they finish, and can be held back until another Counter
+// reaches zero, which is how dependencies are expressed. Jobs that call
+// OpenGL are marked for the main thread, which owns the context; they wait
+// in their own queue and only run when the main thread waits on something.
+// Waiting never just blocks: a waiting thread runs other jobs meanwhile.
+#pragma once
+#ifndef JOB_SYSTEM
+#define JOB_SYSTEM
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem {
+ public:
+  // Which threads may run a job
+  enum Affinity {
+    ANY_THREAD,
+    MAIN_THREAD   // jobs that touch OpenGL
+  };
+
+  // Index ThreadIndex returns on threads outside the pool
+  static const unsigned int kNoThread = ~0u;
+
+  class Counter;
+
+ private:
+  struct Job {
+    std::function<void()> work;
+    Counter* counter = nullptr;
+    Affinity affinity = ANY_THREAD;
+  };
+
+  // A thread's jobs. Padded to its own cache line so threads pushing to
+  // neighboring deques don't slow each other down.
+  struct alignas(64) WorkDeque {
+    std::mutex lock;
+    std::deque<Job> jobs;
+  };
+
+ public:
+  // Jobs run with this counter that haven't finished yet. Jobs can also be
+  // held until it reaches zero. Must outlive every job that uses it.
+  class Counter {
+   private:
+    friend class JobSystem;
+    std::atomic<uint32_t> pending{0};
+    std::mutex lock;
+    std::vector<Job> waiting;   // held until pending reaches zero
+
+   public:
+    bool Done() const;
+  };
+
+ private:
+  // One deque per thread in the pool, the main thread's first
+  std::vector<std::unique_ptr<WorkDeque>> deques;
+
+  // Jobs only the main thread may run
+  std::mutex mainLock;
+  std::deque<Job> mainJobs;
+
+  // Jobs sitting in the deques and in the main queue, so idle threads know
+  // when to look. Counted apart so workers don't spin on main jobs.
+  std::atomic<uint32_t> queuedJobs{0};
+  std::atomic<uint32_t> queuedMainJobs{0};
+
+  // Idle threads sleep here until a job is queued or a counter finishes
+  std::mutex sleepLock;
+  std::condition_variable wake;
+  bool stopping = false;
+
+  std::vector<std::thread> workers;
+
+  // Queues a job that is ready to run
+  void Submit(Job job);
+
+  // Takes a job for a thread to run: its own newest job, then the main
+  // queue if it's the main thread, then the oldest job of another thread.
+  // Returns false if there's nothing.
+  bool FindJob(unsigned int thread, Job* job);
+
+  // Runs a job, then counts down its counter, releasing jobs held on it
+  void Execute(Job* job);
+
+  void WorkerLoop(unsigned int thread);
+
+ public:
+  // Makes a pool of just the constructing thread, which becomes the main
+  // thread. No workers run until Start, so this is safe to construct
+  // during static initialization.
+  JobSystem();
+
+  // Starts numThreads - 1 worker threads; the main thread counts as the
+  // last one. 0 uses one thread per core. Call once, from the main thread,
+  // before any other thread runs jobs. Until then every job runs on the
+  // thread waiting for it.
+  void Start(unsigned int numThreads = 0);
+
+  // Finishes every queued job, then stops the workers
+  ~JobSystem();
+
+  // Queues work to run once after has reached zero (or right away if after
+  // is null), counting it against counter if there is one
+  void Run(std::function<void()> work, Counter* counter = nullptr,
+           Counter* after = nullptr, Affinity affinity = ANY_THREAD);
+
+  // Returns once counter reaches zero, running jobs until it does. Only the
+  // main thread runs MAIN_THREAD jobs here.
+  void Wait(Counter* counter);
+
+  // Calls work(begin, end) over ranges covering [0, count), in parallel,
+  // and returns once all are done. Ranges are sized to give every thread
+  // a few to balance load, but hold at least minGrain items.
+  template <typename Work>
+  void ParallelFor(uint32_t count, Work work, uint32_t minGrain = 1);
+
+  // Threads in the pool, counting the main thread
+  unsigned int NumThreads() const;
+
+  // Position of the calling thread in the pool, from 0 for the main thread
+  // up to NumThreads() - 1, or kNoThread outside the pool
+  static unsigned int ThreadIndex();
+};
+
+// Cutting the range into about four pieces per thread, running the first
+// piece here and the rest as jobs
+template <typename Work>
+void JobSystem::ParallelFor(uint32_t count, Work work, uint32_t minGrain) {
+  if (count == 0) {
+    return;
+  }
+  uint32_t grain = count / (NumThreads() * 4);
+  grain = std::max(grain, std::max(minGrain, 1u));
+
+  Counter counter;
+  for (uint32_t begin = grain; begin < count; begin += grain) {
+    uint32_t end = std::min(count, begin + grain);
+    Run([&work, begin, end] { work(begin, end); }, &counter);
+  }
+  work(0, std::min(count, grain));
+  Wait(&counter);
+}
+#endif
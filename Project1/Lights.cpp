@@ -49,15 +49,10 @@ void LoadDirLights(GLFWwindow* window) {
   // Directional light UBO
   GLuint dirLightUBO = 0;
 
-  // Getting block indices, one for each shader
-  GLuint propMatDirLightIndex = glGetUniformBlockIndex(propMatShader->id,
-                                                       "DirLights");
-  GLuint imgMatDirLightIndex = glGetUniformBlockIndex(imgMatShader->id,
-                                                      "DirLights");
-
-  // Binding property- and image- material shaders to uniform binding points
-  glUniformBlockBinding(propMatShader->id, propMatDirLightIndex, 0);
-  glUniformBlockBinding(imgMatShader->id, imgMatDirLightIndex, 0);
+  // Binding property- and image- material shaders' blocks to uniform
+  // binding points
+  propMatShader->BindBlock(HashUniform("DirLights"), 0);
+  imgMatShader->BindBlock(HashUniform("DirLights"), 0);
 
   // Generating buffers and setting their sizes (note data is NULL)
   glGenBuffers(1, &dirLightUBO);
@@ -106,15 +101,10 @@ void LoadPntLights(GLFWwindow* window) {
   // Point light UBO
   GLuint pntLightUBO = 0;
 
-  // Getting block indices, one for each shader
-  GLuint propMatPntLightIndex = glGetUniformBlockIndex(propMatShader->id,
-                                                       "PntLights");
-  GLuint imgMatPntLightIndex = glGetUniformBlockIndex(imgMatShader->id,
-                                                      "PntLights");
-
-  // Binding property- and image- material shaders to uniform binding points
-  glUniformBlockBinding(propMatShader->id, propMatPntLightIndex, 1);
-  glUniformBlockBinding(imgMatShader->id, imgMatPntLightIndex, 1);
+  // Binding property- and image- material shaders' blocks to uniform
+  // binding points
+  propMatShader->BindBlock(HashUniform("PntLights"), 1);
+  imgMatShader->BindBlock(HashUniform("PntLights"), 1);
 
   // Generating buffers and setting their sizes (note data is NULL)
   glGenBuffers(1, &pntLightUBO);
@@ -0,0 +1,226 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The MeshBuffer class holds the vertex and index data of many meshes in one
+// large vertex buffer and one large index buffer, behind one vertex array.
+// Meshes get ranges of each from a BufferAllocator and are drawn with
+// glDrawElementsBaseVertex, so drawing different meshes needs no buffer or
+// vertex array changes, and loading or unloading a mesh creates no GL
+// objects. All meshes in a MeshBuffer share one vertex format.
+#include "MeshBuffer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace {
+  // Index ranges are rounded up to this many bytes
+  const GLuint kIndexAlign = 4;
+
+  GLuint AlignIndexBytes(GLuint bytes) {
+    return (bytes + kIndexAlign - 1) & ~(kIndexAlign - 1);
+  }
+
+  // Capacity to grow to: double, or enough for the request if that's more
+  GLuint GrownCapacity(const BufferAllocator& alloc, GLuint needed) {
+    GLuint doubled = std::max<GLuint>(alloc.Capacity() * 2, 1);
+    return std::max(doubled, alloc.Used() + needed);
+  }
+}  // namespace
+
+// Creating vertex array and empty buffers
+MeshBuffer::MeshBuffer(GLStateCache* glState, GLsizei vertSz,
+                       std::vector<Attrib> attribs, GLuint vertCapacity,
+                       GLuint indexCapacity)
+    : glState(glState), vertSz(vertSz), attribs(std::move(attribs)),
+      vertAlloc(vertCapacity),
+      indexAlloc(AlignIndexBytes(indexCapacity)) {
+  glGenVertexArrays(1, &VAO);
+  glGenBuffers(1, &VBO);
+  glGenBuffers(1, &EBO);
+
+  // Uploads go through the copy write binding, so the vertex array's index
+  // buffer binding is never disturbed
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+  glBufferData(GL_COPY_WRITE_BUFFER,
+               static_cast<GLsizeiptr>(vertSz) * vertAlloc.Capacity(),
+               nullptr, GL_STATIC_DRAW);
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+  glBufferData(GL_COPY_WRITE_BUFFER, indexAlloc.Capacity(), nullptr,
+               GL_STATIC_DRAW);
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  AttachBuffers();
+}
+
+// Sets attribute pointers and index buffer in the vertex array
+void MeshBuffer::AttachBuffers() {
+  glState->BindVertexArray(VAO);
+  glState->BindBuffer(GL_ARRAY_BUFFER, VBO);
+  std::vector<Attrib>::const_iterator attribIter = attribs.begin();
+  for (; attribIter != attribs.end(); ++attribIter) {
+    glVertexAttribPointer(attribIter->location, attribIter->numComps,
+                          attribIter->type, attribIter->normalized, vertSz,
+                          reinterpret_cast<void*>(
+                            static_cast<size_t>(attribIter->offset)));
+    glEnableVertexAttribArray(attribIter->location);
+  }
+  // Element array binding is vertex array state, so it's not cached
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+  glState->BindVertexArray(0);
+  glState->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Makes new buffers and copies live ranges across on the GPU
+void MeshBuffer::Rebuild(GLuint vertCapacity, GLuint indexCapacity) {
+  // Where each live range ends up. Everything is being copied anyway, so
+  // closing the gaps costs nothing extra.
+  std::vector<BufferAllocator::Move> vertMoves;
+  std::vector<BufferAllocator::Move> indexMoves;
+  GLuint oldVertCapacity = vertAlloc.Capacity();
+  GLuint oldIndexCapacity = indexAlloc.Capacity();
+  vertAlloc.Compact(&vertMoves);
+  indexAlloc.Compact(&indexMoves);
+  vertAlloc.Grow(vertCapacity);
+  indexAlloc.Grow(AlignIndexBytes(indexCapacity));
+
+  // Copying from old to new buffers. Ranges that didn't move are all
+  // before the first one that did, so they go across in one copy.
+  GLuint buffers[2] = { VBO, EBO };
+  GLsizeiptr oldSizes[2] = {
+    static_cast<GLsizeiptr>(vertSz) * oldVertCapacity,
+    static_cast<GLsizeiptr>(oldIndexCapacity)
+  };
+  GLsizeiptr newSizes[2] = {
+    static_cast<GLsizeiptr>(vertSz) * vertAlloc.Capacity(),
+    static_cast<GLsizeiptr>(indexAlloc.Capacity())
+  };
+  const std::vector<BufferAllocator::Move>* moves[2] = { &vertMoves,
+                                                         &indexMoves };
+  GLsizeiptr unitSz[2] = { vertSz, 1 };
+  for (int i = 0; i < 2; ++i) {
+    GLuint newBuffer = 0;
+    glGenBuffers(1, &newBuffer);
+    glState->BindBuffer(GL_COPY_READ_BUFFER, buffers[i]);
+    glState->BindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, newSizes[i], nullptr, GL_STATIC_DRAW);
+    GLsizeiptr inPlace = std::min(oldSizes[i], newSizes[i]);
+    if (!moves[i]->empty()) {
+      inPlace = moves[i]->front().dstOffset * unitSz[i];
+    }
+    if (inPlace > 0) {
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                          inPlace);
+    }
+    std::vector<BufferAllocator::Move>::const_iterator moveIter =
+      moves[i]->begin();
+    for (; moveIter != moves[i]->end(); ++moveIter) {
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                          moveIter->srcOffset * unitSz[i],
+                          moveIter->dstOffset * unitSz[i],
+                          moveIter->size * unitSz[i]);
+    }
+    glState->ForgetBuffer(buffers[i]);
+    glDeleteBuffers(1, &buffers[i]);
+    buffers[i] = newBuffer;
+  }
+  glState->BindBuffer(GL_COPY_READ_BUFFER, 0);
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  VBO = buffers[0];
+  EBO = buffers[1];
+
+  AttachBuffers();
+}
+
+// Allocating ranges, making room first if needed, then uploading
+MeshBuffer::Range MeshBuffer::Add(const void* verts, GLuint numVerts,
+                                  const void* indices, GLuint indexBytes) {
+  GLuint alignedBytes = AlignIndexBytes(indexBytes);
+
+  // Free ranges the allocators are sure to find. They round requests up to
+  // a size class, so a range only just big enough may not do.
+  GLuint vertSearch = BufferAllocator::SearchSize(numVerts);
+  GLuint indexSearch = BufferAllocator::SearchSize(alignedBytes);
+
+  // Compacting is enough if there's free space, just not in one piece;
+  // otherwise the buffers have to grow as well
+  if (vertAlloc.LargestFree() < vertSearch ||
+      indexAlloc.LargestFree() < indexSearch) {
+    GLuint vertCapacity = vertAlloc.Capacity();
+    if (vertCapacity - vertAlloc.Used() < vertSearch) {
+      vertCapacity = GrownCapacity(vertAlloc, vertSearch);
+    }
+    GLuint indexCapacity = indexAlloc.Capacity();
+    if (indexCapacity - indexAlloc.Used() < indexSearch) {
+      indexCapacity = GrownCapacity(indexAlloc, indexSearch);
+    }
+    Rebuild(vertCapacity, indexCapacity);
+  }
+
+  Range range;
+  range.vertBlock = vertAlloc.Allocate(numVerts);
+  range.indexBlock = indexAlloc.Allocate(alignedBytes);
+
+  // Uploading into the allocated ranges
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+  glBufferSubData(GL_COPY_WRITE_BUFFER,
+                  static_cast<GLintptr>(vertSz) *
+                    vertAlloc.Offset(range.vertBlock),
+                  static_cast<GLsizeiptr>(vertSz) * numVerts, verts);
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, IndexOffset(range), indexBytes,
+                  indices);
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glState->CountBufferUpload(static_cast<GLsizeiptr>(vertSz) * numVerts +
+                             indexBytes);
+  return range;
+}
+
+// Returning ranges to the allocators
+void MeshBuffer::Remove(const Range& range) {
+  if (range.vertBlock != BufferAllocator::kNoBlock) {
+    vertAlloc.Free(range.vertBlock);
+  }
+  if (range.indexBlock != BufferAllocator::kNoBlock) {
+    indexAlloc.Free(range.indexBlock);
+  }
+}
+
+// Compacting in place, at the current capacity
+void MeshBuffer::Defragment() {
+  Rebuild(vertAlloc.Capacity(), indexAlloc.Capacity());
+}
+
+GLint MeshBuffer::BaseVertex(const Range& range) const {
+  return static_cast<GLint>(vertAlloc.Offset(range.vertBlock));
+}
+
+GLsizeiptr MeshBuffer::IndexOffset(const Range& range) const {
+  return static_cast<GLsizeiptr>(indexAlloc.Offset(range.indexBlock));
+}
+
+// Printing buffer use for load reports
+void MeshBuffer::PrintStats(const char* name) const {
+  std::cout << name << " buffer: "
+            << vertAlloc.Used() << "/" << vertAlloc.Capacity() << " verts ("
+            << vertAlloc.LargestFree() << " largest free), "
+            << indexAlloc.Used() << "/" << indexAlloc.Capacity()
+            << " index bytes (" << indexAlloc.LargestFree()
+            << " largest free), " << vertAlloc.NumAllocs() << " meshes"
+            << std::endl;
+}
+
+// Deleting vertex array and buffers
+void MeshBuffer::Delete() {
+  glState->ForgetVertexArray(VAO);
+  glState->ForgetBuffer(VBO);
+  glState->ForgetBuffer(EBO);
+  glDeleteVertexArrays(1, &VAO);
+  glDeleteBuffers(1, &VBO);
+  glDeleteBuffers(1, &EBO);
+  VAO = 0;
+  VBO = 0;
+  EBO = 0;
+}
@@ -0,0 +1,102 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The MeshBuffer class holds the vertex and index data of many meshes in one
+// large vertex buffer and one large index buffer, behind one vertex array.
+// Meshes get ranges of each from a BufferAllocator and are drawn with
+// glDrawElementsBaseVertex, so drawing different meshes needs no buffer or
+// vertex array changes, and loading or unloading a mesh creates no GL
+// objects. All meshes in a MeshBuffer share one vertex format.
+#pragma once
+#ifndef MESH_BUFF
+#define MESH_BUFF
+
+#include <GL/glew.h>
+
+#include <vector>
+
+#include "BufferAllocator.h"
+#include "GLStateCache.h"
+
+class MeshBuffer {
+ public:
+  // One vertex attribute of the buffer's vertex format
+  struct Attrib {
+    GLuint location = 0;
+    GLint numComps = 0;
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    GLsizei offset = 0;  // bytes from start of vertex
+  };
+
+  // A mesh's ranges of the vertex and index buffers
+  struct Range {
+    GLuint vertBlock = BufferAllocator::kNoBlock;
+    GLuint indexBlock = BufferAllocator::kNoBlock;
+  };
+
+ private:
+  GLuint VAO = 0;
+  GLuint VBO = 0;
+  GLuint EBO = 0;
+
+  // Binds go through the owner's state cache
+  GLStateCache* glState = nullptr;
+
+  // Vertex format
+  GLsizei vertSz = 0;
+  std::vector<Attrib> attribs;
+
+  // Vertex ranges are in vertices, so an offset is a mesh's base vertex.
+  // Index ranges are in bytes, rounded up to 4 so 16 and 32-bit index
+  // data both stay aligned.
+  BufferAllocator vertAlloc;
+  BufferAllocator indexAlloc;
+
+  // Copies live ranges back to back into new buffers of the given
+  // capacities, and points the vertex array at them
+  void Rebuild(GLuint vertCapacity, GLuint indexCapacity);
+
+  // Points the vertex array's attributes and index buffer at VBO and EBO
+  void AttachBuffers();
+
+ public:
+  // Creates the vertex array and buffers, with room for the given number of
+  // vertices and index bytes to start with. Needs a current GL context.
+  MeshBuffer(GLStateCache* glState, GLsizei vertSz,
+             std::vector<Attrib> attribs, GLuint vertCapacity,
+             GLuint indexCapacity);
+
+  // GL objects have exactly one owner
+  MeshBuffer(const MeshBuffer&) = delete;
+  MeshBuffer& operator=(const MeshBuffer&) = delete;
+
+  // Copies a mesh's vertices and indices into the buffers, compacting them
+  // when free space is too scattered and growing them when it runs out.
+  Range Add(const void* verts, GLuint numVerts, const void* indices,
+            GLuint indexBytes);
+
+  // Frees a mesh's ranges for reuse. Buffers are not shrunk.
+  void Remove(const Range& range);
+
+  // Moves every mesh's data together, leaving all free space at the end of
+  // each buffer. Ranges stay valid, but their offsets change.
+  void Defragment();
+
+  // Value for glDrawElementsBaseVertex's basevertex, and byte offset of a
+  // range's indices in the index buffer
+  GLint BaseVertex(const Range& range) const;
+  GLsizeiptr IndexOffset(const Range& range) const;
+
+  // Vertex array to bind before drawing anything in this buffer
+  GLuint VertexArray() const { return VAO; }
+
+  // Prints capacity, use, and largest free range of each buffer
+  void PrintStats(const char* name) const;
+
+  // Deletes the GL objects. Every range becomes invalid.
+  void Delete();
+};
+#endif
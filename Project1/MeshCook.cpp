@@ -0,0 +1,248 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Mesh cooking functions. These read a .DAE file with Assimp, simplify it
+// into levels of detail, optimize it, and find its bounds, all without
+// touching OpenGL. ModelManager runs them on import workers when a mesh has
+// no current cooked file, and the MeshCooker tool runs them to write one.
+#include "MeshCook.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+namespace {
+  // Reads Mesh from file
+  void ReadMesh(const std::string& filename, Assimp::Importer* importer,
+                CookedMesh* mesh) {
+    // Processing flags for importing the model
+    int processFlags = aiProcess_Triangulate |
+      aiProcess_JoinIdenticalVertices        |
+      aiProcess_SortByPType;
+
+    // Importing scene from file
+    const aiScene* scene = importer->ReadFile(("mesh/" + filename),
+                                             processFlags);
+
+    // Making sure a scene was actually found
+    if (scene == nullptr) {
+      std::cerr << importer->GetErrorString() << std::endl;
+      return;
+    }
+
+    // Each file only has one mesh
+    aiMesh* importMesh = scene->mMeshes[0];
+
+    // Recreating vertex data
+    for (unsigned int i = 0; i < importMesh->mNumVertices; ++i) {
+      // Create new MeshVertex struct
+      MeshVertex vert;
+
+      // Getting vector for each attribute
+      aiVector3D vecPos = importMesh->mVertices[i];
+      aiVector3D vecNorm = importMesh->mNormals[i];
+      aiVector3D vecUv = importMesh->mTextureCoords[0][i];
+
+      // Assigning values to MeshVertex struct
+      vert.pos = glm::vec3(vecPos[0], vecPos[1], vecPos[2]);
+      vert.norm = glm::vec3(vecNorm[0], vecNorm[1], vecNorm[2]);
+      vert.uv = glm::vec2(vecUv[0], vecUv[1]);
+
+      // Add vertex to vertex vector
+      mesh->verts.push_back(vert);
+    }
+
+    // Storing indices for each face
+    for (unsigned int i = 0; i < importMesh->mNumFaces; ++i) {
+      aiFace face = importMesh->mFaces[i];
+      for (int j = 0; j < 3; ++j) {
+        mesh->indices.push_back(face.mIndices[j]);
+      }
+    }
+  }
+
+  // Builds LOD chain by repeatedly simplifying the last LOD
+  void BuildLods(const std::string& meshName, CookedMesh* mesh) {
+    // LOD 0 is the full mesh
+    mesh->lods[0] = MeshLod{ 0, static_cast<uint32_t>(mesh->indices.size()),
+                             0.0f };
+    mesh->numLods = 1;
+    if (mesh->indices.empty()) {
+      return;
+    }
+
+    // Each LOD aims for half the triangles of the one before it
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(4) << meshName << " LODs: "
+           << mesh->indices.size() / 3;
+    std::vector<GLuint> simplified;
+    while (mesh->numLods < kMaxLods) {
+      const MeshLod& prev = mesh->lods[mesh->numLods - 1];
+      simplified.resize(prev.count);
+      float error = 0.0f;
+      size_t count = SimplifyMesh(simplified.data(),
+                                  mesh->indices.data() + prev.first,
+                                  prev.count, &mesh->verts[0].pos.x,
+                                  mesh->verts.size(), sizeof(MeshVertex),
+                                  (prev.count / 6) * 3, FLT_MAX, &error);
+
+      // Not worth a LOD unless it saves at least a quarter of the triangles
+      if (count > prev.count * 3 / 4) {
+        break;
+      }
+
+      // Appending indices. Errors only grow, since each LOD builds on the last.
+      MeshLod lod;
+      lod.first = static_cast<uint32_t>(mesh->indices.size());
+      lod.count = static_cast<uint32_t>(count);
+      lod.error = std::max(error, prev.error);
+      mesh->indices.insert(mesh->indices.end(), simplified.begin(),
+                           simplified.begin() + count);
+      mesh->lods[mesh->numLods++] = lod;
+      report << " -> " << count / 3 << " (" << lod.error << ")";
+    }
+    report << "\n";
+    std::cout << report.str();
+  }
+
+  // Runs the optimization stages over a mesh, reporting cache stats for the
+  // full detail LOD
+  void OptimizeMesh(const std::string& meshName, CookedMesh* mesh) {
+    size_t numIndices = mesh->indices.size();
+    size_t numVerts = mesh->verts.size();
+    if (numIndices == 0) {
+      return;
+    }
+
+    // Stats are gathered into one string so concurrent imports don't
+    // interleave their lines
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3) << meshName << ":\n";
+    const MeshLod& fullLod = mesh->lods[0];
+    VertCacheStats stats = AnalyzeVertCache(mesh->indices.data(),
+                                            fullLod.count, numVerts);
+    report << "  imported     ACMR " << stats.acmr
+           << "  ATVR " << stats.atvr << "\n";
+
+    // Reordering each LOD's triangles for vertex cache hits
+    std::vector<GLuint> reordered(numIndices);
+    for (uint32_t i = 0; i < mesh->numLods; ++i) {
+      const MeshLod& lod = mesh->lods[i];
+      OptimizeVertCache(reordered.data() + lod.first,
+                        mesh->indices.data() + lod.first, lod.count, numVerts);
+    }
+    stats = AnalyzeVertCache(reordered.data(), fullLod.count, numVerts);
+    report << "  vert cache   ACMR " << stats.acmr
+           << "  ATVR " << stats.atvr << "\n";
+
+    // Reordering each LOD's triangle clusters to reduce overdraw, giving up
+    // at most 5% of the cache improvement
+    for (uint32_t i = 0; i < mesh->numLods; ++i) {
+      const MeshLod& lod = mesh->lods[i];
+      OptimizeOverdraw(mesh->indices.data() + lod.first,
+                       reordered.data() + lod.first, lod.count,
+                       &mesh->verts[0].pos.x, numVerts, sizeof(MeshVertex),
+                       1.05f);
+    }
+    stats = AnalyzeVertCache(mesh->indices.data(), fullLod.count, numVerts);
+    report << "  overdraw     ACMR " << stats.acmr
+           << "  ATVR " << stats.atvr << "\n";
+
+    // Renumbering vertices in order of first use across every LOD, dropping
+    // unused ones. LOD 0 comes first, so its reads stay sequential.
+    std::vector<GLuint> remap(numVerts);
+    size_t numKept = OptimizeVertFetch(remap.data(), mesh->indices.data(),
+                                       numIndices, numVerts);
+    std::vector<MeshVertex> fetchOrder(numKept);
+    for (size_t i = 0; i < numVerts; ++i) {
+      if (remap[i] != ~0u) {
+        fetchOrder[remap[i]] = mesh->verts[i];
+      }
+    }
+    mesh->verts.swap(fetchOrder);
+    stats = AnalyzeVertCache(mesh->indices.data(), fullLod.count, numKept);
+    report << "  vert fetch   ACMR " << stats.acmr
+           << "  ATVR " << stats.atvr << "\n";
+
+    std::cout << report.str();
+  }
+
+  // Boxing the vertices, then growing a sphere from the box's center out to
+  // the furthest vertex. That's tighter than the sphere around the box.
+  void ComputeBounds(CookedMesh* mesh) {
+    if (mesh->verts.empty()) {
+      return;
+    }
+    glm::vec3 minPos = mesh->verts[0].pos;
+    glm::vec3 maxPos = minPos;
+    std::vector<MeshVertex>::const_iterator vertIter = mesh->verts.begin();
+    for (; vertIter != mesh->verts.end(); ++vertIter) {
+      minPos = glm::min(minPos, vertIter->pos);
+      maxPos = glm::max(maxPos, vertIter->pos);
+    }
+    glm::vec3 center = (minPos + maxPos) * 0.5f;
+    float radiusSq = 0.0f;
+    for (vertIter = mesh->verts.begin(); vertIter != mesh->verts.end();
+         ++vertIter) {
+      glm::vec3 offset = vertIter->pos - center;
+      radiusSq = glm::max(radiusSq, glm::dot(offset, offset));
+    }
+
+    MeshBounds* bounds = &mesh->bounds;
+    for (int axis = 0; axis < 3; ++axis) {
+      bounds->min[axis] = minPos[axis];
+      bounds->max[axis] = maxPos[axis];
+      bounds->center[axis] = center[axis];
+    }
+    bounds->radius = glm::sqrt(radiusSq);
+  }
+}
+
+// Reads, simplifies, optimizes, and bounds a mesh
+bool CookMesh(const std::string& filename, Assimp::Importer* importer,
+              CookedMesh* mesh) {
+  std::string meshName = filename.substr(0, filename.find("."));
+  ReadMesh(filename, importer, mesh);
+  if (mesh->verts.empty()) {
+    std::cerr << "No vertices read from " << filename << std::endl;
+    return false;
+  }
+  BuildLods(meshName, mesh);
+  OptimizeMesh(meshName, mesh);
+  ComputeBounds(mesh);
+  return true;
+}
+
+// Cooks a mesh and writes it out next to its source
+bool WriteCookedMesh(const std::string& filename,
+                     Assimp::Importer* importer) {
+  std::string meshName = filename.substr(0, filename.find("."));
+  std::string cookedPath = "mesh/" + meshName + ".mesh";
+  CookedMesh mesh;
+  if (!CookMesh(filename, importer, &mesh)) {
+    return false;
+  }
+
+  // Write vertex and index arrays exactly as they sit in memory
+  bool written = MeshFile::Write(cookedPath, "mesh/" + filename,
+                                 mesh.verts.data(), sizeof(MeshVertex),
+                                 static_cast<uint32_t>(mesh.verts.size()),
+                                 mesh.indices.data(),
+                                 static_cast<uint32_t>(mesh.indices.size()),
+                                 mesh.lods, mesh.numLods, mesh.bounds);
+  if (written) {
+    std::cout << filename << " -> " << cookedPath << " ("
+              << mesh.verts.size() << " verts, "
+              << mesh.indices.size() / 3 << " tris)" << std::endl;
+  }
+  return written;
+}
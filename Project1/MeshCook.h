@@ -0,0 +1,55 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Mesh cooking functions. These read a .DAE file with Assimp, simplify it
+// into levels of detail, optimize it, and find its bounds, all without
+// touching OpenGL. ModelManager runs them on import workers when a mesh has
+// no current cooked file, and the MeshCooker tool runs them to write one.
+#pragma once
+#ifndef MESH_COOK
+#define MESH_COOK
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+#include <assimp/Importer.hpp>
+
+#include <glm/glm.hpp>
+
+#include "MeshFile.h"
+
+// Vertex data. Holds 8 floats, 3 for position, 3 for normals, 2 for textures.
+// Written to cooked files exactly as laid out here.
+struct MeshVertex {
+  glm::vec3 pos = glm::vec3(0.0f);
+  glm::vec3 norm = glm::vec3(0.0f);
+  glm::vec2 uv = glm::vec2(0.0f);
+};
+
+// A cooked mesh: its vertices, the indices of every LOD one after another,
+// the LOD table indexing into them, and its local space bounds
+struct CookedMesh {
+  std::vector<MeshVertex> verts;
+  std::vector<GLuint> indices;
+  MeshLod lods[kMaxLods];
+  uint32_t numLods = 0;
+  MeshBounds bounds;
+};
+
+// Reads mesh/<filename> (must be DAE format), builds its LODs, optimizes
+// them, and finds its bounds, printing stats along the way. Returns false
+// after reporting it if no vertices could be read. Importers are not
+// thread safe, so each thread calling this needs its own.
+bool CookMesh(const std::string& filename, Assimp::Importer* importer,
+              CookedMesh* mesh);
+
+// Cooks mesh/<filename> and writes it to mesh/<name>.mesh, for
+// ModelManager::CreateMeshes to map at startup. Returns false if the mesh
+// couldn't be read or the file couldn't be written.
+bool WriteCookedMesh(const std::string& filename,
+                     Assimp::Importer* importer);
+#endif
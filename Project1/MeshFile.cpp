@@ -0,0 +1,230 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The MeshFile class reads and writes cooked meshes. A cooked mesh is a small
+// header followed by the raw vertex and index arrays exactly as they are laid
+// out in memory, so the file can be memory mapped and handed straight to
+// glBufferData with no parsing. Cooked files are written by the MeshCooker
+// tool and preferred by ModelManager::CreateMeshes when they are up to date.
+#include "MeshFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+  // Data arrays start on 16 byte boundaries so mapped pointers stay aligned
+  const uint32_t kDataAlign = 16;
+
+  uint32_t AlignUp(uint32_t val) {
+    return (val + kDataAlign - 1) & ~(kDataAlign - 1);
+  }
+
+  // Reads size and last write time of a source file. False if it's missing.
+  bool SourceStamp(const std::string& srcPath, uint64_t* srcSize,
+                   int64_t* srcTime) {
+    std::error_code err;
+    uint64_t fileSz = std::filesystem::file_size(srcPath, err);
+    if (err) {
+      return false;
+    }
+    auto writeTime = std::filesystem::last_write_time(srcPath, err);
+    if (err) {
+      return false;
+    }
+    *srcSize = fileSz;
+    *srcTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    return true;
+  }
+}  // namespace
+
+MeshFile::~MeshFile() {
+  Close();
+}
+
+// Maps file into memory and validates the header
+bool MeshFile::Open(const std::string& path) {
+  Close();
+
+#ifdef _WIN32
+  // Open file and create a read-only mapping of the whole thing
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  fileHandle = file;
+
+  LARGE_INTEGER fileSz;
+  if (!GetFileSizeEx(file, &fileSz) || fileSz.QuadPart == 0) {
+    Close();
+    return false;
+  }
+  size = static_cast<size_t>(fileSz.QuadPart);
+
+  mapHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapHandle == NULL) {
+    Close();
+    return false;
+  }
+  data = reinterpret_cast<const unsigned char*>(
+           MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+  // Open file and map the whole thing read-only
+  fileDesc = open(path.c_str(), O_RDONLY);
+  if (fileDesc == -1) {
+    return false;
+  }
+
+  struct stat fileStat;
+  if (fstat(fileDesc, &fileStat) != 0 || fileStat.st_size == 0) {
+    Close();
+    return false;
+  }
+  size = static_cast<size_t>(fileStat.st_size);
+
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDesc, 0);
+  if (mapped != MAP_FAILED) {
+    data = reinterpret_cast<const unsigned char*>(mapped);
+  }
+#endif
+
+  if (data == nullptr) {
+    Close();
+    return false;
+  }
+
+  // Validating header: magic, version, and that the arrays fit in the file
+  const MeshFileHeader* header = Header();
+  bool valid = size >= sizeof(MeshFileHeader) &&
+               std::memcmp(header->magic, "MESH", 4) == 0 &&
+               header->version == kMeshFileVersion &&
+               header->vertOffset + static_cast<uint64_t>(header->vertSz) *
+                 header->numVerts <= size &&
+               header->indexOffset + sizeof(GLuint) *
+                 static_cast<uint64_t>(header->numIndices) <= size &&
+               header->numLods > 0 && header->numLods <= kMaxLods;
+
+  // Every LOD range inside the index array, and every index naming a
+  // vertex, so bad data falls back to a DAE import instead of reaching
+  // CPU copies and draw calls
+  for (uint32_t i = 0; valid && i < header->numLods; ++i) {
+    valid = static_cast<uint64_t>(header->lods[i].first) +
+              header->lods[i].count <= header->numIndices;
+  }
+  const GLuint* indices = valid ? IndexData() : nullptr;
+  for (uint32_t i = 0; valid && i < header->numIndices; ++i) {
+    valid = indices[i] < header->numVerts;
+  }
+  if (!valid) {
+    std::cerr << "Stale or corrupt cooked mesh: " << path << std::endl;
+    Close();
+    return false;
+  }
+  return true;
+}
+
+// Releases mapping and file handles
+void MeshFile::Close() {
+#ifdef _WIN32
+  if (data != nullptr) {
+    UnmapViewOfFile(data);
+  }
+  if (mapHandle != nullptr) {
+    CloseHandle(mapHandle);
+  }
+  if (fileHandle != nullptr) {
+    CloseHandle(fileHandle);
+  }
+#else
+  if (data != nullptr) {
+    munmap(const_cast<unsigned char*>(data), size);
+  }
+  if (fileDesc != -1) {
+    close(fileDesc);
+  }
+#endif
+  data = nullptr;
+  size = 0;
+  fileHandle = nullptr;
+  mapHandle = nullptr;
+  fileDesc = -1;
+}
+
+// Compares stamp stored at cook time against the source file on disk
+bool MeshFile::IsCurrent(const std::string& srcPath) const {
+  if (data == nullptr) {
+    return false;
+  }
+  uint64_t srcSize = 0;
+  int64_t srcTime = 0;
+  if (!SourceStamp(srcPath, &srcSize, &srcTime)) {
+    return true;
+  }
+  return Header()->srcSize == srcSize && Header()->srcTime == srcTime;
+}
+
+const MeshFileHeader* MeshFile::Header() const {
+  return reinterpret_cast<const MeshFileHeader*>(data);
+}
+
+const void* MeshFile::VertData() const {
+  return data + Header()->vertOffset;
+}
+
+const GLuint* MeshFile::IndexData() const {
+  return reinterpret_cast<const GLuint*>(data + Header()->indexOffset);
+}
+
+// Writes header, then vertex and index arrays at aligned offsets
+bool MeshFile::Write(const std::string& path, const std::string& srcPath,
+                     const void* verts, uint32_t vertSz, uint32_t numVerts,
+                     const GLuint* indices, uint32_t numIndices,
+                     const MeshLod* lods, uint32_t numLods,
+                     const MeshBounds& bounds) {
+  MeshFileHeader header;
+  header.vertSz = vertSz;
+  header.numVerts = numVerts;
+  header.numIndices = numIndices;
+  header.numLods = numLods < kMaxLods ? numLods : kMaxLods;
+  for (uint32_t i = 0; i < header.numLods; ++i) {
+    header.lods[i] = lods[i];
+  }
+  header.bounds = bounds;
+  header.vertOffset = AlignUp(sizeof(MeshFileHeader));
+  header.indexOffset = AlignUp(header.vertOffset + vertSz * numVerts);
+  SourceStamp(srcPath, &header.srcSize, &header.srcTime);
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    std::cerr << "Could not open for writing: " << path << std::endl;
+    return false;
+  }
+
+  // Zero padding between sections
+  const char padding[kDataAlign] = {};
+
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(padding, header.vertOffset - sizeof(header));
+  out.write(reinterpret_cast<const char*>(verts),
+            static_cast<std::streamsize>(vertSz) * numVerts);
+  out.write(padding,
+            header.indexOffset - (header.vertOffset + vertSz * numVerts));
+  out.write(reinterpret_cast<const char*>(indices),
+            static_cast<std::streamsize>(sizeof(GLuint)) * numIndices);
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,107 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The MeshFile class reads and writes cooked meshes. A cooked mesh is a small
+// header followed by the raw vertex and index arrays exactly as they are laid
+// out in memory, so the file can be memory mapped and handed straight to
+// glBufferData with no parsing. Cooked files are written by the MeshCooker
+// tool and preferred by ModelManager::CreateMeshes when they are up to date.
+#pragma once
+#ifndef MESH_FILE
+#define MESH_FILE
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+
+// Bump whenever the layout of the header or the data following it changes.
+// Files with any other version are treated as stale and re-imported.
+// Version 2: contents are run through MeshOptimizer before writing.
+// Version 3: LOD table in header, LOD index ranges appended to indices.
+// Version 4: local space bounds in header.
+const uint32_t kMeshFileVersion = 4;
+
+// Most levels of detail a mesh can have, including the full mesh (LOD 0)
+const uint32_t kMaxLods = 4;
+
+// One level of detail: a range of the mesh's index array, and the largest
+// distance (in model units) its surface strays from the full mesh
+struct MeshLod {
+  uint32_t first = 0;
+  uint32_t count = 0;
+  float error = 0.0f;
+};
+
+// Local space bounds of a mesh's vertices: an axis-aligned box, and a
+// sphere around the box's center that encloses every vertex
+struct MeshBounds {
+  float min[3] = { 0.0f, 0.0f, 0.0f };
+  float max[3] = { 0.0f, 0.0f, 0.0f };
+  float center[3] = { 0.0f, 0.0f, 0.0f };
+  float radius = 0.0f;
+};
+
+// On-disk header. Vertex and index data follow at the given byte offsets.
+struct MeshFileHeader {
+  char magic[4] = { 'M', 'E', 'S', 'H' };
+  uint32_t version = kMeshFileVersion;
+  uint32_t vertSz = 0;       // bytes per vertex
+  uint32_t numVerts = 0;
+  uint32_t numIndices = 0;   // 32-bit indices
+  uint32_t vertOffset = 0;   // byte offset of vertex data from file start
+  uint32_t indexOffset = 0;  // byte offset of index data from file start
+  uint32_t reserved = 0;
+  uint64_t srcSize = 0;      // size of the source file when cooked
+  int64_t srcTime = 0;       // last write time of the source when cooked
+  uint32_t numLods = 0;
+  MeshLod lods[kMaxLods];
+  MeshBounds bounds;
+};
+
+// Read-only, memory mapped view of a cooked mesh file.
+class MeshFile {
+ private:
+  // Mapped file contents and size in bytes
+  const unsigned char* data = nullptr;
+  size_t size = 0;
+
+  // Platform handles for the open file and its mapping
+  void* fileHandle = nullptr;
+  void* mapHandle = nullptr;
+  int fileDesc = -1;
+
+ public:
+  MeshFile() = default;
+  ~MeshFile();
+
+  // A mapping has exactly one owner
+  MeshFile(const MeshFile&) = delete;
+  MeshFile& operator=(const MeshFile&) = delete;
+
+  // Maps a cooked file. Returns false if it is missing, truncated, or was
+  // written with a different version.
+  bool Open(const std::string& path);
+
+  // Unmaps the file. Pointers handed out by the accessors become invalid.
+  void Close();
+
+  // True if the file was cooked from srcPath as it is now. A missing source
+  // counts as current so cooked meshes can ship without their DAE files.
+  bool IsCurrent(const std::string& srcPath) const;
+
+  // Accessors for the mapped header and arrays
+  const MeshFileHeader* Header() const;
+  const void* VertData() const;
+  const GLuint* IndexData() const;
+
+  // Writes a cooked mesh for srcPath to path. Returns false on failure.
+  static bool Write(const std::string& path, const std::string& srcPath,
+                    const void* verts, uint32_t vertSz, uint32_t numVerts,
+                    const GLuint* indices, uint32_t numIndices,
+                    const MeshLod* lods, uint32_t numLods,
+                    const MeshBounds& bounds);
+};
+#endif
@@ -0,0 +1,315 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Mesh optimization functions. These reorder index and vertex data without
+// changing what's drawn, so the GPU runs the vertex shader fewer times and
+// reads vertex memory in order. They work on plain index arrays and
+// positions so they can run on import worker threads and in MeshCooker.
+// Run them in order: vertex cache, then overdraw, then vertex fetch.
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace {
+  // FIFO post-transform cache simulation. Timestamps rather than a queue:
+  // a vertex is cached if it was last loaded within the last kVertCacheSz
+  // misses.
+  class FifoCache {
+   private:
+    std::vector<size_t> loadTime;
+    size_t time = kVertCacheSz + 1;
+
+   public:
+    explicit FifoCache(size_t numVerts) : loadTime(numVerts, 0) {}
+
+    // Looks up a vertex, loading it on a miss. Returns 1 on miss, 0 on hit.
+    int Access(GLuint vert) {
+      if (time - loadTime[vert] > kVertCacheSz) {
+        loadTime[vert] = time++;
+        return 1;
+      }
+      return 0;
+    }
+
+    // Empties the cache
+    void Flush() {
+      time += kVertCacheSz + 1;
+    }
+  };
+
+  // Triangles that use each vertex, as one flat array with offsets
+  struct Adjacency {
+    std::vector<size_t> offsets;   // numVerts + 1 entries
+    std::vector<GLuint> tris;      // triangle indices
+    std::vector<GLuint> liveTris;  // unemitted triangles per vertex
+  };
+
+  void BuildAdjacency(const GLuint* indices, size_t numIndices,
+                      size_t numVerts, Adjacency* adj) {
+    adj->offsets.assign(numVerts + 1, 0);
+    adj->liveTris.assign(numVerts, 0);
+    for (size_t i = 0; i < numIndices; ++i) {
+      ++adj->liveTris[indices[i]];
+    }
+    for (size_t v = 0; v < numVerts; ++v) {
+      adj->offsets[v + 1] = adj->offsets[v] + adj->liveTris[v];
+    }
+    adj->tris.resize(numIndices);
+    std::vector<size_t> fill(adj->offsets.begin(), adj->offsets.end() - 1);
+    for (size_t i = 0; i < numIndices; ++i) {
+      adj->tris[fill[indices[i]]++] = static_cast<GLuint>(i / 3);
+    }
+  }
+}  // namespace
+
+// Counts misses in a FIFO cache over every triangle
+VertCacheStats AnalyzeVertCache(const GLuint* indices, size_t numIndices,
+                                size_t numVerts) {
+  // ACMR is per triangle, so there's nothing to measure without one
+  VertCacheStats stats;
+  if (numIndices < 3 || numVerts == 0) {
+    return stats;
+  }
+
+  FifoCache cache(numVerts);
+  std::vector<bool> used(numVerts, false);
+  size_t misses = 0;
+  size_t numUsed = 0;
+  for (size_t i = 0; i < numIndices; ++i) {
+    misses += cache.Access(indices[i]);
+    if (!used[indices[i]]) {
+      used[indices[i]] = true;
+      ++numUsed;
+    }
+  }
+
+  stats.acmr = static_cast<float>(misses) / (numIndices / 3);
+  stats.atvr = static_cast<float>(misses) / numUsed;
+  return stats;
+}
+
+// Tipsify: fan out around a vertex, emitting all its remaining triangles,
+// then move to the candidate vertex that will still be in cache after its
+// own triangles are emitted. Dead ends fall back to recently used vertices,
+// then to the next vertex in input order.
+void OptimizeVertCache(GLuint* dst, const GLuint* indices, size_t numIndices,
+                       size_t numVerts) {
+  if (numIndices == 0) {
+    return;
+  }
+
+  Adjacency adj;
+  BuildAdjacency(indices, numIndices, numVerts, &adj);
+
+  // Cache timestamps, emitted flags, and dead-end stack
+  std::vector<size_t> cacheTime(numVerts, 0);
+  std::vector<bool> emitted(numIndices / 3, false);
+  std::vector<GLuint> deadEnd;
+  std::vector<GLuint> candidates;
+  size_t time = kVertCacheSz + 1;
+  size_t inputCursor = 0;
+  size_t outIdx = 0;
+
+  // Fanning vertex, -1 once every triangle is out
+  long long fanVert = indices[0];
+  while (fanVert >= 0) {
+    candidates.clear();
+
+    // Emit every live triangle around the fanning vertex
+    for (size_t a = adj.offsets[fanVert]; a < adj.offsets[fanVert + 1]; ++a) {
+      GLuint tri = adj.tris[a];
+      if (emitted[tri]) {
+        continue;
+      }
+      for (int c = 0; c < 3; ++c) {
+        GLuint vert = indices[tri * 3 + c];
+        dst[outIdx++] = vert;
+        deadEnd.push_back(vert);
+        candidates.push_back(vert);
+        --adj.liveTris[vert];
+        if (time - cacheTime[vert] > kVertCacheSz) {
+          cacheTime[vert] = time++;
+        }
+      }
+      emitted[tri] = true;
+    }
+
+    // Pick the candidate furthest into the cache that will stay cached
+    // through its own fan; otherwise any candidate with work left
+    long long nextVert = -1;
+    long long bestPriority = -1;
+    std::vector<GLuint>::iterator candIter = candidates.begin();
+    for (; candIter != candidates.end(); ++candIter) {
+      GLuint vert = *candIter;
+      if (adj.liveTris[vert] == 0) {
+        continue;
+      }
+      long long priority = 0;
+      long long age = static_cast<long long>(time - cacheTime[vert]);
+      if (age + 2 * static_cast<long long>(adj.liveTris[vert]) <=
+          static_cast<long long>(kVertCacheSz)) {
+        priority = age;
+      }
+      if (priority > bestPriority) {
+        bestPriority = priority;
+        nextVert = vert;
+      }
+    }
+
+    // Dead end: recently touched vertices first, then input order
+    while (nextVert == -1 && !deadEnd.empty()) {
+      GLuint vert = deadEnd.back();
+      deadEnd.pop_back();
+      if (adj.liveTris[vert] > 0) {
+        nextVert = vert;
+      }
+    }
+    while (nextVert == -1 && inputCursor < numVerts) {
+      if (adj.liveTris[inputCursor] > 0) {
+        nextVert = static_cast<long long>(inputCursor);
+      }
+      ++inputCursor;
+    }
+    fanVert = nextVert;
+  }
+}
+
+// Splits triangles into clusters at points that barely hurt cache
+// efficiency, then sorts clusters by how much they face away from the
+// mesh's center
+void OptimizeOverdraw(GLuint* dst, const GLuint* indices, size_t numIndices,
+                      const float* positions, size_t numVerts,
+                      size_t posStride, float threshold) {
+  size_t numTris = numIndices / 3;
+  if (numTris == 0) {
+    return;
+  }
+
+  // Position of a vertex from the strided array
+  const unsigned char* posBytes =
+    reinterpret_cast<const unsigned char*>(positions);
+  auto position = [posBytes, posStride](GLuint vert) {
+    const float* pos =
+      reinterpret_cast<const float*>(posBytes + vert * posStride);
+    return glm::vec3(pos[0], pos[1], pos[2]);
+  };
+
+  // Hard boundaries: triangles that miss the cache on all three vertices
+  // start a new strip, so splitting there costs nothing
+  std::vector<size_t> hardStarts;
+  FifoCache cache(numVerts);
+  for (size_t t = 0; t < numTris; ++t) {
+    int misses = cache.Access(indices[t * 3]) +
+                 cache.Access(indices[t * 3 + 1]) +
+                 cache.Access(indices[t * 3 + 2]);
+    if (t == 0 || misses == 3) {
+      hardStarts.push_back(t);
+    }
+  }
+  hardStarts.push_back(numTris);
+
+  // Soft boundaries: within each hard cluster, split wherever the running
+  // ACMR has dropped to within threshold of the whole cluster's ACMR
+  std::vector<size_t> clusterStarts;
+  for (size_t h = 0; h + 1 < hardStarts.size(); ++h) {
+    size_t start = hardStarts[h];
+    size_t end = hardStarts[h + 1];
+
+    // Whole cluster's ACMR from a cold cache
+    cache.Flush();
+    size_t clusterMisses = 0;
+    for (size_t i = start * 3; i < end * 3; ++i) {
+      clusterMisses += cache.Access(indices[i]);
+    }
+    float clusterAcmr = static_cast<float>(clusterMisses) / (end - start);
+
+    // Splitting from a cold cache each time one is made
+    cache.Flush();
+    size_t runStart = start;
+    size_t runMisses = 0;
+    clusterStarts.push_back(start);
+    for (size_t t = start; t < end; ++t) {
+      runMisses += cache.Access(indices[t * 3]) +
+                   cache.Access(indices[t * 3 + 1]) +
+                   cache.Access(indices[t * 3 + 2]);
+      float runAcmr = static_cast<float>(runMisses) / (t + 1 - runStart);
+      if (t + 1 < end && runAcmr <= clusterAcmr * threshold) {
+        clusterStarts.push_back(t + 1);
+        runStart = t + 1;
+        runMisses = 0;
+        cache.Flush();
+      }
+    }
+  }
+  size_t numClusters = clusterStarts.size();
+  clusterStarts.push_back(numTris);
+
+  // Area weighted centroid and normal of each cluster, and of the mesh
+  std::vector<glm::vec3> centroids(numClusters, glm::vec3(0.0f));
+  std::vector<glm::vec3> normals(numClusters, glm::vec3(0.0f));
+  glm::vec3 meshCentroid = glm::vec3(0.0f);
+  float meshArea = 0.0f;
+  for (size_t c = 0; c < numClusters; ++c) {
+    float clusterArea = 0.0f;
+    for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+      glm::vec3 p0 = position(indices[t * 3]);
+      glm::vec3 p1 = position(indices[t * 3 + 1]);
+      glm::vec3 p2 = position(indices[t * 3 + 2]);
+      glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+      float area = glm::length(cross);
+      centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+      normals[c] += cross;
+      clusterArea += area;
+    }
+    meshCentroid += centroids[c];
+    meshArea += clusterArea;
+    centroids[c] /= clusterArea > 0.0f ? clusterArea : 1.0f;
+  }
+  meshCentroid /= meshArea > 0.0f ? meshArea : 1.0f;
+
+  // Clusters that face out from the center sort first
+  std::vector<float> sortKeys(numClusters);
+  std::vector<size_t> order(numClusters);
+  for (size_t c = 0; c < numClusters; ++c) {
+    float normLen = glm::length(normals[c]);
+    glm::vec3 normal = normLen > 0.0f ? normals[c] / normLen : normals[c];
+    sortKeys[c] = glm::dot(centroids[c] - meshCentroid, normal);
+    order[c] = c;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&sortKeys](size_t a, size_t b) {
+                     return sortKeys[a] > sortKeys[b];
+                   });
+
+  // Emitting clusters in sorted order
+  size_t outIdx = 0;
+  for (size_t c = 0; c < numClusters; ++c) {
+    size_t cluster = order[c];
+    for (size_t t = clusterStarts[cluster];
+         t < clusterStarts[cluster + 1]; ++t) {
+      dst[outIdx++] = indices[t * 3];
+      dst[outIdx++] = indices[t * 3 + 1];
+      dst[outIdx++] = indices[t * 3 + 2];
+    }
+  }
+}
+
+// Assigns new vertex indices in order of first use
+size_t OptimizeVertFetch(GLuint* remap, GLuint* indices, size_t numIndices,
+                         size_t numVerts) {
+  std::fill(remap, remap + numVerts, ~0u);
+  GLuint nextVert = 0;
+  for (size_t i = 0; i < numIndices; ++i) {
+    GLuint* newIdx = &remap[indices[i]];
+    if (*newIdx == ~0u) {
+      *newIdx = nextVert++;
+    }
+    indices[i] = *newIdx;
+  }
+  return nextVert;
+}
@@ -0,0 +1,271 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Mesh simplification for generating levels of detail. Triangles are removed
+// by collapsing edges, cheapest first, where cost is the quadric error
+// (Garland and Heckbert 1997): the squared distance from the new position to
+// the planes of the triangles that used to meet there. Collapses only ever
+// move a vertex onto a neighbor, so simplified meshes index the original
+// vertex array and every LOD can share one vertex buffer.
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace {
+  // Symmetric 4x4 error quadric: the upper triangle of the sum of
+  // plane * plane^T over every plane (a, b, c, d) added to it
+  struct Quadric {
+    double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+    double b2 = 0.0, bc = 0.0, bd = 0.0;
+    double c2 = 0.0, cd = 0.0;
+    double d2 = 0.0;
+  };
+
+  // Adds plane n.p + d = 0 to a quadric
+  void AddPlane(Quadric* q, glm::dvec3 n, double d) {
+    q->a2 += n.x * n.x; q->ab += n.x * n.y; q->ac += n.x * n.z;
+    q->ad += n.x * d;   q->b2 += n.y * n.y; q->bc += n.y * n.z;
+    q->bd += n.y * d;   q->c2 += n.z * n.z; q->cd += n.z * d;
+    q->d2 += d * d;
+  }
+
+  // Adds one quadric to another
+  void AddQuadric(Quadric* q, const Quadric& r) {
+    q->a2 += r.a2; q->ab += r.ab; q->ac += r.ac; q->ad += r.ad;
+    q->b2 += r.b2; q->bc += r.bc; q->bd += r.bd;
+    q->c2 += r.c2; q->cd += r.cd;
+    q->d2 += r.d2;
+  }
+
+  // Sum of squared distances from p to the quadric's planes
+  double Evaluate(const Quadric& q, glm::dvec3 p) {
+    double err = q.a2 * p.x * p.x + q.b2 * p.y * p.y + q.c2 * p.z * p.z +
+                 2.0 * (q.ab * p.x * p.y + q.ac * p.x * p.z +
+                        q.bc * p.y * p.z) +
+                 2.0 * (q.ad * p.x + q.bd * p.y + q.cd * p.z) + q.d2;
+    return err > 0.0 ? err : 0.0;
+  }
+
+  // Moving src onto dst, with its cost
+  struct Collapse {
+    double cost = 0.0;
+    GLuint src = 0;
+    GLuint dst = 0;
+  };
+}  // namespace
+
+// Repeated passes of independent edge collapses, cheapest first, until the
+// target count or error limit is reached
+size_t SimplifyMesh(GLuint* dst, const GLuint* indices, size_t numIndices,
+                    const float* positions, size_t numVerts,
+                    size_t posStride, size_t targetIndices, float maxError,
+                    float* resultError) {
+  *resultError = 0.0f;
+
+  // Position of a vertex from the strided array
+  std::vector<glm::dvec3> pos(numVerts);
+  const unsigned char* posBytes =
+    reinterpret_cast<const unsigned char*>(positions);
+  for (size_t v = 0; v < numVerts; ++v) {
+    const float* p =
+      reinterpret_cast<const float*>(posBytes + v * posStride);
+    pos[v] = glm::dvec3(p[0], p[1], p[2]);
+  }
+
+  // Welding vertices by position. Vertices that share a position with
+  // another have a seam through them and are locked.
+  std::vector<GLuint> posId(numVerts);
+  std::vector<bool> locked(numVerts, false);
+  std::map<std::array<float, 3>, GLuint> posIds;
+  std::vector<int> posUses;
+  for (size_t v = 0; v < numVerts; ++v) {
+    std::array<float, 3> key = { static_cast<float>(pos[v].x),
+                                 static_cast<float>(pos[v].y),
+                                 static_cast<float>(pos[v].z) };
+    std::map<std::array<float, 3>, GLuint>::iterator found =
+      posIds.find(key);
+    if (found == posIds.end()) {
+      found = posIds.emplace(key, static_cast<GLuint>(posUses.size())).first;
+      posUses.push_back(0);
+    }
+    posId[v] = found->second;
+    ++posUses[found->second];
+  }
+  for (size_t v = 0; v < numVerts; ++v) {
+    locked[v] = posUses[posId[v]] > 1;
+  }
+
+  // Locking vertices on open borders: edges (between welded positions)
+  // used by exactly one triangle. Non-manifold edges lock too.
+  std::map<std::pair<GLuint, GLuint>, int> edgeUses;
+  for (size_t i = 0; i < numIndices; i += 3) {
+    for (int e = 0; e < 3; ++e) {
+      GLuint a = posId[indices[i + e]];
+      GLuint b = posId[indices[i + (e + 1) % 3]];
+      ++edgeUses[std::make_pair(std::min(a, b), std::max(a, b))];
+    }
+  }
+  for (size_t i = 0; i < numIndices; i += 3) {
+    for (int e = 0; e < 3; ++e) {
+      GLuint va = indices[i + e];
+      GLuint vb = indices[i + (e + 1) % 3];
+      GLuint a = posId[va];
+      GLuint b = posId[vb];
+      if (edgeUses[std::make_pair(std::min(a, b), std::max(a, b))] != 2) {
+        locked[va] = true;
+        locked[vb] = true;
+      }
+    }
+  }
+
+  // Each vertex starts with the planes of the triangles around it
+  std::vector<Quadric> quadrics(numVerts);
+  for (size_t i = 0; i < numIndices; i += 3) {
+    glm::dvec3 p0 = pos[indices[i]];
+    glm::dvec3 cross = glm::cross(pos[indices[i + 1]] - p0,
+                                  pos[indices[i + 2]] - p0);
+    double len = glm::length(cross);
+    if (len == 0.0) {
+      continue;
+    }
+    glm::dvec3 n = cross / len;
+    double d = -glm::dot(n, p0);
+    for (int c = 0; c < 3; ++c) {
+      AddPlane(&quadrics[indices[i + c]], n, d);
+    }
+  }
+
+  std::vector<GLuint> current(indices, indices + numIndices);
+  double maxCost = static_cast<double>(maxError) * maxError;
+  double appliedCost = 0.0;
+
+  while (current.size() > targetIndices) {
+    // Triangles around each vertex, for flip checks and rewriting
+    std::vector<size_t> triStart(numVerts + 1, 0);
+    for (size_t i = 0; i < current.size(); ++i) {
+      ++triStart[current[i] + 1];
+    }
+    for (size_t v = 0; v < numVerts; ++v) {
+      triStart[v + 1] += triStart[v];
+    }
+    std::vector<size_t> vertTris(current.size());
+    std::vector<size_t> fill(triStart.begin(), triStart.end() - 1);
+    for (size_t i = 0; i < current.size(); ++i) {
+      vertTris[fill[current[i]]++] = i / 3;
+    }
+
+    // Every edge, collapsed in whichever direction is allowed and cheaper
+    std::vector<Collapse> collapses;
+    for (size_t i = 0; i < current.size(); i += 3) {
+      for (int e = 0; e < 3; ++e) {
+        GLuint a = current[i + e];
+        GLuint b = current[i + (e + 1) % 3];
+        Collapse best;
+        best.cost = -1.0;
+        if (!locked[a]) {
+          best = Collapse{ Evaluate(quadrics[a], pos[b]), a, b };
+        }
+        if (!locked[b]) {
+          double cost = Evaluate(quadrics[b], pos[a]);
+          if (best.cost < 0.0 || cost < best.cost) {
+            best = Collapse{ cost, b, a };
+          }
+        }
+        if (best.cost >= 0.0 && best.cost <= maxCost) {
+          collapses.push_back(best);
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse& a, const Collapse& b) {
+                return a.cost < b.cost;
+              });
+
+    // Applying collapses that don't share a triangle with one already made
+    // this pass, so each flip check sees up to date geometry
+    std::vector<bool> touched(numVerts, false);
+    size_t numLeft = current.size();
+    bool collapsed = false;
+    std::vector<Collapse>::iterator colIter = collapses.begin();
+    for (; colIter != collapses.end() && numLeft > targetIndices;
+         ++colIter) {
+      GLuint src = colIter->src;
+      GLuint dstVert = colIter->dst;
+      if (touched[src] || touched[dstVert]) {
+        continue;
+      }
+
+      // Rejecting collapses that would flip a triangle over
+      bool flips = false;
+      for (size_t a = triStart[src]; a < triStart[src + 1] && !flips; ++a) {
+        size_t tri = vertTris[a] * 3;
+        GLuint v0 = current[tri];
+        GLuint v1 = current[tri + 1];
+        GLuint v2 = current[tri + 2];
+        if (v0 == dstVert || v1 == dstVert || v2 == dstVert) {
+          continue;
+        }
+        glm::dvec3 before = glm::cross(pos[v1] - pos[v0], pos[v2] - pos[v0]);
+        glm::dvec3 p0 = v0 == src ? pos[dstVert] : pos[v0];
+        glm::dvec3 p1 = v1 == src ? pos[dstVert] : pos[v1];
+        glm::dvec3 p2 = v2 == src ? pos[dstVert] : pos[v2];
+        glm::dvec3 after = glm::cross(p1 - p0, p2 - p0);
+        flips = glm::dot(before, after) <= 0.0;
+      }
+      if (flips) {
+        continue;
+      }
+
+      // Moving src onto dst in every triangle around it
+      for (size_t a = triStart[src]; a < triStart[src + 1]; ++a) {
+        size_t tri = vertTris[a] * 3;
+        bool degenerate = false;
+        for (int c = 0; c < 3; ++c) {
+          touched[current[tri + c]] = true;
+          degenerate = degenerate || current[tri + c] == dstVert;
+        }
+        for (int c = 0; c < 3; ++c) {
+          if (current[tri + c] == src) {
+            current[tri + c] = dstVert;
+          }
+        }
+        if (degenerate) {
+          numLeft -= 3;
+        }
+      }
+      AddQuadric(&quadrics[dstVert], quadrics[src]);
+      appliedCost = std::max(appliedCost, colIter->cost);
+      collapsed = true;
+    }
+
+    // Dropping triangles that collapsed to a line
+    size_t outIdx = 0;
+    for (size_t i = 0; i < current.size(); i += 3) {
+      GLuint v0 = current[i];
+      GLuint v1 = current[i + 1];
+      GLuint v2 = current[i + 2];
+      if (v0 != v1 && v1 != v2 && v0 != v2) {
+        current[outIdx++] = v0;
+        current[outIdx++] = v1;
+        current[outIdx++] = v2;
+      }
+    }
+    current.resize(outIdx);
+
+    if (!collapsed) {
+      break;
+    }
+  }
+
+  std::copy(current.begin(), current.end(), dst);
+  *resultError = static_cast<float>(glm::sqrt(appliedCost));
+  return current.size();
+}
@@ -0,0 +1,31 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Mesh simplification for generating levels of detail. Triangles are removed
+// by collapsing edges, cheapest first, where cost is the quadric error
+// (Garland and Heckbert 1997): the squared distance from the new position to
+// the planes of the triangles that used to meet there. Collapses only ever
+// move a vertex onto a neighbor, so simplified meshes index the original
+// vertex array and every LOD can share one vertex buffer.
+#pragma once
+#ifndef MESH_SIMP
+#define MESH_SIMP
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+// Simplifies indices down to at most targetIndices, stopping early if the
+// next collapse would move the surface further than maxError (in model
+// units). Vertices on open borders or UV/normal seams never move, so the
+// outline and texture mapping hold up. positions points at the first
+// vertex's x, with posStride bytes between vertices. Writes the result to
+// dst (which may be indices), stores the largest error introduced in
+// resultError, and returns the number of indices written.
+size_t SimplifyMesh(GLuint* dst, const GLuint* indices, size_t numIndices,
+                    const float* positions, size_t numVerts,
+                    size_t posStride, size_t targetIndices, float maxError,
+                    float* resultError);
+#endif
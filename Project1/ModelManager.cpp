@@ -8,170 +8,522 @@
 // been completed. All products are held privately and inaccessible to prevent
 // the temptation to manipulate them directly.
 #include "ModelManager.h"
+#include "FrustumCull.h"
+#include "GpuProfiler.h"
+#include "MeshFile.h"
+#include "OcclusionCull.h"
+#include "Profiler.h"
 #include "WindowManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <sstream>
+
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtx/transform.hpp>
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #endif
 
-// Creates meshes given a vector of filenames of .DAE files to load
+namespace {
+  // Sampler uniforms and uniform blocks, hashed at compile time
+  constexpr UniformId kDiffSamp = HashUniform("diffSamp");
+  constexpr UniformId kSpecSamp = HashUniform("specSamp");
+  constexpr UniformId kMatData = HashUniform("matData");
+  constexpr UniformId kObjData = HashUniform("objData");
+
+  // Uniform buffer binding points of the material and per-object blocks.
+  // 0 and 1 are the light blocks, 2 is the camera's.
+  const GLuint kMatDataBinding = 3;
+  const GLuint kObjDataBinding = 4;
+
+  // Per-frame uniform bytes to start the ring with. It grows as needed.
+  const GLsizeiptr kRingFrameSize = 16 * 1024;
+
+  // Material block, laid out to match matData in the shaders (std140).
+  // Textured models only use gloss.
+  struct MaterialData {
+    glm::vec3 amb = glm::vec3(0.0f);
+    float pad0 = 0.0f;
+    glm::vec3 diff = glm::vec3(0.0f);
+    float pad1 = 0.0f;
+    glm::vec3 spec = glm::vec3(0.0f);
+    float gloss = 0.0f;
+  };
+
+  // One instance's entry in the per-object block's array, laid out to
+  // match ObjData in the shaders (std140). A mat3's columns are each
+  // padded out to a vec4.
+  struct ObjectData {
+    glm::mat4 modelMat = glm::mat4(1.0f);
+    glm::vec4 normMat[3];
+    GLint octNorm = 0;
+    GLint pad[3] = {};
+  };
+  static_assert(sizeof(ObjectData) == 128,
+                "ObjectData no longer matches the std140 ObjData layout");
+
+  // Instances per draw call. Must match MAX_INSTANCES in the vertex
+  // shaders; 128 entries fill the 16KB uniform block every GL 3.3
+  // implementation supports.
+  const uint32_t kMaxInstances = 128;
+  const GLsizeiptr kObjBlockSize = kMaxInstances * sizeof(ObjectData);
+
+  // Below this many models, testing every box with CullBoxes beats walking
+  // the scene BVH
+  const uint32_t kBvhMinModels = 64;
+
+  // Fewest models worth giving a draw slice, and so a thread, of their own
+  const uint32_t kMinSliceModels = 512;
+}  // namespace
+
+// Creates meshes given a vector of filenames of .DAE files to load.
+// Files are first keyed by content on worker threads, so each unique mesh
+// is imported once. Each import is a job, with an Assimp importer per
+// thread. A finished import queues a main thread job that loads it into
+// OpenGL, so meshes load in the order they finish while the rest keep
+// importing. Names are given once everything is loaded.
 void ModelManager::CreateMeshes(std::vector<std::string> filenames) {
-  // Iterator for mesh files
-  std::vector<std::string>::iterator fileIter = filenames.begin();
+  // Cooked vertices are uploaded as-is, so layouts must match
+  static_assert(sizeof(Vertex) == 8 * sizeof(GLfloat),
+                "Vertex layout no longer matches cooked mesh files");
 
-  // Iterate over filename vector to the end
+  // Unique mesh files, by canonical path, and which one each filename
+  // refers to
+  std::vector<std::string> meshFiles;
+  std::map<std::string, size_t> fileIndices;
+  std::vector<size_t> nameFiles;
+  std::vector<std::string>::iterator fileIter = filenames.begin();
   for (; fileIter != filenames.end(); ++fileIter) {
-    // Getting filename, creating blank mesh
-    std::string filename = *fileIter;
-    Mesh mesh;
+    std::error_code err;
+    std::string canonPath =
+      std::filesystem::weakly_canonical("mesh/" + *fileIter, err).string();
+    if (err) {
+      canonPath = "mesh/" + *fileIter;
+    }
+    std::map<std::string, size_t>::iterator found = fileIndices.find(canonPath);
+    if (found == fileIndices.end()) {
+      found = fileIndices.emplace(canonPath, meshFiles.size()).first;
+      meshFiles.push_back(*fileIter);
+    }
+    nameFiles.push_back(found->second);
+  }
+  size_t numFiles = meshFiles.size();
 
-    // Read and Load mesh
-    ReadMesh(filename, &mesh);
-    LoadMesh(&mesh);
+  // Keying every unique file by its contents, without decoding any
+  std::vector<MeshImport> results(numFiles);
+  jobs.ParallelFor(static_cast<uint32_t>(numFiles),
+                   [this, &meshFiles, &results](uint32_t begin,
+                                                uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      OpenMesh(meshFiles[i], &results[i]);
+    }
+  });
 
-    // Store mesh with name
-    std::string meshName = filename.substr(0, filename.find("."));
-    meshes[meshName] = mesh;
+  // Contents some name wants kept as an occluder
+  std::set<uint64_t> occluderKeys;
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    std::string meshName = filenames[i].substr(0, filenames[i].find("."));
+    if (occluderNames.count(meshName) != 0) {
+      occluderKeys.insert(results[nameFiles[i]].mesh.assetKey);
+    }
+  }
+
+  // Only the first file with given contents is imported, and none if they
+  // are already loaded, unless that mesh lacks occluder triangles now
+  // wanted. Failures go ahead so LoadImport reports them.
+  std::vector<uint64_t> fileKeys(numFiles);
+  std::set<uint64_t> claimed;
+  std::vector<size_t> imports;
+  for (size_t i = 0; i < numFiles; ++i) {
+    MeshImport& result = results[i];
+    fileKeys[i] = result.mesh.assetKey;
+    result.occluder = occluderKeys.count(fileKeys[i]) != 0;
+    bool needed = result.failed || claimed.insert(fileKeys[i]).second;
+    const MeshHandle* loaded = meshRegistry.Find(fileKeys[i]);
+    if (needed && !result.failed && loaded != nullptr) {
+      uint32_t meshIdx = meshPool.handles.Dense(*loaded);
+      needed = result.occluder && meshPool.occluderTris[meshIdx].empty();
+    }
+    if (needed) {
+      imports.push_back(i);
+    } else {
+      result = MeshImport();
+    }
+  }
+
+  // Importers are made lazily, by the first import each thread runs
+  std::vector<std::unique_ptr<Assimp::Importer>> importers(jobs.NumThreads());
+  JobSystem::Counter loaded;
+  std::vector<size_t>::iterator importIter = imports.begin();
+  for (; importIter != imports.end(); ++importIter) {
+    size_t i = *importIter;
+    jobs.Run([this, &importers, &results, &loaded, i] {
+      std::unique_ptr<Assimp::Importer>& importer =
+        importers[JobSystem::ThreadIndex()];
+      if (!importer) {
+        importer = std::make_unique<Assimp::Importer>();
+      }
+      ImportMesh(importer.get(), &results[i]);
+      jobs.Run([this, &results, i] { LoadImport(&results[i]); }, &loaded,
+               nullptr, JobSystem::MAIN_THREAD);
+    }, &loaded);
+  }
+  jobs.Wait(&loaded);
+
+  // Naming each filename's mesh; every name holds a reference. Files that
+  // failed have nothing registered, so their names are left out.
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    std::string meshName = filenames[i].substr(0, filenames[i].find("."));
+    MeshHandle* handle = meshRegistry.Acquire(fileKeys[nameFiles[i]]);
+    if (handle != nullptr) {
+      meshNames[meshName] = *handle;
+    }
+  }
+  std::cout << filenames.size() << " mesh names, " << numFiles
+            << " unique files, " << imports.size() << " imported"
+            << std::endl;
+
+  // Reporting what compact vertices and 16-bit indices saved, and how full
+  // the shared buffers are
+  std::cout << "Mesh data: " << meshBytes << " bytes uploaded, "
+            << fullMeshBytes - meshBytes << " bytes saved" << std::endl;
+  if (meshBuffers[0]) {
+    meshBuffers[0]->PrintStats("Full vertex");
+  }
+  if (meshBuffers[1]) {
+    meshBuffers[1]->PrintStats("Compact vertex");
   }
 }
 
-// Loads mesh into OpenGL context
-void ModelManager::LoadMesh(Mesh* mesh) {
-  // Generating Vertex Array and Vertex Buffer
-  glGenVertexArrays(1, &mesh->VAO);
-  glGenBuffers(1, &mesh->VBO);
-
-  // Binding vertex array so settings are saved
-  glBindVertexArray(mesh->VAO);
-
-  // Binding VBO
-  glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
-
-  // Calculating required buffer size for VBO
-  // (vec3f * 2 + vec2f * 1 = 8 floats * 4 bytes/float = 32 bytes.)
-  GLsizeiptr vboBuffSz = sizeof(Vertex) * mesh->verts.size();
-
-  // Loading vertex data into VBO
-  glBufferData(GL_ARRAY_BUFFER, vboBuffSz, mesh->verts.data(), GL_STATIC_DRAW);
-
-  // Generating EBO Buffer
-  glGenBuffers(1, &mesh->EBO);
-
-  // Binding EBO
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
-
-  // Calculating required buffer size for EBO
-  // (4 bytes * num indices)
-  GLsizeiptr eboBuffSz = sizeof(GLuint) * mesh->indices.size();
-
-  // Loading index data into EBO
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, eboBuffSz,
-               mesh->indices.data(), GL_STATIC_DRAW);
-
-  // Defining Vertex Attrib Arrays
-  GLsizei stride = sizeof(GLfloat) * 8;
-  // Position Attrib Ptr, 3 floats, location 0
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
-                        reinterpret_cast<void*>(0));
-  // Normal Attrib Ptr, 3 floats, location 1
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
-                        reinterpret_cast<void*>(3 * sizeof(GLfloat)));
-  // UV attrib ptr, 2 floats, location 2
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
-                        reinterpret_cast<void*>(6 * sizeof(GLfloat)));
-
-  // Enabling Attrib Arrays
-  glEnableVertexAttribArray(0);
-  glEnableVertexAttribArray(1);
-  glEnableVertexAttribArray(2);
-
-  // Unbind new VAO
-  glBindVertexArray(0);
-}
-
-// Reads Mesh from file
-void ModelManager::ReadMesh(std::string filename, Mesh* mesh) {
-  // Processing flags for importing the model
-  int processFlags = aiProcess_Triangulate |
-    aiProcess_JoinIdenticalVertices        |
-    aiProcess_SortByPType;
-
-  // Importing scene from file
-  const aiScene* scene = importer.ReadFile(("mesh/" + filename), processFlags);
-
-  // Making sure a scene was actually found
-  if (scene == nullptr) {
-    std::cerr << importer.GetErrorString() << std::endl;
+// Loads an imported mesh into OpenGL, unless a mesh with identical
+// contents is already loaded, then frees what the import held
+void ModelManager::LoadImport(MeshImport* result) {
+  // A failed import gets no name, so models using it are skipped
+  if (result->failed) {
+    std::cerr << "Could not load mesh mesh/" << result->filename
+              << ", models using it will be skipped" << std::endl;
+    *result = MeshImport();
     return;
   }
 
-  // Each file only has one mesh
-  aiMesh* importMesh = scene->mMeshes[0];
+  // Already loaded by an earlier CreateMeshes, but not as an occluder.
+  // It was imported again only for its triangles.
+  Mesh* mesh = &result->mesh;
+  const MeshHandle* shared = meshRegistry.Find(mesh->assetKey);
+  if (shared != nullptr) {
+    uint32_t meshIdx = meshPool.handles.Dense(*shared);
+    if (result->occluder && meshPool.occluderTris[meshIdx].empty()) {
+      CopyOccluderTris(*result, &meshPool.occluderTris[meshIdx]);
+    }
+  } else {
+    if (result->occluder) {
+      CopyOccluderTris(*result, &mesh->occluderTris);
+    }
 
-  // Recreating vertex data
-  for (unsigned int i = 0; i < importMesh->mNumVertices; ++i) {
-    // Create new Vertex struct
-    Vertex vert;
+    if (result->cooked) {
+      // Uploading straight from the mapped file
+      const MeshFileHeader* header = result->cooked->Header();
+      std::copy(header->lods, header->lods + header->numLods, mesh->lods);
+      mesh->numLods = header->numLods;
+      mesh->bounds = header->bounds;
+      LoadMesh(mesh,
+               reinterpret_cast<const Vertex*>(result->cooked->VertData()),
+               header->numVerts, result->cooked->IndexData(),
+               header->numIndices);
+    } else {
+      LoadMesh(mesh, mesh->verts.data(), mesh->verts.size(),
+               mesh->indices.data(), mesh->indices.size());
+    }
+
+    // Adding to the pool and registering for sharing. CreateMeshes names
+    // it once every import is loaded.
+    meshRegistry.Insert(mesh->assetKey, AddMesh(*mesh));
+  }
+
+  // Unmapping the cooked file and dropping the imported arrays now rather
+  // than once every mesh is loaded
+  *result = MeshImport();
+}
+
+// Sets LOD selection threshold in pixels
+void ModelManager::SetLodThreshold(float pixels) {
+  lodThreshold = pixels;
+}
+
+// Turns compact vertex format on or off
+void ModelManager::SetCompactVerts(bool compact) {
+  compactVerts = compact;
+}
+
+// Maps cooked mesh if current, otherwise hashes the DAE's bytes
+void ModelManager::OpenMesh(std::string filename, MeshImport* result) {
+  result->filename = filename;
+  std::string meshName = filename.substr(0, filename.find("."));
+
+  // Try the cooked file first, keyed by its mapped arrays
+  std::unique_ptr<MeshFile> cooked(new MeshFile());
+  if (cooked->Open("mesh/" + meshName + ".mesh") &&
+      cooked->IsCurrent("mesh/" + filename) &&
+      cooked->Header()->vertSz == sizeof(Vertex)) {
+    const MeshFileHeader* header = cooked->Header();
+    uint64_t key = HashBytes(cooked->VertData(),
+                             header->vertSz * header->numVerts);
+    key = HashBytes(cooked->IndexData(), sizeof(GLuint) * header->numIndices,
+                    key);
+    result->mesh.assetKey = key;
+    result->cooked = std::move(cooked);
+    return;
+  }
+
+  // Otherwise keyed by the source file. Missing and empty files get no
+  // key, so they can't be mistaken for each other's (empty) contents.
+  std::ifstream file("mesh/" + filename, std::ios::binary);
+  std::vector<unsigned char> fileData(
+    (std::istreambuf_iterator<char>(file)),
+    std::istreambuf_iterator<char>());
+  if (!file.is_open() || fileData.empty()) {
+    result->failed = true;
+    return;
+  }
+  result->mesh.assetKey = HashBytes(fileData.data(), fileData.size());
+}
+
+// Imports DAE unless cooked file was mapped
+void ModelManager::ImportMesh(Assimp::Importer* importer,
+                              MeshImport* result) {
+  if (result->cooked || result->failed) {
+    return;
+  }
+  CookedMesh cookedMesh;
+  if (!CookMesh(result->filename, importer, &cookedMesh)) {
+    result->failed = true;
+    return;
+  }
+  Mesh* mesh = &result->mesh;
+  mesh->verts.swap(cookedMesh.verts);
+  mesh->indices.swap(cookedMesh.indices);
+  std::copy(cookedMesh.lods, cookedMesh.lods + kMaxLods, mesh->lods);
+  mesh->numLods = static_cast<GLsizei>(cookedMesh.numLods);
+  mesh->bounds = cookedMesh.bounds;
+}
+
+// Loads mesh into OpenGL context
+void ModelManager::LoadMesh(Mesh* mesh, const Vertex* verts, GLsizei numVerts,
+                            const GLuint* indices, GLsizei numIndices) {
+  // Converting to compact vertices if turned on
+  std::vector<CompactVertex> compact;
+  const void* vertData = verts;
+  GLsizeiptr vboBuffSz = sizeof(Vertex) * numVerts;
+  if (compactVerts) {
+    CompactMesh(verts, numVerts, &compact, &mesh->dequantMat);
+    vertData = compact.data();
+    vboBuffSz = sizeof(CompactVertex) * numVerts;
+    mesh->compact = true;
+  }
+
+  // Narrowing indices to 16 bits when every vertex can be addressed
+  std::vector<GLushort> shortIndices;
+  const void* indexData = indices;
+  GLsizeiptr eboBuffSz = sizeof(GLuint) * numIndices;
+  if (numVerts <= 65536) {
+    shortIndices.assign(indices, indices + numIndices);
+    indexData = shortIndices.data();
+    eboBuffSz = sizeof(GLushort) * numIndices;
+    mesh->indexType = GL_UNSIGNED_SHORT;
+  }
 
-    // Getting vector for each attribute
-    aiVector3D vecPos = importMesh->mVertices[i];
-    aiVector3D vecNorm = importMesh->mNormals[i];
-    aiVector3D vecUv = importMesh->mTextureCoords[0][i];
+  // Tallying bytes for the report
+  meshBytes += vboBuffSz + eboBuffSz;
+  fullMeshBytes += sizeof(Vertex) * numVerts + sizeof(GLuint) * numIndices;
 
-    // Assigning values to Vertex struct
-    vert.pos = glm::vec3(vecPos[0], vecPos[1], vecPos[2]);
-    vert.norm = glm::vec3(vecNorm[0], vecNorm[1], vecNorm[2]);
-    vert.uv = glm::vec2(vecUv[0], vecUv[1]);
+  // Copying into the shared buffer for this vertex format
+  mesh->buffer = GetMeshBuffer(mesh->compact);
+  mesh->range = mesh->buffer->Add(vertData, numVerts, indexData,
+                                  static_cast<GLuint>(eboBuffSz));
 
-    // Add vertex to vertex vector
-    mesh->verts.push_back(vert);
+  // Storing index count for draw calls. Meshes without a LOD chain draw
+  // everything as LOD 0.
+  mesh->numIndices = numIndices;
+  if (mesh->numLods == 0) {
+    mesh->lods[0] = MeshLod{ 0, static_cast<uint32_t>(numIndices), 0.0f };
+    mesh->numLods = 1;
+  }
+}
+
+// Creates shared mesh buffer with the vertex layout for its format
+MeshBuffer* ModelManager::GetMeshBuffer(bool compact) {
+  std::unique_ptr<MeshBuffer>* buffer = &meshBuffers[compact ? 1 : 0];
+  if (*buffer) {
+    return buffer->get();
   }
 
-  // Storing indices for each face
-  for (unsigned int i = 0; i < importMesh->mNumFaces; ++i) {
-    aiFace face = importMesh->mFaces[i];
-    for (int j = 0; j < 3; ++j) {
-      mesh->indices.push_back(face.mIndices[j]);
+  std::vector<MeshBuffer::Attrib> attribs;
+  GLsizei vertSz = 0;
+  if (compact) {
+    vertSz = sizeof(CompactVertex);
+    // Position, 3 normalized ushorts, location 0
+    attribs.push_back({ 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0 });
+    // Octahedral normal, 2 normalized shorts, location 1
+    attribs.push_back({ 1, 2, GL_SHORT, GL_TRUE, 4 * sizeof(GLushort) });
+    // UV, 2 half floats, location 2
+    attribs.push_back({ 2, 2, GL_HALF_FLOAT, GL_FALSE, 6 * sizeof(GLushort) });
+  } else {
+    vertSz = sizeof(Vertex);
+    // Position, 3 floats, location 0
+    attribs.push_back({ 0, 3, GL_FLOAT, GL_FALSE, 0 });
+    // Normal, 3 floats, location 1
+    attribs.push_back({ 1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat) });
+    // UV, 2 floats, location 2
+    attribs.push_back({ 2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat) });
+  }
+
+  // Room for 64K vertices and 1MB of indices to start; grows as needed
+  buffer->reset(new MeshBuffer(&glState, vertSz, attribs, 1 << 16, 1 << 20));
+  return buffer->get();
+}
+
+// Packs each shared mesh buffer
+void ModelManager::DefragmentMeshes() {
+  for (int i = 0; i < 2; ++i) {
+    if (meshBuffers[i]) {
+      meshBuffers[i]->Defragment();
     }
   }
 }
 
+// Appends a loaded mesh's fields to every mesh pool column
+ModelManager::MeshHandle ModelManager::AddMesh(const Mesh& mesh) {
+  MeshHandle handle = meshPool.handles.Create();
+  meshPool.buffer.push_back(mesh.buffer);
+  meshPool.range.push_back(mesh.range);
+  meshPool.indexType.push_back(mesh.indexType);
+  meshPool.compact.push_back(mesh.compact);
+  meshPool.dequantMat.push_back(mesh.dequantMat);
+  meshPool.lods.emplace_back();
+  std::copy(mesh.lods, mesh.lods + kMaxLods, meshPool.lods.back().begin());
+  meshPool.numLods.push_back(mesh.numLods);
+  meshPool.bounds.push_back(mesh.bounds);
+  meshPool.assetKey.push_back(mesh.assetKey);
+  meshPool.occluderTris.push_back(mesh.occluderTris);
+  return handle;
+}
 
-// Loads texture and image data into OpenGL context
-void ModelManager::LoadTexture(std::string filename, GLuint* texIdPtr) {
-  // Generating texture ID
-  glGenTextures(1, texIdPtr);
+// Frees buffer ranges, then removes mesh from every column
+void ModelManager::RemoveMesh(MeshHandle handle) {
+  uint32_t meshIdx = meshPool.handles.Dense(handle);
+  meshPool.buffer[meshIdx]->Remove(meshPool.range[meshIdx]);
+  meshIdx = meshPool.handles.Destroy(handle);
+  SwapRemove(meshIdx, &meshPool.buffer, &meshPool.range, &meshPool.indexType,
+             &meshPool.compact, &meshPool.dequantMat, &meshPool.lods,
+             &meshPool.numLods, &meshPool.bounds, &meshPool.assetKey,
+             &meshPool.occluderTris);
+}
+
+// Quantizes vertices into the compact format
+void ModelManager::CompactMesh(const Vertex* verts, GLsizei numVerts,
+                               std::vector<CompactVertex>* compactVerts,
+                               glm::mat4* dequantMat) {
+  // Finding bounding box. Positions are stored as a fraction of the way
+  // across it on each axis.
+  glm::vec3 minPos = numVerts > 0 ? verts[0].pos : glm::vec3(0.0f);
+  glm::vec3 maxPos = minPos;
+  for (GLsizei i = 0; i < numVerts; ++i) {
+    minPos = glm::min(minPos, verts[i].pos);
+    maxPos = glm::max(maxPos, verts[i].pos);
+  }
+  glm::vec3 extent = glm::max(maxPos - minPos, glm::vec3(1e-6f));
 
-  // Image attributes
-  int width = 0;
-  int height = 0;
-  int numChannels = 0;
+  // Shader reads positions as 0-1, this maps them back onto the box
+  *dequantMat = glm::translate(glm::mat4(1.0f), minPos) *
+                glm::scale(glm::mat4(1.0f), extent);
 
-  // Flip image vertically and read file data and attributes
-  stbi_set_flip_vertically_on_load(1);
-  unsigned char* data = stbi_load(("tex/" + filename).c_str(),
-                                  &width, &height, &numChannels, 0);
+  compactVerts->resize(numVerts);
+  for (GLsizei i = 0; i < numVerts; ++i) {
+    CompactVertex* out = &(*compactVerts)[i];
 
-  // STBI makes data NULL if loading error
-  if (data == NULL) {
-    std::cout << "Could not load image!" << std::endl;
-    return;
+    // Quantizing position to 16 bits per axis
+    glm::vec3 unitPos = (verts[i].pos - minPos) / extent;
+    glm::u16vec3 quantPos = glm::u16vec3(
+      glm::round(glm::clamp(unitPos, 0.0f, 1.0f) * 65535.0f));
+    out->pos[0] = quantPos.x;
+    out->pos[1] = quantPos.y;
+    out->pos[2] = quantPos.z;
+
+    // Octahedral normal: project onto the octahedron |x|+|y|+|z| = 1, then
+    // fold the lower half over the upper so it unwraps into a square
+    glm::vec3 norm = verts[i].norm;
+    norm /= glm::max(glm::abs(norm.x) + glm::abs(norm.y) + glm::abs(norm.z),
+                     1e-6f);
+    glm::vec2 oct = glm::vec2(norm.x, norm.y);
+    if (norm.z < 0.0f) {
+      glm::vec2 signs = glm::vec2(oct.x >= 0.0f ? 1.0f : -1.0f,
+                                  oct.y >= 0.0f ? 1.0f : -1.0f);
+      oct = (1.0f - glm::abs(glm::vec2(oct.y, oct.x))) * signs;
+    }
+    out->norm[0] = static_cast<GLshort>(glm::packSnorm1x16(oct.x));
+    out->norm[1] = static_cast<GLshort>(glm::packSnorm1x16(oct.y));
+
+    // Half float UVs keep values outside 0-1 for repeating textures
+    out->uv[0] = glm::packHalf1x16(verts[i].uv.x);
+    out->uv[1] = glm::packHalf1x16(verts[i].uv.y);
   }
+}
+
+
+
+// Decodes texture image data from file contents
+void ModelManager::DecodeTexture(const std::vector<unsigned char>& fileData,
+                                 DecodedImage* image) {
+  // Timing the decode for CreateTextures' report
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  // Decode file data and attributes. Flipping was turned on before the
+  // decode workers started.
+  image->data = std::unique_ptr<unsigned char, void (*)(void*)>(
+                  stbi_load_from_memory(fileData.data(),
+                                        static_cast<int>(fileData.size()),
+                                        &image->width, &image->height,
+                                        &image->numChannels, 0),
+                  stbi_image_free);
+
+  std::chrono::duration<double, std::milli> elapsed =
+    std::chrono::steady_clock::now() - start;
+  image->decodeMs = elapsed.count();
+}
+
+// Loads decoded image data into OpenGL context
+void ModelManager::LoadTexture(const DecodedImage& image, GLuint* texIdPtr) {
+  // Generating texture ID. CreateTextures only uploads images that
+  // decoded.
+  glGenTextures(1, texIdPtr);
 
   // Determining pixel type
   GLenum pixelType = 0;
-  if (numChannels == 3) {
+  if (image.numChannels == 3) {
     pixelType = GL_RGB;
-  } else if (numChannels == 4) {
+  } else if (image.numChannels == 4) {
     pixelType = GL_RGBA;
   }
 
   // Binding texture and loading image data
-  glBindTexture(GL_TEXTURE_2D, *texIdPtr);
-  glTexImage2D(GL_TEXTURE_2D, 0, pixelType, width, height, 0, pixelType,
-               GL_UNSIGNED_BYTE, data);
+  glState.BindTexture(0, *texIdPtr);
+  glTexImage2D(GL_TEXTURE_2D, 0, pixelType, image.width, image.height, 0,
+               pixelType, GL_UNSIGNED_BYTE, image.data.get());
+  glState.CountTextureUpload(static_cast<GLsizeiptr>(image.width) *
+                             image.height * image.numChannels);
   glGenerateMipmap(GL_TEXTURE_2D);
 
   // Setting texture parameters
@@ -180,72 +532,56 @@ void ModelManager::LoadTexture(std::string filename, GLuint* texIdPtr) {
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
                   GL_LINEAR_MIPMAP_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  // Freeing image data
-  stbi_image_free(data);
 }
 
-// Draws the supplied model name in the window
-void ModelManager::DrawModel(std::string modelName, GLFWwindow* window) {
-  // Getting array of objects from window pointer
-  void** objArr = reinterpret_cast<void**>(glfwGetWindowUserPointer(window));
-
-  // Getting appropriate model and mesh
-  Model model = models[modelName];
-  Mesh mesh = meshes[model.meshName];
-
-  // Shader pointer, since we haven't determined which shader yet.
-  Shader* shader;
-
-  // This if block chooses appropriate shader for model, uses it, and
-  // loads shader-specific variables
-  std::map<std::string, Texture>::iterator tex = textures.find(model.matName);
-  if (tex != textures.end()) {
-    // If so, set Shader pointer to image material shader and use it.
-    shader = reinterpret_cast<Shader*>(objArr[IMGSHDR]);
-    shader->Use();
-
-    // Setting textures and binding them
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex->second.diffTex);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, tex->second.specTex);
-
-    // Setting textures to appropriate points in shader
-    shader->LoadInt(0, "diffSamp");
-    shader->LoadInt(1, "specSamp");
-
-    // Loading material glossiness into shader
-    shader->LoadFloat(tex->second.gloss, "gloss");
-  } else {
-    // No texture, use property material shader
-    shader = reinterpret_cast<Shader*>(objArr[PROPSHDR]);
-    shader->Use();
+// Scaling each LOD's error by the model matrix's largest axis scale, then
+// by how many pixels a unit covers at the model's distance
+GLsizei ModelManager::SelectLod(uint32_t modelIdx, uint32_t meshIdx,
+                                Camera* camPtr) {
+  const glm::mat4& modelMat = modelPool.modelMat[modelIdx];
+  float maxScale = glm::max(glm::length(glm::vec3(modelMat[0])),
+                   glm::max(glm::length(glm::vec3(modelMat[1])),
+                            glm::length(glm::vec3(modelMat[2]))));
+  float pxPerUnit = camPtr->PixelsPerUnit(glm::vec3(modelMat[3]));
+  const std::array<MeshLod, kMaxLods>& lods = meshPool.lods[meshIdx];
+  GLsizei lodIdx = meshPool.numLods[meshIdx] - 1;
+  for (; lodIdx > 0; --lodIdx) {
+    if (lods[lodIdx].error * maxScale * pxPerUnit <= lodThreshold) {
+      break;
+    }
+  }
+  return lodIdx;
+}
 
-    // Get pointer to material
-    Material* mat = &materials[model.matName];
+// Replays a packet, changing only the state that differs from the last one
+void ModelManager::ReplayPacket(const DrawList::Packet& packet) {
+  // Using this packet's shader
+  glState.UseProgram(packet.program);
 
-    // Load material attributes into shader
-    shader->LoadVector(mat->amb, "material.amb");
-    shader->LoadVector(mat->diff, "material.diff");
-    shader->LoadVector(mat->spec, "material.spec");
-    shader->LoadFloat(mat->gloss, "material.gloss");
+  // Binding material. Its values were packed into the uniform ring by
+  // RecordSlice; textures go on the units the samplers were set to. A
+  // textured packet binds both units even when an image failed to load,
+  // so it never samples the previous packet's textures.
+  if (packet.textured) {
+    glState.BindTexture(0, packet.diffTex);
+    glState.BindTexture(1, packet.specTex);
   }
+  uniformRing->Bind(kMatDataBinding, packet.material, sizeof(MaterialData));
 
-  // Load model and norm matrices
-  shader->LoadMatrix(model.modelMat, "modelMat");
-  shader->LoadMatrix(model.normMat, "normMat");
-  GLfloat test[16];
-  GLint normMatLoc = glGetUniformLocation(shader->id, "normMat");
-  glGetUniformfv(shader->id, normMatLoc, test);
-  // Bind mesh's vertex array
-  glBindVertexArray(mesh.VAO);
+  // Binding the instances' matrices. The range covers the whole declared
+  // array, as GL requires, though only numInstances entries are read.
+  uniformRing->Bind(kObjDataBinding, packet.objects, kObjBlockSize);
 
-  WindowManager* winMgrPtr = reinterpret_cast<WindowManager*>(objArr[0]);
-  winMgrPtr->ProcessInput();
-  // Drawing model
-  // WindowManager* winMgrPtr = reinterpret_cast<WindowManager*>(ptrs[0]);
-  glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
+  // Binding the shared vertex array of the mesh's format
+  glState.BindVertexArray(packet.vertexArray);
+
+  // Drawing every instance from the mesh's ranges of the shared buffer
+  glDrawElementsInstancedBaseVertex(
+    GL_TRIANGLES, packet.numIndices, packet.indexType,
+    reinterpret_cast<void*>(packet.indexOffset), packet.numInstances,
+    packet.baseVertex);
+  glState.CountDraw(static_cast<uint64_t>(packet.numIndices / 3) *
+                    packet.numInstances);
 }
 
 // Creates Materials from material definitions
@@ -254,59 +590,921 @@ void ModelManager::CreateMaterials(std::vector<MaterialDef> matDefs) {
   std::vector<MaterialDef>::iterator matIter = matDefs.begin();
   // Increment iterator until end, creating material each time
   for (; matIter != matDefs.end(); ++matIter) {
-    // Create a new material and store it, using the name as a key
-    Material newMat{ matIter->amb,
-                     matIter->diff,
-                     matIter->spec,
-                     matIter->gloss };
-    materials[matIter->matName] = newMat;
+    // Create a new material and name it
+    materialNames[matIter->matName] = materialPool.handles.Create();
+    materialPool.amb.push_back(matIter->amb);
+    materialPool.diff.push_back(matIter->diff);
+    materialPool.spec.push_back(matIter->spec);
+    materialPool.gloss.push_back(matIter->gloss);
   }
 }
 
-// Creates Textures from texture definitions
+// Creates Textures from texture definitions. Each distinct image is decoded
+// once by a job and uploaded by a main thread job as soon as it finishes.
+// Images with the same contents share one GL texture.
 void ModelManager::CreateTextures(std::vector<TextureDef> texDefs) {
-  // Iterator for texture definitions vector
-  std::vector<TextureDef>::iterator texIter = texDefs.begin();
-  // Increment iterator until end, creating texture each time
-  for (; texIter != texDefs.end(); ++texIter) {
-    // Create new texture
-    Texture newTex;
+  // Unique image files, by canonical path, and which one each texture's
+  // diffuse (even index) and specular (odd index) image refers to
+  std::vector<std::string> imageFiles;
+  std::map<std::string, size_t> fileIndices;
+  std::vector<size_t> defImages;
+  for (size_t i = 0; i < texDefs.size() * 2; ++i) {
+    const TextureDef& texDef = texDefs[i / 2];
+    std::string filename = i % 2 == 0 ? texDef.diffTexFile
+                                      : texDef.specTexFile;
+    std::error_code err;
+    std::string canonPath =
+      std::filesystem::weakly_canonical("tex/" + filename, err).string();
+    if (err) {
+      canonPath = "tex/" + filename;
+    }
+    std::map<std::string, size_t>::iterator found = fileIndices.find(canonPath);
+    if (found == fileIndices.end()) {
+      found = fileIndices.emplace(canonPath, imageFiles.size()).first;
+      imageFiles.push_back(filename);
+    }
+    defImages.push_back(found->second);
+  }
+  size_t numImages = imageFiles.size();
+
+  // Index of the next image for a decode job to claim, and the images
+  std::atomic<size_t> nextImage(0);
+  std::vector<DecodedImage> images(numImages);
+
+  // Content hashes claimed for decoding. Decode jobs only read the
+  // registry, which isn't written until they've all finished.
+  std::set<uint64_t> claimed;
+  std::mutex claimLock;
+
+  // Flip images vertically on load. Set once, before any job reads it.
+  stbi_set_flip_vertically_on_load(1);
+
+  // Content hash of each unique image file, and newly uploaded textures.
+  // Only upload jobs, on the main thread, write these.
+  std::vector<uint64_t> imageKeys(numImages);
+  std::map<uint64_t, GLuint> uploaded;
+
+  // One decode job per thread (or the configured limit), but no more than
+  // images. Each claims images until none are left, and hands every one to
+  // a main thread job that uploads it as soon as it's decoded.
+  size_t numDecoders = maxDecodeThreads;
+  if (numDecoders == 0) {
+    numDecoders = jobs.NumThreads();
+  }
+  numDecoders = std::max<size_t>(1, std::min(numDecoders, numImages));
+  JobSystem::Counter done;
+  for (size_t i = 0; i < numDecoders; ++i) {
+    jobs.Run([this, &imageFiles, &nextImage, &images, &claimed, &claimLock,
+              &imageKeys, &uploaded, &done, numImages] {
+      size_t imgIdx = nextImage++;
+      for (; imgIdx < numImages; imgIdx = nextImage++) {
+        DecodedImage& image = images[imgIdx];
+        image.imgIdx = imgIdx;
+        image.filename = imageFiles[imgIdx];
+
+        // Reading whole file. Missing and empty files get no key, so they
+        // can't be mistaken for each other's (empty) contents.
+        std::ifstream file("tex/" + image.filename, std::ios::binary);
+        std::vector<unsigned char> fileData(
+          (std::istreambuf_iterator<char>(file)),
+          std::istreambuf_iterator<char>());
+        if (!file.is_open() || fileData.empty()) {
+          image.failed = true;
+        } else {
+          image.key = HashBytes(fileData.data(), fileData.size());
+        }
+
+        // Only the first file with these contents gets decoded
+        bool firstCopy = false;
+        if (!image.failed) {
+          std::lock_guard<std::mutex> guard(claimLock);
+          firstCopy = !imageRegistry.Contains(image.key) &&
+                      claimed.insert(image.key).second;
+        }
+        if (firstCopy) {
+          DecodeTexture(fileData, &image);
+          image.decoded = image.data != nullptr;
+          image.failed = !image.decoded;
+        }
+
+        jobs.Run([this, &image, &imageKeys, &uploaded] {
+          if (image.failed) {
+            std::cerr << "Could not load image tex/" << image.filename
+                      << ", its textures will have none" << std::endl;
+            return;
+          }
+          imageKeys[image.imgIdx] = image.key;
+          if (!image.decoded) {
+            return;
+          }
+
+          std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+          LoadTexture(image, &uploaded[image.key]);
+          std::chrono::duration<double, std::milli> uploadMs =
+            std::chrono::steady_clock::now() - start;
+          image.data.reset();
+
+          // Reporting per-image timing
+          std::cout << std::left << std::setw(24) << image.filename
+                    << std::fixed << std::setprecision(2)
+                    << " decode " << image.decodeMs << " ms,"
+                    << " upload " << uploadMs.count() << " ms" << std::endl;
+        }, &done, nullptr, JobSystem::MAIN_THREAD);
+      }
+    }, &done);
+  }
+  jobs.Wait(&done);
+
+  // Registering new textures for sharing
+  std::map<uint64_t, GLuint>::iterator upIter = uploaded.begin();
+  for (; upIter != uploaded.end(); ++upIter) {
+    imageRegistry.Insert(upIter->first, upIter->second);
+  }
+  std::cout << texDefs.size() * 2 << " texture images, " << numImages
+            << " unique files, " << uploaded.size() << " uploaded"
+            << std::endl;
+
+  // Each texture takes a reference to both of its images.
+  // Add texture to the pool and name it. An image that failed to load
+  // leaves texture 0 and key 0 in its place, so there's nothing to release.
+  for (size_t i = 0; i < texDefs.size(); ++i) {
+    uint64_t diffKey = imageKeys[defImages[i * 2]];
+    uint64_t specKey = imageKeys[defImages[i * 2 + 1]];
+    GLuint* diffTex = imageRegistry.Acquire(diffKey);
+    GLuint* specTex = imageRegistry.Acquire(specKey);
+    textureNames[texDefs[i].texName] = texturePool.handles.Create();
+    texturePool.diffTex.push_back(diffTex == nullptr ? 0 : *diffTex);
+    texturePool.specTex.push_back(specTex == nullptr ? 0 : *specTex);
+    texturePool.gloss.push_back(texDefs[i].gloss);
+    texturePool.diffKey.push_back(diffTex == nullptr ? 0 : diffKey);
+    texturePool.specKey.push_back(specTex == nullptr ? 0 : specKey);
+  }
+}
+
+// Releases textures' image references, deleting unshared GL textures
+void ModelManager::DeleteTextures(std::vector<std::string> texNames) {
+  std::vector<std::string>::iterator nameIter = texNames.begin();
+  for (; nameIter != texNames.end(); ++nameIter) {
+    std::map<std::string, TextureHandle>::iterator name =
+      textureNames.find(*nameIter);
+    if (name == textureNames.end()) {
+      continue;
+    }
+
+    // Delete each image's texture when this was its last user
+    uint32_t texIdx = texturePool.handles.Dense(name->second);
+    GLuint texId = 0;
+    if (imageRegistry.Release(texturePool.diffKey[texIdx], &texId)) {
+      glState.ForgetTexture(texId);
+      glDeleteTextures(1, &texId);
+    }
+    if (imageRegistry.Release(texturePool.specKey[texIdx], &texId)) {
+      glState.ForgetTexture(texId);
+      glDeleteTextures(1, &texId);
+    }
+
+    // Models still using it stop drawing
+    texIdx = texturePool.handles.Destroy(name->second);
+    SwapRemove(texIdx, &texturePool.diffTex, &texturePool.specTex,
+               &texturePool.gloss, &texturePool.diffKey,
+               &texturePool.specKey);
+    textureNames.erase(name);
+  }
+}
 
-    // Load texture's images into OpenGL context and save attributes
-    LoadTexture(texIter->diffTexFile, &newTex.diffTex);
-    LoadTexture(texIter->specTexFile, &newTex.specTex);
-    newTex.gloss = texIter->gloss;
+// Releases meshes' references, removing meshes no longer shared
+void ModelManager::DeleteMeshes(std::vector<std::string> names) {
+  std::vector<std::string>::iterator nameIter = names.begin();
+  for (; nameIter != names.end(); ++nameIter) {
+    std::map<std::string, MeshHandle>::iterator name =
+      meshNames.find(*nameIter);
+    if (name == meshNames.end()) {
+      continue;
+    }
 
-    // Store texture using name for key
-    textures[texIter->texName] = newTex;
+    // Remove mesh when this was its last name. Models still using it
+    // stop drawing.
+    uint32_t meshIdx = meshPool.handles.Dense(name->second);
+    MeshHandle released;
+    if (meshRegistry.Release(meshPool.assetKey[meshIdx], &released)) {
+      RemoveMesh(released);
+    }
+    meshNames.erase(name);
   }
 }
 
-// Creates models from model definitions
+// Sets maximum number of image decode threads
+void ModelManager::SetDecodeThreads(unsigned int numThreads) {
+  maxDecodeThreads = numThreads;
+}
+
+// Creates transform nodes from node definitions. Parents must come before
+// their children, in this call or an earlier one.
+void ModelManager::CreateNodes(std::vector<NodeDef> nodeDefs) {
+  std::vector<NodeDef>::iterator nodeIter = nodeDefs.begin();
+  for (; nodeIter != nodeDefs.end(); ++nodeIter) {
+    TransformGraph::NodeId parent = TransformGraph::kNoNode;
+    if (!FindParent(nodeIter->parentName, &parent)) {
+      std::cerr << "Skipping node " << nodeIter->nodeName << std::endl;
+      continue;
+    }
+    nodeNames[nodeIter->nodeName] =
+      transforms.AddNode(parent, nodeIter->localMat);
+    nodeModels.push_back(ModelHandle());
+  }
+}
+
+bool ModelManager::FindParent(const std::string& parentName,
+                              TransformGraph::NodeId* parent) {
+  *parent = TransformGraph::kNoNode;
+  if (parentName.empty()) {
+    return true;
+  }
+  std::map<std::string, TransformGraph::NodeId>::iterator found =
+    nodeNames.find(parentName);
+  if (found == nodeNames.end()) {
+    std::cerr << "Unknown parent node " << parentName << std::endl;
+    return false;
+  }
+  *parent = found->second;
+  return true;
+}
+
+// Creates models from model definitions. World matrices, normal matrices,
+// and world boxes are filled in by UpdateTransforms once every model has
+// its node.
 void ModelManager::CreateModels(std::vector<ModelDef> modDefs) {
   // Iterator for model definitions vector
   std::vector<ModelDef>::iterator modIter = modDefs.begin();
   // Iterate through vector until end
   for (; modIter != modDefs.end(); ++modIter) {
-    // Calculating normal matrix
-    glm::mat3 model3 = glm::mat3(modIter->modelMat);
-    glm::mat3 norm = glm::transpose(glm::inverse(model3));
-    // Creating new model and storing it, using name as key.
-    Model newModel = Model{ modIter->meshName,
-                            modIter->matName,
-                            modIter->modelMat,
-                            norm };
-    models[modIter->modelName] = newModel;
+    // Resolving mesh and material or texture names to handles
+    std::map<std::string, MeshHandle>::iterator mesh =
+      meshNames.find(modIter->meshName);
+    std::map<std::string, TextureHandle>::iterator tex =
+      textureNames.find(modIter->matName);
+    std::map<std::string, MaterialHandle>::iterator mat =
+      materialNames.find(modIter->matName);
+    if (mesh == meshNames.end() ||
+        (tex == textureNames.end() && mat == materialNames.end())) {
+      std::cerr << "Skipping model " << modIter->modelName
+                << ": unknown mesh or material" << std::endl;
+      continue;
+    }
+    TransformGraph::NodeId parent = TransformGraph::kNoNode;
+    if (!FindParent(modIter->parentName, &parent)) {
+      std::cerr << "Skipping model " << modIter->modelName << std::endl;
+      continue;
+    }
+
+    // Creating new model and its node, and naming both. Textures win over
+    // materials.
+    ModelHandle model = modelPool.handles.Create();
+    TransformGraph::NodeId node =
+      transforms.AddNode(parent, modIter->modelMat);
+    modelNames[modIter->modelName] = model;
+    nodeNames[modIter->modelName] = node;
+    nodeModels.push_back(model);
+    modelPool.name.push_back(modIter->modelName);
+    modelPool.node.push_back(node);
+    modelPool.modelMat.push_back(modIter->modelMat);
+    modelPool.normMat.push_back(glm::mat3(1.0f));
+    modelPool.mesh.push_back(mesh->second);
+    if (tex != textureNames.end()) {
+      modelPool.material.push_back(MaterialHandle());
+      modelPool.texture.push_back(tex->second);
+    } else {
+      modelPool.material.push_back(mat->second);
+      modelPool.texture.push_back(TextureHandle());
+    }
+    modelPool.centerX.push_back(0.0f);
+    modelPool.centerY.push_back(0.0f);
+    modelPool.centerZ.push_back(0.0f);
+    modelPool.extentX.push_back(0.0f);
+    modelPool.extentY.push_back(0.0f);
+    modelPool.extentZ.push_back(0.0f);
+    modelPool.bvhLeaf.push_back(Bvh::kNoNode);
+    if (!meshPool.occluderTris[meshPool.handles.Dense(mesh->second)].empty()) {
+      occluderModels.push_back(modelPool.handles.Size() - 1);
+    }
+  }
+
+  // Building once over the whole batch gives a far better tree than
+  // inserting models one at a time
+  UpdateTransforms();
+  RebuildSceneBvh();
+}
+
+void ModelManager::RebuildSceneBvh() {
+  uint32_t numModels = modelPool.handles.Size();
+  std::vector<Bvh::Aabb> boxes;
+  std::vector<uint32_t> items;
+  boxes.reserve(numModels);
+  items.reserve(numModels);
+  for (uint32_t modelIdx = 0; modelIdx < numModels; ++modelIdx) {
+    // Models whose mesh was deleted have nothing to find
+    modelPool.bvhLeaf[modelIdx] = Bvh::kNoNode;
+    if (!meshPool.handles.Valid(modelPool.mesh[modelIdx])) {
+      continue;
+    }
+    glm::vec3 center(modelPool.centerX[modelIdx], modelPool.centerY[modelIdx],
+                     modelPool.centerZ[modelIdx]);
+    glm::vec3 extent(modelPool.extentX[modelIdx], modelPool.extentY[modelIdx],
+                     modelPool.extentZ[modelIdx]);
+    Bvh::Aabb box;
+    box.min = center - extent;
+    box.max = center + extent;
+    boxes.push_back(box);
+    items.push_back(modelIdx);
+  }
+  std::vector<uint32_t> leaves(items.size());
+  sceneBvh.Build(boxes.data(), items.data(),
+                 static_cast<uint32_t>(items.size()), leaves.data());
+  for (size_t i = 0; i < items.size(); ++i) {
+    modelPool.bvhLeaf[items[i]] = leaves[i];
+  }
+}
+
+// Moving the box's center like a point, and taking its extent along each
+// world axis as the sum of the box axes' absolute contributions to it
+void ModelManager::UpdateWorldBounds(uint32_t modelIdx) {
+  // A model whose mesh was deleted has no bounds; it leaves the BVH and
+  // its box shrinks to its center
+  if (!meshPool.handles.Valid(modelPool.mesh[modelIdx])) {
+    if (modelPool.bvhLeaf[modelIdx] != Bvh::kNoNode) {
+      sceneBvh.Remove(modelPool.bvhLeaf[modelIdx]);
+      modelPool.bvhLeaf[modelIdx] = Bvh::kNoNode;
+    }
+    modelPool.extentX[modelIdx] = 0.0f;
+    modelPool.extentY[modelIdx] = 0.0f;
+    modelPool.extentZ[modelIdx] = 0.0f;
+    return;
+  }
+
+  const glm::mat4& modelMat = modelPool.modelMat[modelIdx];
+  uint32_t meshIdx = meshPool.handles.Dense(modelPool.mesh[modelIdx]);
+  const MeshBounds& bounds = meshPool.bounds[meshIdx];
+  glm::vec3 localMin(bounds.min[0], bounds.min[1], bounds.min[2]);
+  glm::vec3 localMax(bounds.max[0], bounds.max[1], bounds.max[2]);
+  glm::vec3 localCenter = (localMin + localMax) * 0.5f;
+  glm::vec3 localExtent = (localMax - localMin) * 0.5f;
+
+  glm::vec3 center = glm::vec3(modelMat * glm::vec4(localCenter, 1.0f));
+  glm::mat3 absMat = glm::mat3(glm::abs(glm::vec3(modelMat[0])),
+                               glm::abs(glm::vec3(modelMat[1])),
+                               glm::abs(glm::vec3(modelMat[2])));
+  glm::vec3 extent = absMat * localExtent;
+
+  // Refitting the model's leaf if the box stayed near where it was, or
+  // reinserting it if it moved far enough that refitting would leave its
+  // old ancestors stretched across the gap
+  uint32_t leaf = modelPool.bvhLeaf[modelIdx];
+  if (leaf != Bvh::kNoNode) {
+    glm::vec3 oldCenter(modelPool.centerX[modelIdx],
+                        modelPool.centerY[modelIdx],
+                        modelPool.centerZ[modelIdx]);
+    Bvh::Aabb box;
+    box.min = center - extent;
+    box.max = center + extent;
+    if (glm::length(center - oldCenter) > glm::length(extent)) {
+      sceneBvh.Remove(leaf);
+      modelPool.bvhLeaf[modelIdx] = sceneBvh.Insert(box, modelIdx);
+    } else {
+      sceneBvh.Refit(leaf, box);
+    }
+  }
+
+  modelPool.centerX[modelIdx] = center.x;
+  modelPool.centerY[modelIdx] = center.y;
+  modelPool.centerZ[modelIdx] = center.z;
+  modelPool.extentX[modelIdx] = extent.x;
+  modelPool.extentY[modelIdx] = extent.y;
+  modelPool.extentZ[modelIdx] = extent.z;
+}
+
+// Reading the graph through nodeModels, since most nodes that move in
+// a big scene are models, and a model's node maps straight to its handle
+void ModelManager::UpdateTransforms() {
+  Profiler::Scope cpuScope("UpdateTransforms");
+  transforms.Update(&jobs);
+  const std::vector<TransformGraph::NodeId>& updated = transforms.Updated();
+  std::vector<TransformGraph::NodeId>::const_iterator nodeIter =
+    updated.begin();
+  for (; nodeIter != updated.end(); ++nodeIter) {
+    ModelHandle model = nodeModels[*nodeIter];
+    if (model.IsNull()) {
+      continue;
+    }
+    uint32_t modelIdx = modelPool.handles.Dense(model);
+    modelPool.modelMat[modelIdx] = transforms.World(*nodeIter);
+    modelPool.normMat[modelIdx] = transforms.NormalMat(*nodeIter);
+    UpdateWorldBounds(modelIdx);
   }
 }
 
-// Draws all models held in Model Manager's model map when called
+// Draws all models in the model pool when called. Culling, queueing, and
+// uniform packing run on slices of the model pool in parallel; the GL
+// thread only sets up the frame's ring region and replays the packets.
 void ModelManager::DrawModels(GLFWwindow* window) {
-  // Creating iterator for models
-  std::map<std::string, Model>::iterator modelIter = models.begin();
-  // Increment iterator, getting the model name and drawing it each time
-  for (; modelIter != models.end(); ++modelIter) {
-    std::string modelName = modelIter->first;
-    DrawModel(modelName, window);
+  Profiler::Scope cpuScope("DrawModels");
+  void** objArr = reinterpret_cast<void**>(glfwGetWindowUserPointer(window));
+  Camera* camPtr = reinterpret_cast<Camera*>(objArr[SCENECAM]);
+
+  // Starting the frame's counters. Something else may have changed GL
+  // state since last frame, so nothing cached is trusted.
+  glState.BeginFrame();
+  glState.Invalidate();
+
+  // Picking up whatever moved since the last frame
+  UpdateTransforms();
+
+  // Gathering what every slice reads
+  FrameView view;
+  view.camPtr = camPtr;
+  camPtr->FrustumPlanes(view.planes);
+  view.programs[IMG_SHADER] = reinterpret_cast<Shader*>(objArr[IMGSHDR])->id;
+  view.programs[PROP_SHADER] =
+    reinterpret_cast<Shader*>(objArr[PROPSHDR])->id;
+
+  // Large scenes skip whole groups of models the frustum misses through
+  // the BVH up front; smaller ones test every box inside their slices
+  uint32_t numModels = modelPool.handles.Size();
+  modelVisible.resize(numModels);
+  if (numModels >= kBvhMinModels) {
+    std::fill(modelVisible.begin(), modelVisible.end(), 0);
+    FrustumVolume frustum;
+    frustum.planes = view.planes;
+    queryItems.clear();
+    sceneBvh.Query(frustum, &queryItems);
+    std::vector<uint32_t>::iterator itemIter = queryItems.begin();
+    for (; itemIter != queryItems.end(); ++itemIter) {
+      modelVisible[*itemIter] = 1;
+    }
+    view.bvhCulled = true;
+  }
+  DrawOccluders(&view);
+
+  // Splitting the models into one contiguous slice per thread, with enough
+  // models in each to be worth a job of its own
+  size_t numSlices = (numModels + kMinSliceModels - 1) / kMinSliceModels;
+  numSlices = std::max<size_t>(1, std::min<size_t>(
+                numSlices, jobs.NumThreads()));
+  slices.resize(numSlices);
+  uint32_t sliceModels =
+    static_cast<uint32_t>((numModels + numSlices - 1) / numSlices);
+  for (size_t i = 0; i < numSlices; ++i) {
+    slices[i].firstModel =
+      std::min(numModels, static_cast<uint32_t>(i) * sliceModels);
+    slices[i].endModel =
+      std::min(numModels, slices[i].firstModel + sliceModels);
+  }
+  jobs.ParallelFor(static_cast<uint32_t>(numSlices),
+                   [this, &view](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      QueueSlice(view, &slices[i]);
+    }
+  });
+
+  // Sizing the frame's ring region from every slice's batches. The slack
+  // at the end keeps the last batch's full-array binding inside it.
+  GLsizeiptr bytesNeeded =
+    uniformRing->Aligned(sizeof(Camera::CamData)) + kObjBlockSize;
+  std::vector<Slice>::iterator sliceIter = slices.begin();
+  for (; sliceIter != slices.end(); ++sliceIter) {
+    bytesNeeded += sliceIter->ringBytes;
+  }
+  uniformRing->BeginFrame(bytesNeeded);
+  Camera::CamData camData = camPtr->GetCamData();
+  GLintptr camOffset = uniformRing->Write(&camData, sizeof(camData));
+
+  // Handing each slice its own part of the region, so slices pack their
+  // uniforms without sharing anything
+  for (sliceIter = slices.begin(); sliceIter != slices.end(); ++sliceIter) {
+    sliceIter->ringData = static_cast<unsigned char*>(
+      uniformRing->Allocate(sliceIter->ringBytes, &sliceIter->ringOffset));
+  }
+  jobs.ParallelFor(static_cast<uint32_t>(numSlices),
+                   [this, &view](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      RecordSlice(view, &slices[i]);
+    }
+  });
+  uniformRing->Flush();
+  uniformRing->Bind(Camera::kCamDataBinding, camOffset, sizeof(camData));
+
+  // Totalling the slices' counters
+  cullStats = CullStats();
+  occlusionStats = OcclusionStats();
+  sliceLists.clear();
+  for (sliceIter = slices.begin(); sliceIter != slices.end(); ++sliceIter) {
+    cullStats.tested += sliceIter->cullStats.tested;
+    cullStats.visible += sliceIter->cullStats.visible;
+    occlusionStats.tested += sliceIter->occlusionStats.tested;
+    occlusionStats.occluded += sliceIter->occlusionStats.occluded;
+    occlusionStats.testedTris += sliceIter->occlusionStats.testedTris;
+    occlusionStats.occludedTris += sliceIter->occlusionStats.occludedTris;
+    sliceLists.push_back(&sliceIter->drawList);
+  }
+
+  // Replaying in key order across every slice: grouped by shader, then
+  // material, then mesh, front to back within each group
+  DrawList::Merge(sliceLists, &mergeHeads, &packetOrder);
+  {
+    Profiler::Scope replayCpuScope("ReplayPackets");
+    GpuProfiler::Scope replayGpuScope("ReplayPackets");
+    std::vector<const DrawList::Packet*>::iterator packetIter =
+      packetOrder.begin();
+    for (; packetIter != packetOrder.end(); ++packetIter) {
+      ReplayPacket(**packetIter);
+    }
+  }
+
+  // Fencing this frame's ring region now that every draw reading it is in
+  uniformRing->EndFrame();
+}
+
+// Queueing models in position order and sorting once, then walking the
+// sorted draws to batch them
+void ModelManager::QueueSlice(const FrameView& view, Slice* slice) {
+  Profiler::Scope cpuScope("QueueSlice");
+  uint32_t firstModel = slice->firstModel;
+  uint32_t numModels = slice->endModel - firstModel;
+  slice->cullStats = CullStats();
+  slice->cullStats.tested = numModels;
+  slice->occlusionStats = OcclusionStats();
+
+  // Testing the slice's world boxes against the view frustum, unless the
+  // BVH already did
+  if (!view.bvhCulled) {
+    BoxArrays boxes;
+    boxes.centerX = modelPool.centerX.data() + firstModel;
+    boxes.centerY = modelPool.centerY.data() + firstModel;
+    boxes.centerZ = modelPool.centerZ.data() + firstModel;
+    boxes.extentX = modelPool.extentX.data() + firstModel;
+    boxes.extentY = modelPool.extentY.data() + firstModel;
+    boxes.extentZ = modelPool.extentZ.data() + firstModel;
+    CullBoxes(view.planes, boxes, numModels,
+              modelVisible.data() + firstModel);
+  }
+
+  // Queueing every visible model with a key built from its state and the
+  // depth of its box's center. Models whose mesh or material was deleted
+  // are left out.
+  slice->queue.Clear();
+  for (uint32_t modelIdx = firstModel; modelIdx < slice->endModel;
+       ++modelIdx) {
+    if (!modelVisible[modelIdx]) {
+      continue;
+    }
+    MeshHandle mesh = modelPool.mesh[modelIdx];
+    TextureHandle tex = modelPool.texture[modelIdx];
+    MaterialHandle mat = modelPool.material[modelIdx];
+    bool textured = !tex.IsNull();
+    if (!meshPool.handles.Valid(mesh) ||
+        (textured ? !texturePool.handles.Valid(tex)
+                  : !materialPool.handles.Valid(mat))) {
+      continue;
+    }
+    glm::vec3 center(modelPool.centerX[modelIdx], modelPool.centerY[modelIdx],
+                     modelPool.centerZ[modelIdx]);
+
+    // Hiding models behind the occluders. Occluders aren't tested, since
+    // they'd only hide behind themselves.
+    uint32_t meshIdx = meshPool.handles.Dense(mesh);
+    if (view.occlusion && meshPool.occluderTris[meshIdx].empty()) {
+      uint32_t numTris = meshPool.lods[meshIdx][0].count / 3;
+      ++slice->occlusionStats.tested;
+      slice->occlusionStats.testedTris += numTris;
+      glm::vec3 extent(modelPool.extentX[modelIdx],
+                       modelPool.extentY[modelIdx],
+                       modelPool.extentZ[modelIdx]);
+      if (!occlusionBuffer.BoxVisible(center, extent)) {
+        modelVisible[modelIdx] = 0;
+        ++slice->occlusionStats.occluded;
+        slice->occlusionStats.occludedTris += numTris;
+        continue;
+      }
+    }
+    ++slice->cullStats.visible;
+
+    float depth = view.camPtr->DepthFraction(center);
+    uint64_t key = RenderQueue::MakeKey(
+                     textured ? IMG_SHADER : PROP_SHADER,
+                     textured ? tex.index : mat.index, mesh.index, depth);
+    slice->queue.Push(key, modelIdx);
+  }
+  slice->queue.Sort();
+
+  // Splitting the sorted draws into batches. Sorting put models with the
+  // same shader, material, and mesh next to each other, so a batch ends
+  // wherever any of those or the LOD changes, or when it's full.
+  const std::vector<RenderQueue::Item>& items = slice->queue.Items();
+  std::vector<Batch>& batches = slice->batches;
+  batches.clear();
+  bool lastTextured = false;
+  uint32_t lastMatId = ~0u;
+  uint32_t lastMeshIdx = ~0u;
+  uint32_t itemPos = 0;
+  std::vector<RenderQueue::Item>::const_iterator itemIter = items.begin();
+  for (; itemIter != items.end(); ++itemIter, ++itemPos) {
+    uint32_t modelIdx = itemIter->index;
+    uint32_t meshIdx = meshPool.handles.Dense(modelPool.mesh[modelIdx]);
+    TextureHandle tex = modelPool.texture[modelIdx];
+    bool textured = !tex.IsNull();
+    uint32_t matId = textured ? tex.index : modelPool.material[modelIdx].index;
+    GLsizei lod = SelectLod(modelIdx, meshIdx, view.camPtr);
+
+    bool newMaterial = textured != lastTextured || matId != lastMatId;
+    if (batches.empty() || newMaterial || meshIdx != lastMeshIdx ||
+        lod != batches.back().lod ||
+        batches.back().numInstances == kMaxInstances) {
+      Batch batch;
+      batch.firstItem = itemPos;
+      batch.lod = lod;
+      batch.newMaterial = newMaterial;
+      batches.push_back(batch);
+      lastTextured = textured;
+      lastMatId = matId;
+      lastMeshIdx = meshIdx;
+    }
+    ++batches.back().numInstances;
+  }
+
+  // Counting the ring space RecordSlice will pack the batches into
+  slice->ringBytes = 0;
+  std::vector<Batch>::const_iterator batchIter = batches.begin();
+  for (; batchIter != batches.end(); ++batchIter) {
+    if (batchIter->newMaterial) {
+      slice->ringBytes += uniformRing->Aligned(sizeof(MaterialData));
+    }
+    slice->ringBytes += uniformRing->Aligned(
+                          batchIter->numInstances * sizeof(ObjectData));
+  }
+}
+
+// Writing each batch's material if it changed, then its instances'
+// matrices, in the order QueueSlice counted them
+void ModelManager::RecordSlice(const FrameView& view, Slice* slice) {
+  Profiler::Scope cpuScope("RecordSlice");
+  const std::vector<RenderQueue::Item>& items = slice->queue.Items();
+  slice->drawList.Clear();
+  GLintptr packed = 0;
+  GLintptr matOffset = 0;
+  std::vector<Batch>::const_iterator batchIter = slice->batches.begin();
+  for (; batchIter != slice->batches.end(); ++batchIter) {
+    uint32_t firstModel = items[batchIter->firstItem].index;
+    uint32_t meshIdx = meshPool.handles.Dense(modelPool.mesh[firstModel]);
+    TextureHandle tex = modelPool.texture[firstModel];
+    bool textured = !tex.IsNull();
+    DrawList::Packet packet;
+    packet.key = items[batchIter->firstItem].key;
+    packet.program = view.programs[textured ? IMG_SHADER : PROP_SHADER];
+
+    if (batchIter->newMaterial) {
+      MaterialData matData;
+      if (textured) {
+        matData.gloss = texturePool.gloss[texturePool.handles.Dense(tex)];
+      } else {
+        MaterialHandle mat = modelPool.material[firstModel];
+        uint32_t matIdx = materialPool.handles.Dense(mat);
+        matData.amb = materialPool.amb[matIdx];
+        matData.diff = materialPool.diff[matIdx];
+        matData.spec = materialPool.spec[matIdx];
+        matData.gloss = materialPool.gloss[matIdx];
+      }
+      std::memcpy(slice->ringData + packed, &matData, sizeof(matData));
+      matOffset = slice->ringOffset + packed;
+      packed += uniformRing->Aligned(sizeof(MaterialData));
+    }
+    packet.material = matOffset;
+    packet.textured = textured;
+    if (textured) {
+      uint32_t texIdx = texturePool.handles.Dense(tex);
+      packet.diffTex = texturePool.diffTex[texIdx];
+      packet.specTex = texturePool.specTex[texIdx];
+    }
+
+    // Filling the instance array in place. Compact positions are mapped
+    // back onto the mesh's bounding box by the model matrix; normals are
+    // decoded in the shader.
+    ObjectData* objData =
+      reinterpret_cast<ObjectData*>(slice->ringData + packed);
+    packet.objects = slice->ringOffset + packed;
+    packed += uniformRing->Aligned(
+                batchIter->numInstances * sizeof(ObjectData));
+    const glm::mat4& dequantMat = meshPool.dequantMat[meshIdx];
+    GLint octNorm = meshPool.compact[meshIdx];
+    for (uint32_t i = 0; i < batchIter->numInstances; ++i) {
+      uint32_t modelIdx = items[batchIter->firstItem + i].index;
+      const glm::mat3& normMat = modelPool.normMat[modelIdx];
+      objData[i].modelMat = modelPool.modelMat[modelIdx] * dequantMat;
+      objData[i].normMat[0] = glm::vec4(normMat[0], 0.0f);
+      objData[i].normMat[1] = glm::vec4(normMat[1], 0.0f);
+      objData[i].normMat[2] = glm::vec4(normMat[2], 0.0f);
+      objData[i].octNorm = octNorm;
+    }
+
+    // Resolving the LOD's range of the shared mesh buffer to plain offsets
+    MeshBuffer* buffer = meshPool.buffer[meshIdx];
+    const MeshLod& lod = meshPool.lods[meshIdx][batchIter->lod];
+    const MeshBuffer::Range& range = meshPool.range[meshIdx];
+    packet.indexType = meshPool.indexType[meshIdx];
+    size_t indexSz = packet.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                                           : sizeof(GLuint);
+    packet.vertexArray = buffer->VertexArray();
+    packet.numIndices = lod.count;
+    packet.indexOffset = buffer->IndexOffset(range) + lod.first * indexSz;
+    packet.baseVertex = buffer->BaseVertex(range);
+    packet.numInstances = batchIter->numInstances;
+    slice->drawList.Record(packet);
+  }
+}
+
+// Binds both shaders' material and per-object blocks, points the image
+// shader's samplers at their texture units, and creates the uniform ring
+void ModelManager::BindUniformBlocks(GLFWwindow* window) {
+  void** objArr = reinterpret_cast<void**>(glfwGetWindowUserPointer(window));
+  Shader* imgMatShader = reinterpret_cast<Shader*>(objArr[IMGSHDR]);
+  Shader* propMatShader = reinterpret_cast<Shader*>(objArr[PROPSHDR]);
+
+  imgMatShader->BindBlock(kMatData, kMatDataBinding);
+  imgMatShader->BindBlock(kObjData, kObjDataBinding);
+  propMatShader->BindBlock(kMatData, kMatDataBinding);
+  propMatShader->BindBlock(kObjData, kObjDataBinding);
+
+  // Catching a shader whose instance array size drifted from kMaxInstances
+  GLint objBlockSize = 0;
+  glGetActiveUniformBlockiv(propMatShader->id,
+                            propMatShader->BlockIndex(kObjData),
+                            GL_UNIFORM_BLOCK_DATA_SIZE, &objBlockSize);
+  if (objBlockSize != kObjBlockSize) {
+    std::cerr << "objData block is " << objBlockSize << " bytes, expected "
+              << kObjBlockSize << std::endl;
+  }
+
+  // Sampler units never change, so they're set once here rather than on
+  // every texture switch
+  imgMatShader->Use();
+  imgMatShader->LoadInt(0, kDiffSamp);
+  imgMatShader->LoadInt(1, kSpecSamp);
+  glState.CountUniform();
+  glState.CountUniform();
+  glUseProgram(0);
+
+  uniformRing = std::make_unique<UniformRing>(&glState, kRingFrameSize);
+}
+
+const GLStateCache::Counters& ModelManager::StateCounters() const {
+  return glState.ThisFrame();
+}
+
+const CullStats& ModelManager::CullCounters() const {
+  return cullStats;
+}
+
+void ModelManager::SetOccluders(std::vector<std::string> meshNames) {
+  occluderNames.insert(meshNames.begin(), meshNames.end());
+}
+
+const OcclusionStats& ModelManager::OcclusionCounters() const {
+  return occlusionStats;
+}
+
+JobSystem* ModelManager::Jobs() {
+  return &jobs;
+}
+
+// Expanding LOD 0's indices into a plain triangle list, which is what the
+// occlusion buffer walks
+void ModelManager::CopyOccluderTris(const MeshImport& result,
+                                    std::vector<glm::vec3>* tris) {
+  const Vertex* verts = result.mesh.verts.data();
+  const GLuint* indices = result.mesh.indices.data();
+  uint32_t numVerts = static_cast<uint32_t>(result.mesh.verts.size());
+  uint32_t numIndices = static_cast<uint32_t>(result.mesh.indices.size());
+  MeshLod lod = MeshLod{ 0, numIndices, 0.0f };
+  if (result.mesh.numLods > 0) {
+    lod = result.mesh.lods[0];
+  }
+  if (result.cooked) {
+    const MeshFileHeader* header = result.cooked->Header();
+    verts = reinterpret_cast<const Vertex*>(result.cooked->VertData());
+    indices = result.cooked->IndexData();
+    numVerts = header->numVerts;
+    numIndices = header->numIndices;
+    lod = MeshLod{ 0, numIndices, 0.0f };
+    if (header->numLods > 0) {
+      lod = header->lods[0];
+    }
+  }
+
+  // Only whole triangles inside the arrays are copied. MeshFile::Open has
+  // already checked cooked data; this keeps a bad range from ever reading
+  // past either array.
+  tris->clear();
+  uint64_t end = std::min<uint64_t>(static_cast<uint64_t>(lod.first) +
+                                      lod.count, numIndices);
+  for (uint64_t i = lod.first; i + 3 <= end; i += 3) {
+    if (indices[i] >= numVerts || indices[i + 1] >= numVerts ||
+        indices[i + 2] >= numVerts) {
+      continue;
+    }
+    tris->push_back(verts[indices[i]].pos);
+    tris->push_back(verts[indices[i + 1]].pos);
+    tris->push_back(verts[indices[i + 2]].pos);
+  }
+}
+
+// Only occluders at least partly inside the frustum are drawn
+void ModelManager::DrawOccluders(FrameView* view) {
+  Profiler::Scope cpuScope("DrawOccluders");
+  view->occlusion = false;
+  if (occluderModels.empty()) {
+    return;
+  }
+
+  Camera::CamData cam = view->camPtr->GetCamData();
+  occlusionBuffer.Begin(cam.proj * cam.view);
+  FrustumVolume frustum;
+  frustum.planes = view->planes;
+  std::vector<uint32_t>::iterator modelIter = occluderModels.begin();
+  for (; modelIter != occluderModels.end(); ++modelIter) {
+    uint32_t modelIdx = *modelIter;
+    MeshHandle mesh = modelPool.mesh[modelIdx];
+    if (!meshPool.handles.Valid(mesh)) {
+      continue;
+    }
+    glm::vec3 center(modelPool.centerX[modelIdx], modelPool.centerY[modelIdx],
+                     modelPool.centerZ[modelIdx]);
+    glm::vec3 extent(modelPool.extentX[modelIdx], modelPool.extentY[modelIdx],
+                     modelPool.extentZ[modelIdx]);
+    Bvh::Aabb box;
+    box.min = center - extent;
+    box.max = center + extent;
+    if (frustum.Classify(box) == Bvh::OUTSIDE) {
+      continue;
+    }
+    const std::vector<glm::vec3>& tris =
+      meshPool.occluderTris[meshPool.handles.Dense(mesh)];
+    occlusionBuffer.AddOccluder(tris.data(),
+                                static_cast<uint32_t>(tris.size() / 3),
+                                modelPool.modelMat[modelIdx]);
+  }
+  if (occlusionBuffer.NumTriangles() == 0) {
+    return;
+  }
+  occlusionBuffer.Rasterize(&jobs);
+  view->occlusion = true;
+}
+
+void ModelManager::SetLocalMat(std::string name, glm::mat4 localMat) {
+  std::map<std::string, TransformGraph::NodeId>::iterator node =
+    nodeNames.find(name);
+  if (node == nodeNames.end()) {
+    std::cerr << "Can't move unknown node " << name << std::endl;
+    return;
+  }
+  transforms.SetLocal(node->second, localMat);
+}
+
+std::vector<std::string> ModelManager::QueryModelNames() {
+  std::vector<std::string> names;
+  names.reserve(queryItems.size());
+  std::vector<uint32_t>::iterator itemIter = queryItems.begin();
+  for (; itemIter != queryItems.end(); ++itemIter) {
+    names.push_back(modelPool.name[*itemIter]);
   }
+  return names;
+}
+
+// Ordering hits by how far their box centers are from the ray's origin
+std::vector<std::string> ModelManager::ModelsOnRay(glm::vec3 origin,
+                                                   glm::vec3 dir,
+                                                   float maxDist) {
+  UpdateTransforms();
+  queryItems.clear();
+  sceneBvh.Query(RayVolume(origin, dir, maxDist), &queryItems);
+  std::sort(queryItems.begin(), queryItems.end(),
+            [&](uint32_t a, uint32_t b) {
+              glm::vec3 toA(modelPool.centerX[a], modelPool.centerY[a],
+                            modelPool.centerZ[a]);
+              glm::vec3 toB(modelPool.centerX[b], modelPool.centerY[b],
+                            modelPool.centerZ[b]);
+              toA -= origin;
+              toB -= origin;
+              return glm::dot(toA, toA) < glm::dot(toB, toB);
+            });
+  return QueryModelNames();
+}
+
+std::vector<std::string> ModelManager::ModelsInBox(glm::vec3 boxMin,
+                                                   glm::vec3 boxMax) {
+  BoxVolume volume;
+  volume.box.min = boxMin;
+  volume.box.max = boxMax;
+  UpdateTransforms();
+  queryItems.clear();
+  sceneBvh.Query(volume, &queryItems);
+  return QueryModelNames();
 }
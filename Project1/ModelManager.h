@@ -18,17 +18,34 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <array>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
 #include <vector>
-#include <map>
 
 #include <assimp/Importer.hpp>
 
 #include <glm/glm.hpp>
 
+#include "AssetRegistry.h"
+#include "Bvh.h"
+#include "FrustumCull.h"
+#include "GLStateCache.h"
+#include "HandlePool.h"
+#include "JobSystem.h"
 #include "Shader.h"
 #include "Camera.h"
+#include "DrawList.h"
+#include "MeshBuffer.h"
+#include "MeshCook.h"
+#include "MeshFile.h"
+#include "OcclusionCull.h"
+#include "RenderQueue.h"
+#include "TransformGraph.h"
+#include "UniformRing.h"
 
 // Model manager: Creates and stores models, materials, textures, and meshes.
 // Also loads texture images and mesh data into OpenGL context.
@@ -42,75 +59,371 @@ class ModelManager {
     SCENECAM
   };
 
-  // Materials. Used for models that do not have an image texture.
-  // Model Component.
-  struct Material {
-    glm::vec3 amb = glm::vec3(0.0f);
-    glm::vec3 diff = glm::vec3(0.0f);
-    glm::vec3 spec = glm::vec3(0.0f);
-    float gloss = 0.0f;
-  };
+  // Handle types for each pool. Tags only tell the handles apart.
+  typedef Handle<struct MaterialTag> MaterialHandle;
+  typedef Handle<struct TextureTag> TextureHandle;
+  typedef Handle<struct MeshTag> MeshHandle;
+  typedef Handle<struct ModelTag> ModelHandle;
 
-  // Textures. Used for models with image textures.
-  // Model Component.
-  struct Texture {
-    GLuint diffTex = 0;
-    GLuint specTex = 0;
-    float gloss = 0.0f;
-  };
+  // Vertex data, as read and cooked by MeshCook. Mesh component.
+  typedef MeshVertex Vertex;
 
-  // Vertex data. Holds 8 floats, 3 for position, 3 for normals, 2 for textures.
-  // Mesh component.
-  struct Vertex {
-    glm::vec3 pos = glm::vec3(0.0f);
-    glm::vec3 norm = glm::vec3(0.0f);
-    glm::vec2 uv = glm::vec3(0.0f);
-    friend std::ostream& operator<<(std::ostream& out, const Vertex& vert);
+  // Compact vertex data, 16 bytes instead of 32. Position is quantized to
+  // 16 bits per axis across the mesh's bounding box (pos[3] is padding),
+  // normal is octahedral encoded into two 16-bit snorms, and UVs are half
+  // floats. Mesh component, used when compact vertices are turned on.
+  struct CompactVertex {
+    GLushort pos[4] = { 0, 0, 0, 0 };
+    GLshort norm[2] = { 0, 0 };
+    GLushort uv[2] = { 0, 0 };
   };
 
 
-  // Mesh data. Holds Vertex Array and Buffer IDs,
-  // as well as vertex and index data. Model component.
+  // Mesh data as imported and loaded. Holds vertex and index data, and
+  // once LoadMesh is done, the shared mesh buffer it went into and its
+  // ranges of that buffer. The drawing fields are then copied into the mesh
+  // pool; the arrays are only kept while importing and cooking.
+  // Meshes loaded from a cooked file leave verts and indices empty, since
+  // their data is uploaded straight from the mapped file.
   struct Mesh {
-    GLuint VBO = 0;
-    GLuint VAO = 0;
-    GLuint EBO = 0;
+    MeshBuffer* buffer = nullptr;
+    MeshBuffer::Range range;
+    GLsizei numIndices = 0;
+    GLenum indexType = GL_UNSIGNED_INT;  // GL_UNSIGNED_SHORT if it fits
+    bool compact = false;                // vertices are CompactVertex
+    glm::mat4 dequantMat = glm::mat4(1.0f);  // compact pos to model space
+    MeshLod lods[kMaxLods];  // index ranges, full detail first
+    GLsizei numLods = 0;
+    MeshBounds bounds;       // local space box and sphere
+    uint64_t assetKey = 0;
     std::vector<Vertex> verts;
     std::vector<GLuint> indices;
+    std::vector<glm::vec3> occluderTris;  // full detail, for occluders only
   };
 
-  // Final Product of model manager. Has the name of its mesh and material
-  // (image- or property- based) and its matrices.
-  struct Model {
-    std::string meshName = "";
-    std::string matName = "";
-    glm::mat4 modelMat = glm::mat4(1.0f);
-    glm::mat3 normMat = glm::mat3(1.0f);
+  // Pools for materials, textures, meshes, and models. Each field is its own
+  // densely packed array, indexed by the position a handle maps to. Names
+  // are only looked up while creating and deleting.
+
+  // Property materials. Used for models that do not have an image texture.
+  struct MaterialPool {
+    HandleTable<MaterialTag> handles;
+    std::vector<glm::vec3> amb;
+    std::vector<glm::vec3> diff;
+    std::vector<glm::vec3> spec;
+    std::vector<float> gloss;
+  };
+
+  // Image textures. GL textures are shared through the image registry,
+  // keyed by the content hash of their files.
+  struct TexturePool {
+    HandleTable<TextureTag> handles;
+    std::vector<GLuint> diffTex;
+    std::vector<GLuint> specTex;
+    std::vector<float> gloss;
+    std::vector<uint64_t> diffKey;
+    std::vector<uint64_t> specKey;
+  };
+
+  // Loaded meshes, one per unique content hash. Names with the same
+  // contents share a handle through the mesh registry.
+  struct MeshPool {
+    HandleTable<MeshTag> handles;
+    std::vector<MeshBuffer*> buffer;
+    std::vector<MeshBuffer::Range> range;
+    std::vector<GLenum> indexType;
+    std::vector<GLint> compact;
+    std::vector<glm::mat4> dequantMat;
+    std::vector<std::array<MeshLod, kMaxLods>> lods;
+    std::vector<GLsizei> numLods;
+    std::vector<MeshBounds> bounds;
+    std::vector<uint64_t> assetKey;
+    std::vector<std::vector<glm::vec3>> occluderTris;  // empty if not one
+  };
+
+  // Models: a mesh, either a material or a texture, matrices, and the
+  // world space box around the mesh. Box components each get their own
+  // column so culling can load four models' worth at once. Each model's
+  // box is also a leaf in the scene BVH.
+  struct ModelPool {
+    HandleTable<ModelTag> handles;
+    std::vector<std::string> name;
+    std::vector<glm::mat4> modelMat;
+    std::vector<glm::mat3> normMat;
+    std::vector<MeshHandle> mesh;
+    std::vector<MaterialHandle> material;  // null when textured
+    std::vector<TextureHandle> texture;    // null when not textured
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+    std::vector<uint32_t> bvhLeaf;         // Bvh::kNoNode until indexed
+    std::vector<TransformGraph::NodeId> node;
+  };
+
+  // Shaders, in render queue sort order
+  enum ShaderSlot {
+    IMG_SHADER = 0,
+    PROP_SHADER = 1
   };
 
-  // Storage maps for materials, textures, meshes, and models
-  std::map<std::string, Material> materials;
-  std::map<std::string, Texture> textures;
-  std::map<std::string, Mesh> meshes;
-  std::map<std::string, Model> models;
+  MaterialPool materialPool;
+  TexturePool texturePool;
+  MeshPool meshPool;
+  ModelPool modelPool;
 
-  // Asset Importer (Reads mesh data from file in ReadMesh)
-  Assimp::Importer importer;
+  // Creation time lookups from names to handles
+  std::map<std::string, MaterialHandle> materialNames;
+  std::map<std::string, TextureHandle> textureNames;
+  std::map<std::string, MeshHandle> meshNames;
+  std::map<std::string, ModelHandle> modelNames;
 
-  // Reads mesh data from file, using a filename and a pointer to a mesh.
-  // Must be DAE format. Called by CreateMeshes.
-  void ReadMesh(std::string filename, Mesh* mesh);
+  // Every model has a node in the transform graph, and assemblies of
+  // models can share parent nodes that draw nothing. Names cover both.
+  // Model matrices in the model pool are copies of nodes' world matrices.
+  TransformGraph transforms;
+  std::map<std::string, TransformGraph::NodeId> nodeNames;
+  std::vector<ModelHandle> nodeModels;   // null for nodes without a model
+
+  // Shared, reference counted GL textures and meshes, keyed by content
+  // hash. Texture and mesh names above hold references into these.
+  AssetRegistry<GLuint> imageRegistry;
+  AssetRegistry<MeshHandle> meshRegistry;
+
+  // Runs imports, decodes, culling, and draw recording across threads. The
+  // thread constructing the manager is its main thread, and must own the
+  // GL context. Workers only run once main starts them through Jobs().
+  JobSystem jobs;
+
+  // Every bind made while loading and drawing goes through here, so
+  // ReplayPacket only changes state the next draw actually needs different.
+  // Declared before the buffers that keep pointers to it.
+  GLStateCache glState;
+
+  // One shared buffer per vertex format, indexed by Mesh::compact. Created
+  // by the first LoadMesh that needs it.
+  std::unique_ptr<MeshBuffer> meshBuffers[2];
+
+  // Every uniform block value that changes per frame. Created by
+  // BindUniformBlocks.
+  std::unique_ptr<UniformRing> uniformRing;
+
+  // A run of sorted draws that share shader, material, mesh, and LOD,
+  // drawn with one instanced draw call. Holds the run's first position in
+  // its slice's render queue, and whether its material block has to be
+  // written (only if it differs from the previous batch's).
+  struct Batch {
+    uint32_t firstItem = 0;
+    uint32_t numInstances = 0;
+    GLsizei lod = 0;
+    bool newMaterial = false;
+  };
+
+  // What every slice needs to know about the frame, gathered once on the
+  // GL thread
+  struct FrameView {
+    Camera* camPtr = nullptr;
+    glm::vec4 planes[6];
+    bool bvhCulled = false;   // modelVisible already holds frustum results
+    bool occlusion = false;   // the occlusion buffer has occluders drawn
+    GLuint programs[2] = { 0, 0 };  // by ShaderSlot
+  };
+
+  // One thread's share of a frame's models, a contiguous range of model
+  // positions, and everything it makes from them: its queued and batched
+  // draws, the ring space their uniforms take and where that went, and the
+  // packets recorded for them. Kept between frames so recording doesn't
+  // allocate.
+  struct Slice {
+    uint32_t firstModel = 0;
+    uint32_t endModel = 0;
+    RenderQueue queue;
+    std::vector<Batch> batches;
+    GLsizeiptr ringBytes = 0;
+    GLintptr ringOffset = 0;
+    unsigned char* ringData = nullptr;
+    DrawList drawList;
+    CullStats cullStats;
+    OcclusionStats occlusionStats;
+  };
+
+  // This frame's slices, and the order their packets are replayed in.
+  // The slices' draw lists and the merge's read positions in them are
+  // gathered into members, so merging allocates nothing once warmed up.
+  std::vector<Slice> slices;
+  std::vector<const DrawList*> sliceLists;
+  std::vector<size_t> mergeHeads;
+  std::vector<const DrawList::Packet*> packetOrder;
+
+  // Frustum test result for each model position, and this frame's totals
+  std::vector<uint8_t> modelVisible;
+  CullStats cullStats;
+
+  // Models' world boxes, with each model's dense position as its item.
+  // Scenes with at least kBvhMinModels models are culled through this
+  // rather than by testing every box.
+  Bvh sceneBvh;
+
+  // Model positions returned by the last scene BVH query. Kept between
+  // calls so querying doesn't allocate.
+  std::vector<uint32_t> queryItems;
+
+  // Names of meshes whose models hide what's behind them, set by
+  // SetOccluders. Their triangles are kept on the CPU when loaded.
+  std::set<std::string> occluderNames;
+
+  // Occluders' depth as seen from the camera, at a fraction of the window's
+  // resolution, and this frame's occlusion totals
+  OcclusionBuffer occlusionBuffer = OcclusionBuffer(256, 192);
+  OcclusionStats occlusionStats;
+
+  // Positions of models whose meshes are occluders
+  std::vector<uint32_t> occluderModels;
+
+  // Result of importing one unique mesh file on worker threads. OpenMesh
+  // gives it a content key (mesh.assetKey) and maps its cooked file if it
+  // has one; otherwise ImportMesh reads its verts and indices with Assimp.
+  // Handed to the GL thread for LoadMesh.
+  struct MeshImport {
+    std::string filename = "";
+    Mesh mesh;
+    std::unique_ptr<MeshFile> cooked;
+    bool occluder = false;  // some name for these contents is an occluder
+    bool failed = false;    // nothing read, never loaded or registered
+  };
 
-  // Loads mesh data into OpenGL context using a mesh struct.
-  // Called by CreateMeshes after ReadMesh
-  void LoadMesh(Mesh* mesh);
+  // Transforms a model's mesh box by its model matrix into the world box
+  // columns of the model pool, and moves its scene BVH leaf to match.
+  // Called by UpdateTransforms whenever the model matrix changes.
+  void UpdateWorldBounds(uint32_t modelIdx);
 
-  // Loads texture image into OpenGL context using a filename and
-  // texture ID. Called by CreateTextures.
-  void LoadTexture(std::string filename, GLuint* texIdPtr);
+  // Brings the transform graph up to date, then copies the world and
+  // normal matrices of every model it moved into the model pool and updates
+  // their world boxes. Costs nothing when no node has moved.
+  void UpdateTransforms();
 
-  // Draws the model.
-  void DrawModel(std::string modelName, GLFWwindow* window);
+  // Finds the node a definition names as its parent. Returns false after
+  // reporting it if the name is unknown; an empty name means no parent.
+  bool FindParent(const std::string& parentName,
+                  TransformGraph::NodeId* parent);
+
+  // Rebuilds the scene BVH from scratch over every model's world box.
+  // Called once CreateModels has added a batch of models.
+  void RebuildSceneBvh();
+
+  // Names of the models found by a scene BVH query
+  std::vector<std::string> QueryModelNames();
+
+  // Copies the full detail triangles of an imported mesh, three positions
+  // each, for drawing into the occlusion buffer
+  void CopyOccluderTris(const MeshImport& result,
+                        std::vector<glm::vec3>* tris);
+
+  // Draws occluders inside the view frustum into the occlusion buffer.
+  // Called by DrawModels on the GL thread before any slice is queued.
+  void DrawOccluders(FrameView* view);
+
+  // Culls a slice's models against the frustum and the occlusion buffer,
+  // queues and sorts the rest, and splits them into batches, totalling the
+  // ring space their uniforms need. Makes no GL calls, so slices run on
+  // worker threads in parallel.
+  void QueueSlice(const FrameView& view, Slice* slice);
+
+  // Packs a slice's batch uniforms into its region of the ring and records
+  // a draw packet for each batch. Makes no GL calls.
+  void RecordSlice(const FrameView& view, Slice* slice);
+
+  // Maps the cooked version of a mesh file if it's current, keying it by
+  // the mapped arrays, otherwise keys it by the bytes of its source file.
+  // Either way nothing is decoded, so copies are found before any are
+  // imported. Touches no OpenGL state, so it can run on any thread.
+  void OpenMesh(std::string filename, MeshImport* result);
+
+  // Reads and optimizes an opened mesh with CookMesh, unless its cooked
+  // file was mapped. Touches no OpenGL state, so it can run on any thread.
+  void ImportMesh(Assimp::Importer* importer, MeshImport* result);
+
+  // Loads an imported mesh into OpenGL and registers it by content key. If
+  // a mesh with the same contents is already loaded, only copies the
+  // occluder triangles it lacks. Failed imports are only reported. Must
+  // run on the GL thread.
+  void LoadImport(MeshImport* result);
+
+  // Copies vertex and index arrays into the shared mesh buffer for their
+  // format, storing the buffer and ranges in a mesh struct. Called by
+  // CreateMeshes after CookMesh, or with the arrays of a mapped cooked mesh
+  // file. Converts to CompactVertex when compact vertices are on, and to
+  // 16-bit indices whenever the vertex count allows.
+  void LoadMesh(Mesh* mesh, const Vertex* verts, GLsizei numVerts,
+                const GLuint* indices, GLsizei numIndices);
+
+  // Shared mesh buffer for a vertex format, creating it on first use
+  MeshBuffer* GetMeshBuffer(bool compact);
+
+  // Quantizes full vertices into compact ones, storing the matrix that maps
+  // quantized positions back to model space. Called by LoadMesh.
+  void CompactMesh(const Vertex* verts, GLsizei numVerts,
+                   std::vector<CompactVertex>* compactVerts,
+                   glm::mat4* dequantMat);
+
+  // Image read on a worker thread, waiting for upload on the GL thread.
+  // imgIdx is its index in CreateTextures' list of unique image files.
+  // Only the first file seen with a given content hash is decoded; other
+  // files with the same contents share that file's texture.
+  struct DecodedImage {
+    size_t imgIdx = 0;
+    uint64_t key = 0;
+    bool decoded = false;  // decoded by this copy, ready to upload
+    bool failed = false;   // unreadable or undecodable, never registered
+    std::string filename = "";
+    int width = 0;
+    int height = 0;
+    int numChannels = 0;
+    std::unique_ptr<unsigned char, void (*)(void*)> data{ nullptr, nullptr };
+    double decodeMs = 0.0;
+  };
+
+  // Largest on-screen error, in pixels, allowed when picking a model's LOD
+  float lodThreshold = 1.0f;
+
+  // True to upload meshes as CompactVertex. Set before CreateMeshes.
+  bool compactVerts = false;
+
+  // Bytes uploaded for vertex and index data, and bytes the full float
+  // format with 32-bit indices would have needed, for CreateMeshes' report
+  size_t meshBytes = 0;
+  size_t fullMeshBytes = 0;
+
+  // Maximum number of jobs decoding images at once in CreateTextures.
+  // 0 means one per job system thread.
+  unsigned int maxDecodeThreads = 0;
+
+  // Decodes texture image from the bytes of its file. Touches no OpenGL
+  // state, so it can run on any thread. Called by CreateTextures' workers.
+  void DecodeTexture(const std::vector<unsigned char>& fileData,
+                     DecodedImage* image);
+
+  // Loads decoded texture image into OpenGL context using a texture ID.
+  // Called by CreateTextures on the GL thread.
+  void LoadTexture(const DecodedImage& image, GLuint* texIdPtr);
+
+  // Adds a loaded mesh's drawing fields to the mesh pool
+  MeshHandle AddMesh(const Mesh& mesh);
+
+  // Removes a mesh from the pool, freeing its buffer ranges
+  void RemoveMesh(MeshHandle handle);
+
+  // Picks the coarsest LOD of a model's mesh whose error stays under the
+  // pixel threshold at the model's distance
+  GLsizei SelectLod(uint32_t modelIdx, uint32_t meshIdx, Camera* camPtr);
+
+  // Issues a recorded packet's binds and draw. The state cache skips
+  // binding its shader, material, and vertex array if the previous packet
+  // used the same ones. Called by DrawModels in sort key order, on the GL
+  // thread.
+  void ReplayPacket(const DrawList::Packet& packet);
 
  public:
   // Material definition, for use in CreateMaterials function by program.
@@ -130,22 +443,92 @@ class ModelManager {
     float gloss = 0.0f;
   };
 
-  // Model definition, for use in ModelTextures function by program.
+  // Model definition, for use in ModelTextures function by program. The
+  // model matrix is relative to the parent node, if the model has one.
   struct ModelDef {
     std::string modelName = "";
     std::string meshName = "";
     std::string matName = "";
     glm::mat4 modelMat = glm::mat4(1.0f);
+    std::string parentName = "";
+  };
+
+  // Node definition, for use in CreateNodes function by program. Nodes
+  // draw nothing; they move the models and nodes under them together.
+  struct NodeDef {
+    std::string nodeName = "";
+    std::string parentName = "";
+    glm::mat4 localMat = glm::mat4(1.0f);
   };
 
   // These functions are meant to be used by the program to load model data.
   // CreateModels should be called only after all materials, textures, and
-  // meshes have been created. DrawModels should only be called after all
+  // meshes have been created, and after CreateNodes for any parent nodes
+  // the models name. DrawModels should only be called after all
   // CreateModel calls are complete.
   void CreateMaterials(std::vector<MaterialDef> matDefs);
   void CreateTextures(std::vector<TextureDef> texDefs);
   void CreateMeshes(std::vector<std::string> filenames);
+  void CreateNodes(std::vector<NodeDef> nodeDefs);
   void CreateModels(std::vector<ModelDef> modDefs);
   void DrawModels(GLFWwindow* window);
+
+  // Binds the shaders' material and per-object uniform blocks and creates
+  // the uniform ring they're read from. Call once, before DrawModels.
+  void BindUniformBlocks(GLFWwindow* window);
+
+  // Binding calls made and skipped, and draw calls, in the last frame
+  // drawn, the same frame CullCounters and OcclusionCounters cover. Read
+  // them after DrawModels, before the next one starts.
+  const GLStateCache::Counters& StateCounters() const;
+
+  // Models tested against the view frustum and models that passed, in the
+  // last frame drawn
+  const CullStats& CullCounters() const;
+
+  // Makes models of these meshes hide the models behind them. Call before
+  // CreateMeshes; occluders should be few, large, and solid.
+  void SetOccluders(std::vector<std::string> meshNames);
+
+  // Models and triangles tested against the occluders and hidden by them,
+  // in the last frame drawn
+  const OcclusionStats& OcclusionCounters() const;
+
+  // Job system the manager runs its work on, for other engine work to share
+  JobSystem* Jobs();
+
+  // Moves a model or node relative to its parent. Everything under it
+  // follows; world matrices and boxes catch up on the next draw or query.
+  void SetLocalMat(std::string name, glm::mat4 localMat);
+
+  // Names of models whose world boxes a ray from origin along dir crosses
+  // within maxDist times dir's length, nearest center first. For picking.
+  std::vector<std::string> ModelsOnRay(glm::vec3 origin, glm::vec3 dir,
+                                       float maxDist);
+
+  // Names of models whose world boxes overlap a box, in no order
+  std::vector<std::string> ModelsInBox(glm::vec3 boxMin, glm::vec3 boxMax);
+
+  // Drop references to textures' images and meshes' buffers, freeing any
+  // GL textures or mesh buffer ranges no longer shared with anything else.
+  void DeleteTextures(std::vector<std::string> texNames);
+  void DeleteMeshes(std::vector<std::string> names);
+
+  // Packs the shared mesh buffers so all their free space is in one piece.
+  // Worth calling after deleting many meshes; CreateMeshes also does this
+  // on its own when a new mesh won't fit anywhere else.
+  void DefragmentMeshes();
+
+  // Turns the compact vertex format on or off for meshes created after this
+  // call. Off by default.
+  void SetCompactVerts(bool compact);
+
+  // Sets how far, in pixels, a LOD's surface may stray on screen from the
+  // full mesh before DrawModels uses a more detailed one. Default is 1.
+  void SetLodThreshold(float pixels);
+
+  // Caps the number of threads CreateTextures decodes images on.
+  // 0 (the default) uses one thread per core.
+  void SetDecodeThreads(unsigned int numThreads);
 };
 #endif
@@ -0,0 +1,252 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Occlusion culling draws a few large occluder meshes into a small depth
+// buffer on the CPU, then checks other models' world boxes against it: a
+// box whose nearest point is behind every occluder pixel it covers can't be
+// seen. The buffer is split into bands of rows, filled by separate jobs, so
+// jobs never write the same pixel. Pixels are filled four at a time with SSE
+// where available. Nothing here touches OpenGL, so it runs on weak GPUs
+// and without a window.
+#include "OcclusionCull.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define OCCLUSION_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+  // Fewest rows worth filling as a job of their own
+  const uint32_t kMinBandRows = 16;
+}  // namespace
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : width((width + 3) & ~3), height(height),
+      depth(static_cast<size_t>((width + 3) & ~3) * height, 1.0f) {}
+
+void OcclusionBuffer::Begin(const glm::mat4& viewProj) {
+  this->viewProj = viewProj;
+  std::fill(depth.begin(), depth.end(), 1.0f);
+  triangles.clear();
+}
+
+// Projecting to pixel space and setting up edge and depth planes once, so
+// filling only has to add and compare
+void OcclusionBuffer::AddOccluder(const glm::vec3* positions,
+                                  uint32_t numTris,
+                                  const glm::mat4& modelMat) {
+  glm::mat4 toClip = viewProj * modelMat;
+  for (uint32_t tri = 0; tri < numTris; ++tri) {
+    float x[3], y[3], z[3];
+    bool clipped = false;
+    for (int v = 0; v < 3; ++v) {
+      glm::vec4 clip = toClip * glm::vec4(positions[tri * 3 + v], 1.0f);
+      if (clip.z < -clip.w) {
+        clipped = true;
+        break;
+      }
+      x[v] = (clip.x / clip.w * 0.5f + 0.5f) * width;
+      y[v] = (clip.y / clip.w * 0.5f + 0.5f) * height;
+      z[v] = clip.z / clip.w;
+    }
+    if (clipped) {
+      continue;
+    }
+
+    // Winding either way round, since faces aren't culled when drawn
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0.0f) {
+      continue;
+    }
+    if (area < 0.0f) {
+      std::swap(x[1], x[2]);
+      std::swap(y[1], y[2]);
+      std::swap(z[1], z[2]);
+      area = -area;
+    }
+
+    Triangle setup;
+    setup.minX = std::max(0, static_cast<int>(std::floor(
+                   std::min(x[0], std::min(x[1], x[2])))));
+    setup.maxX = std::min(width - 1, static_cast<int>(std::ceil(
+                   std::max(x[0], std::max(x[1], x[2])))));
+    setup.minY = std::max(0, static_cast<int>(std::floor(
+                   std::min(y[0], std::min(y[1], y[2])))));
+    setup.maxY = std::min(height - 1, static_cast<int>(std::ceil(
+                   std::max(y[0], std::max(y[1], y[2])))));
+    if (setup.minX > setup.maxX || setup.minY > setup.maxY) {
+      continue;
+    }
+
+    // Edge e runs from vertex e to the next, and weights the vertex
+    // opposite it
+    float depthA = 0.0f, depthB = 0.0f, depthC = 0.0f;
+    for (int e = 0; e < 3; ++e) {
+      int from = e;
+      int to = (e + 1) % 3;
+      int opposite = (e + 2) % 3;
+      setup.edgeA[e] = y[from] - y[to];
+      setup.edgeB[e] = x[to] - x[from];
+      setup.edgeC[e] = -(setup.edgeA[e] * x[from] +
+                         setup.edgeB[e] * y[from]);
+      depthA += z[opposite] * setup.edgeA[e];
+      depthB += z[opposite] * setup.edgeB[e];
+      depthC += z[opposite] * setup.edgeC[e];
+    }
+    setup.depthA = depthA / area;
+    setup.depthB = depthB / area;
+    setup.depthC = depthC / area;
+    triangles.push_back(setup);
+  }
+}
+
+// Letting ParallelFor pick band sizes, but keeping bands tall enough that
+// setting up each triangle's rows isn't most of the work
+void OcclusionBuffer::Rasterize(JobSystem* jobs) {
+  jobs->ParallelFor(static_cast<uint32_t>(height),
+                    [this](uint32_t rowBegin, uint32_t rowEnd) {
+    RasterizeRows(static_cast<int>(rowBegin), static_cast<int>(rowEnd));
+  }, kMinBandRows);
+}
+
+// Walking each triangle's box within the band, keeping the nearer of the
+// stored depth and the triangle's at every pixel center inside all three
+// edges
+void OcclusionBuffer::RasterizeRows(int rowBegin, int rowEnd) {
+  std::vector<Triangle>::const_iterator triIter = triangles.begin();
+  for (; triIter != triangles.end(); ++triIter) {
+    const Triangle& tri = *triIter;
+    int minY = std::max(tri.minY, rowBegin);
+    int maxY = std::min(tri.maxY, rowEnd - 1);
+    for (int py = minY; py <= maxY; ++py) {
+      float centerY = py + 0.5f;
+      float rowEdge[3];
+      for (int e = 0; e < 3; ++e) {
+        rowEdge[e] = tri.edgeB[e] * centerY + tri.edgeC[e];
+      }
+      float rowDepth = tri.depthB * centerY + tri.depthC;
+      float* row = depth.data() + static_cast<size_t>(py) * width;
+      int px = tri.minX;
+
+#ifdef OCCLUSION_CULL_SSE
+      // Starting on a group boundary; width is a multiple of 4, so the
+      // last group never runs off the row
+      px &= ~3;
+      __m128 zero = _mm_setzero_ps();
+      __m128 edgeA0 = _mm_set1_ps(tri.edgeA[0]);
+      __m128 edgeA1 = _mm_set1_ps(tri.edgeA[1]);
+      __m128 edgeA2 = _mm_set1_ps(tri.edgeA[2]);
+      __m128 rowEdge0 = _mm_set1_ps(rowEdge[0]);
+      __m128 rowEdge1 = _mm_set1_ps(rowEdge[1]);
+      __m128 rowEdge2 = _mm_set1_ps(rowEdge[2]);
+      __m128 depthA = _mm_set1_ps(tri.depthA);
+      __m128 rowDepthV = _mm_set1_ps(rowDepth);
+      __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(px)),
+                                  _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+      __m128 four = _mm_set1_ps(4.0f);
+      for (; px <= tri.maxX; px += 4) {
+        __m128 inside = _mm_and_ps(
+          _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, centerX), rowEdge0),
+                       zero),
+          _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, centerX), rowEdge1),
+                       zero));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(
+          _mm_add_ps(_mm_mul_ps(edgeA2, centerX), rowEdge2), zero));
+        if (_mm_movemask_ps(inside) != 0) {
+          __m128 triDepth = _mm_add_ps(_mm_mul_ps(depthA, centerX),
+                                       rowDepthV);
+          __m128 stored = _mm_loadu_ps(row + px);
+          __m128 nearer = _mm_min_ps(stored, triDepth);
+          _mm_storeu_ps(row + px, _mm_or_ps(_mm_and_ps(inside, nearer),
+                                            _mm_andnot_ps(inside, stored)));
+        }
+        centerX = _mm_add_ps(centerX, four);
+      }
+#endif
+
+      for (; px <= tri.maxX; ++px) {
+        float centerX = px + 0.5f;
+        if (tri.edgeA[0] * centerX + rowEdge[0] >= 0.0f &&
+            tri.edgeA[1] * centerX + rowEdge[1] >= 0.0f &&
+            tri.edgeA[2] * centerX + rowEdge[2] >= 0.0f) {
+          row[px] = std::min(row[px], tri.depthA * centerX + rowDepth);
+        }
+      }
+    }
+  }
+}
+
+// Taking the screen rectangle and nearest depth of the box's corners, then
+// looking for any covered pixel whose occluder is no nearer than that
+bool OcclusionBuffer::BoxVisible(const glm::vec3& center,
+                                 const glm::vec3& extent) const {
+  glm::vec2 screenMin(FLT_MAX);
+  glm::vec2 screenMax(-FLT_MAX);
+  float nearest = FLT_MAX;
+  for (int corner = 0; corner < 8; ++corner) {
+    glm::vec3 sign((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f,
+                   (corner & 4) ? 1.0f : -1.0f);
+    glm::vec4 clip = viewProj * glm::vec4(center + sign * extent, 1.0f);
+    if (clip.z < -clip.w) {
+      return true;
+    }
+    glm::vec2 screen = (glm::vec2(clip) / clip.w * 0.5f + 0.5f) *
+                       glm::vec2(width, height);
+    screenMin = glm::min(screenMin, screen);
+    screenMax = glm::max(screenMax, screen);
+    nearest = std::min(nearest, clip.z / clip.w);
+  }
+
+  int minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+  int maxX = std::min(width - 1, static_cast<int>(std::floor(screenMax.x)));
+  int minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+  int maxY = std::min(height - 1, static_cast<int>(std::floor(screenMax.y)));
+  if (minX > maxX || minY > maxY) {
+    return false;
+  }
+
+  for (int py = minY; py <= maxY; ++py) {
+    const float* row = depth.data() + static_cast<size_t>(py) * width;
+    int px = minX;
+
+#ifdef OCCLUSION_CULL_SSE
+    __m128 nearestV = _mm_set1_ps(nearest);
+    for (; px + 4 <= maxX + 1; px += 4) {
+      if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + px),
+                                       nearestV)) != 0) {
+        return true;
+      }
+    }
+#endif
+
+    for (; px <= maxX; ++px) {
+      if (row[px] >= nearest) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+uint32_t OcclusionBuffer::NumTriangles() const {
+  return static_cast<uint32_t>(triangles.size());
+}
+
+int OcclusionBuffer::Width() const {
+  return width;
+}
+
+int OcclusionBuffer::Height() const {
+  return height;
+}
+
+const float* OcclusionBuffer::Depth() const {
+  return depth.data();
+}
@@ -0,0 +1,93 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// Occlusion culling draws a few large occluder meshes into a small depth
+// buffer on the CPU, then checks other models' world boxes against it: a
+// box whose nearest point is behind every occluder pixel it covers can't be
+// seen. The buffer is split into bands of rows, filled by separate jobs, so
+// jobs never write the same pixel. Pixels are filled four at a time with SSE
+// where available. Nothing here touches OpenGL, so it runs on weak GPUs
+// and without a window.
+#pragma once
+#ifndef OCCLUSION_CULL
+#define OCCLUSION_CULL
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "JobSystem.h"
+
+// Models tested against the occlusion buffer and models it hid, with the
+// triangles each set would have drawn, for reporting
+struct OcclusionStats {
+  uint32_t tested = 0;
+  uint32_t occluded = 0;
+  uint64_t testedTris = 0;
+  uint64_t occludedTris = 0;
+};
+
+class OcclusionBuffer {
+ private:
+  // An occluder triangle set up for filling. Each edge function is
+  // a * x + b * y + c, positive inside; depth is a plane over x and y in
+  // the same form. Bounds are inclusive pixel ranges.
+  struct Triangle {
+    float edgeA[3];
+    float edgeB[3];
+    float edgeC[3];
+    float depthA;
+    float depthB;
+    float depthC;
+    int minX;
+    int maxX;
+    int minY;
+    int maxY;
+  };
+
+  int width = 0;   // a multiple of 4, so rows split evenly into SSE groups
+  int height = 0;
+  glm::mat4 viewProj = glm::mat4(1.0f);
+
+  // NDC depth of the nearest occluder at each pixel center, row by row from
+  // the bottom of the screen. 1 where no occluder was drawn.
+  std::vector<float> depth;
+
+  // Occluder triangles added since Begin
+  std::vector<Triangle> triangles;
+
+  // Fills every triangle's pixels in rows [rowBegin, rowEnd)
+  void RasterizeRows(int rowBegin, int rowEnd);
+
+ public:
+  // Width is rounded up to a multiple of 4
+  OcclusionBuffer(int width, int height);
+
+  // Clears the buffer and drops last frame's triangles. Occluders and boxes
+  // are projected with viewProj until the next Begin.
+  void Begin(const glm::mat4& viewProj);
+
+  // Adds an occluder as a list of model space triangles, three positions
+  // each. Triangles reaching in front of the near plane are left out,
+  // since the GPU clips the part of them that would hide things.
+  void AddOccluder(const glm::vec3* positions, uint32_t numTris,
+                   const glm::mat4& modelMat);
+
+  // Fills the buffer with every added triangle, in bands of rows spread
+  // across jobs
+  void Rasterize(JobSystem* jobs);
+
+  // Whether any part of a world box might be seen past the occluders.
+  // Boxes reaching in front of the near plane always might.
+  bool BoxVisible(const glm::vec3& center, const glm::vec3& extent) const;
+
+  // Triangles added since Begin
+  uint32_t NumTriangles() const;
+  int Width() const;
+  int Height() const;
+  const float* Depth() const;
+};
+#endif
@@ -0,0 +1,240 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The Profiler class times scopes of CPU work on any thread and writes them,
+// with the GPU timings GpuProfiler hands it, to a Chrome trace for a range
+// of frames. Each thread records into its own ring buffer that only it
+// writes and only the GL thread reads, so a marker costs two clock reads
+// and no locks while a capture runs, and one relaxed load otherwise. The
+// trace opens in chrome://tracing or Perfetto.
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+  // Timings each thread's ring holds between frames. A power of two, so
+  // positions wrap with a mask.
+  const uint32_t kRingSize = 4096;
+
+  // Track the GPU's timings go on; threads are tracks 1 and up
+  const uint32_t kGpuTrack = 0;
+
+  struct Event {
+    const char* name;
+    uint32_t track;
+    int64_t begin;
+    int64_t end;
+  };
+
+  // One thread's recorded timings. The thread moves head forward as it
+  // records, and the GL thread moves tail forward as it collects.
+  struct ThreadLog {
+    std::string name;
+    uint32_t track = 0;
+    Event events[kRingSize];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> dropped{0};  // timings lost to a full ring
+  };
+
+  // Where a capture is. Only the GL thread changes it.
+  enum CaptureState {
+    IDLE,       // nothing to do
+    ARMED,      // recording starts with the next frame
+    RECORDING,  // scopes are recorded
+    FINISHING   // waiting on late GPU timings before writing
+  };
+
+  const std::chrono::steady_clock::time_point kClockStart =
+    std::chrono::steady_clock::now();
+
+  // Every thread's log. The lock is taken when a thread first records and
+  // once a frame to collect, never by a scope itself.
+  std::mutex logsLock;
+  std::vector<std::unique_ptr<ThreadLog>> logs;
+  thread_local ThreadLog* threadLog = nullptr;
+
+  std::atomic<bool> recording(false);
+
+  // Capture state, GL thread only
+  CaptureState state = IDLE;
+  uint32_t framesLeft = 0;
+  std::string tracePath = "profile.json";
+  std::vector<Event> captured;
+  int64_t frameBegin = 0;
+  int64_t captureBegin = 0;
+
+  // Calling thread's log, made the first time the thread records
+  ThreadLog* GetThreadLog() {
+    if (threadLog == nullptr) {
+      std::lock_guard<std::mutex> guard(logsLock);
+      logs.emplace_back(new ThreadLog());
+      threadLog = logs.back().get();
+      threadLog->track = static_cast<uint32_t>(logs.size());
+      threadLog->name = "Thread " + std::to_string(threadLog->track);
+    }
+    return threadLog;
+  }
+
+  // Adding a timing to the calling thread's ring, dropping it if the GL
+  // thread hasn't collected enough room
+  void Record(const char* name, int64_t begin, int64_t end) {
+    ThreadLog* log = GetThreadLog();
+    uint32_t head = log->head.load(std::memory_order_relaxed);
+    if (head - log->tail.load(std::memory_order_acquire) == kRingSize) {
+      log->dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    log->events[head & (kRingSize - 1)] =
+      Event{name, log->track, begin, end};
+    log->head.store(head + 1, std::memory_order_release);
+  }
+
+  // Moving every ring's timings into the capture
+  void Collect() {
+    std::lock_guard<std::mutex> guard(logsLock);
+    std::vector<std::unique_ptr<ThreadLog>>::iterator logIter = logs.begin();
+    for (; logIter != logs.end(); ++logIter) {
+      ThreadLog* log = logIter->get();
+      uint32_t tail = log->tail.load(std::memory_order_relaxed);
+      uint32_t head = log->head.load(std::memory_order_acquire);
+      for (; tail != head; ++tail) {
+        captured.push_back(log->events[tail & (kRingSize - 1)]);
+      }
+      log->tail.store(tail, std::memory_order_release);
+    }
+  }
+
+  // Microseconds since the capture began, the trace format's unit
+  double TraceTime(int64_t time) {
+    return (time - captureBegin) / 1000.0;
+  }
+
+  // Writing the capture as complete ("X") events, after naming each track
+  void WriteTrace() {
+    std::ofstream file(tracePath);
+    if (!file) {
+      std::cout << "Couldn't write trace to " << tracePath << std::endl;
+      return;
+    }
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+         << kGpuTrack << ",\"args\":{\"name\":\"GPU\"}}";
+    uint32_t dropped = 0;
+    {
+      std::lock_guard<std::mutex> guard(logsLock);
+      std::vector<std::unique_ptr<ThreadLog>>::iterator logIter =
+        logs.begin();
+      for (; logIter != logs.end(); ++logIter) {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+             << "\"tid\":" << (*logIter)->track << ",\"args\":{\"name\":\""
+             << (*logIter)->name << "\"}}";
+        dropped += (*logIter)->dropped.exchange(0);
+      }
+    }
+    std::vector<Event>::iterator eventIter = captured.begin();
+    for (; eventIter != captured.end(); ++eventIter) {
+      file << ",\n{\"name\":\"" << eventIter->name
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << eventIter->track
+           << ",\"ts\":" << TraceTime(eventIter->begin)
+           << ",\"dur\":" << (eventIter->end - eventIter->begin) / 1000.0
+           << "}";
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    std::cout << "Wrote " << captured.size() << " timings to " << tracePath;
+    if (dropped != 0) {
+      std::cout << " (" << dropped << " dropped by full buffers)";
+    }
+    std::cout << std::endl;
+  }
+}  // namespace
+
+Profiler::Scope::Scope(const char* name) : name(nullptr), begin(0) {
+  if (recording.load(std::memory_order_relaxed)) {
+    this->name = name;
+    begin = Now();
+  }
+}
+
+Profiler::Scope::~Scope() {
+  if (name != nullptr) {
+    Record(name, begin, Now());
+  }
+}
+
+void Profiler::SetThreadName(const std::string& name) {
+  ThreadLog* log = GetThreadLog();
+  std::lock_guard<std::mutex> guard(logsLock);
+  log->name = name;
+}
+
+int64_t Profiler::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - kClockStart).count();
+}
+
+bool Profiler::Recording() {
+  return recording.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetTracePath(const std::string& path) {
+  tracePath = path;
+}
+
+void Profiler::Capture(uint32_t numFrames) {
+  if (state != IDLE || numFrames == 0) {
+    return;
+  }
+  framesLeft = numFrames;
+  state = ARMED;
+}
+
+void Profiler::AddGpuEvent(const char* name, int64_t begin, int64_t end) {
+  if (state == RECORDING || state == FINISHING) {
+    captured.push_back(Event{name, kGpuTrack, begin, end});
+  }
+}
+
+// Frames are marked here on the GL thread's track, from the end of one
+// EndFrame to the end of the next
+void Profiler::EndFrame() {
+  int64_t now = Now();
+  if (state == RECORDING || state == FINISHING) {
+    Collect();
+  }
+  switch (state) {
+    case ARMED:
+      state = RECORDING;
+      captureBegin = now;
+      recording = true;
+      break;
+    case RECORDING:
+      captured.push_back(
+        Event{"Frame", GetThreadLog()->track, frameBegin, now});
+      if (--framesLeft == 0) {
+        recording = false;
+        state = FINISHING;
+        framesLeft = kLateFrames;
+      }
+      break;
+    case FINISHING:
+      if (--framesLeft == 0) {
+        WriteTrace();
+        captured.clear();
+        state = IDLE;
+      }
+      break;
+    default:
+      break;
+  }
+  frameBegin = now;
+}
@@ -0,0 +1,63 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The Profiler class times scopes of CPU work on any thread and writes them,
+// with the GPU timings GpuProfiler hands it, to a Chrome trace for a range
+// of frames. Each thread records into its own ring buffer that only it
+// writes and only the GL thread reads, so a marker costs two clock reads
+// and no locks while a capture runs, and one relaxed load otherwise. The
+// trace opens in chrome://tracing or Perfetto.
+#pragma once
+#ifndef PROFILER
+#define PROFILER
+
+#include <cstdint>
+#include <string>
+
+class Profiler {
+ public:
+    // GPU timings may arrive this many frames after the work they time, so
+    // a capture stays open this long after its last frame
+    static constexpr uint32_t kLateFrames = 4;
+
+    // Times the rest of the enclosing scope on the calling thread, if a
+    // capture is recording when it starts. The name must outlive the
+    // capture, which a string literal does.
+    class Scope {
+     private:
+        const char* name;
+        int64_t begin;
+
+     public:
+        explicit Scope(const char* name);
+        ~Scope();
+    };
+
+    // Names the calling thread's track in the trace
+    static void SetThreadName(const std::string& name);
+
+    // Nanoseconds on the clock every timing is measured with
+    static int64_t Now();
+
+    // Whether scopes starting now are recorded
+    static bool Recording();
+
+    // File the next capture is written to, "profile.json" unless changed
+    static void SetTracePath(const std::string& path);
+
+    // Records the next numFrames frames, then writes them to the trace
+    // file. Ignored while another capture is under way. GL thread only.
+    static void Capture(uint32_t numFrames);
+
+    // Adds a GPU timing, already on Now's clock, to the capture. GL thread
+    // only.
+    static void AddGpuEvent(const char* name, int64_t begin, int64_t end);
+
+    // Ends the frame: collects what every thread recorded, and starts,
+    // finishes, or writes a capture. Called once a frame on the GL thread,
+    // after GpuProfiler::EndFrame.
+    static void EndFrame();
+};
+#endif
@@ -0,0 +1,90 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The RenderQueue class orders a frame's draws by a 64-bit sort key. Keys
+// pack, from the top bit down, the shader, the material (or texture), the
+// mesh, and the depth, so sorted draws group by the state that costs the
+// most to change and, within one material and mesh, go front to back so
+// early depth testing rejects hidden fragments. Keys are sorted with a
+// radix sort, which is linear in the number of draws.
+#include "RenderQueue.h"
+
+namespace {
+  // Radix sort works a byte at a time
+  const int kRadixBits = 8;
+  const int kNumBuckets = 1 << kRadixBits;
+  const int kNumPasses = 64 / kRadixBits;
+
+  uint64_t FieldMask(int bits) {
+    return (1ULL << bits) - 1;
+  }
+}  // namespace
+
+// Shifting each field into place, most significant first
+uint64_t RenderQueue::MakeKey(uint32_t shader, uint32_t material,
+                              uint32_t mesh, float depth) {
+  if (depth < 0.0f) {
+    depth = 0.0f;
+  } else if (depth > 1.0f) {
+    depth = 1.0f;
+  }
+  uint64_t quantDepth =
+    static_cast<uint64_t>(depth * static_cast<float>(FieldMask(kDepthBits)));
+
+  uint64_t key = shader & FieldMask(kShaderBits);
+  key = (key << kMaterialBits) | (material & FieldMask(kMaterialBits));
+  key = (key << kMeshBits) | (mesh & FieldMask(kMeshBits));
+  key = (key << kDepthBits) | (quantDepth & FieldMask(kDepthBits));
+  return key;
+}
+
+void RenderQueue::Clear() {
+  items.clear();
+}
+
+void RenderQueue::Push(uint64_t key, uint32_t index) {
+  items.push_back(Item{ key, index });
+}
+
+// Least significant digit first radix sort. All byte histograms are built
+// in one read of the keys; passes where every key has the same byte (the
+// usual case for the high shader and material bytes) are skipped.
+void RenderQueue::Sort() {
+  size_t numItems = items.size();
+  if (numItems < 2) {
+    return;
+  }
+  scratch.resize(numItems);
+
+  // Counting each byte value at each byte position
+  size_t counts[kNumPasses][kNumBuckets] = {};
+  for (size_t i = 0; i < numItems; ++i) {
+    uint64_t key = items[i].key;
+    for (int pass = 0; pass < kNumPasses; ++pass) {
+      ++counts[pass][(key >> (pass * kRadixBits)) & (kNumBuckets - 1)];
+    }
+  }
+
+  for (int pass = 0; pass < kNumPasses; ++pass) {
+    int shift = pass * kRadixBits;
+    size_t* passCounts = counts[pass];
+    if (passCounts[(items[0].key >> shift) & (kNumBuckets - 1)] == numItems) {
+      continue;
+    }
+
+    // Turning counts into starting positions, then scattering stably
+    size_t offset = 0;
+    for (int bucket = 0; bucket < kNumBuckets; ++bucket) {
+      size_t count = passCounts[bucket];
+      passCounts[bucket] = offset;
+      offset += count;
+    }
+    for (size_t i = 0; i < numItems; ++i) {
+      size_t bucket = (items[i].key >> shift) & (kNumBuckets - 1);
+      scratch[passCounts[bucket]++] = items[i];
+    }
+    items.swap(scratch);
+  }
+}
@@ -0,0 +1,60 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The RenderQueue class orders a frame's draws by a 64-bit sort key. Keys
+// pack, from the top bit down, the shader, the material (or texture), the
+// mesh, and the depth, so sorted draws group by the state that costs the
+// most to change and, within one material and mesh, go front to back so
+// early depth testing rejects hidden fragments. Keys are sorted with a
+// radix sort, which is linear in the number of draws.
+#pragma once
+#ifndef RENDER_QUEUE
+#define RENDER_QUEUE
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class RenderQueue {
+ public:
+  // Key layout: shader in the top 4 bits, then 16 bits of material,
+  // 20 bits of mesh, and 24 bits of depth
+  static const int kShaderBits = 4;
+  static const int kMaterialBits = 16;
+  static const int kMeshBits = 20;
+  static const int kDepthBits = 24;
+
+  // One draw: its key, and the caller's index for whatever it draws
+  struct Item {
+    uint64_t key = 0;
+    uint32_t index = 0;
+  };
+
+ private:
+  std::vector<Item> items;
+
+  // Second array for the sort to ping-pong through. Kept between frames so
+  // sorting doesn't allocate.
+  std::vector<Item> scratch;
+
+ public:
+  // Packs a sort key. IDs are masked to their field widths; depth is a
+  // fraction from 0 (near plane) to 1 (far plane).
+  static uint64_t MakeKey(uint32_t shader, uint32_t material, uint32_t mesh,
+                          float depth);
+
+  // Empties the queue, keeping its memory for the next frame
+  void Clear();
+
+  // Queues a draw
+  void Push(uint64_t key, uint32_t index);
+
+  // Sorts queued draws by key, ascending. Equal keys keep push order.
+  void Sort();
+
+  // Queued draws, in sorted order after Sort
+  const std::vector<Item>& Items() const { return items; }
+};
+#endif
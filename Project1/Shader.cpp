@@ -8,12 +8,61 @@
 // the shader program in the opengl context. Each shader also has utility
 // functions to load matrices, vectors, and floats into it, as well as Use,
 // which sets the shader as the active program in the OpenGL context.
+// After linking, every active uniform and uniform block is looked up once
+// and stored by the hash of its name, so loading a uniform never touches a
+// string or asks OpenGL where it is.
 #pragma once
 
 #include "Shader.h"
 
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+
+namespace {
+  // Functions shared by every program, inserted into each stage's source
+  const char* kCommonSrcFile = "Common.glsl";
+
+  // Reads a whole shader source file from the shader directory
+  std::string ReadSource(const std::string& srcFile) {
+    std::ifstream file("shader/" + srcFile);
+    if (!file.is_open()) {
+      std::cerr << "Could not open shader/" << srcFile << std::endl;
+      return "";
+    }
+    std::ostringstream src;
+    src << file.rdbuf();
+    return src.str();
+  }
+
+  // Compiles a stage with the common source inserted right after its
+  // #version line, which has to come first. A #line directive after the
+  // common source restores the stage's own numbering, so compile errors
+  // still point at the right line of its file.
+  void CompileStage(GLuint stageId, const std::string& src,
+                    const std::string& common) {
+    size_t split = src.find("#version");
+    if (split != std::string::npos) {
+      split = src.find('\n', split);
+      split = split == std::string::npos ? src.size() : split + 1;
+    } else {
+      split = 0;
+    }
+    long nextLine = std::count(src.begin(), src.begin() + split, '\n') + 1;
+    std::string inserted = "\n" + common + "\n#line " +
+                           std::to_string(nextLine) + "\n";
+
+    const GLchar* parts[3] = { src.data(), inserted.data(),
+                               src.data() + split };
+    GLint lengths[3] = { static_cast<GLint>(split),
+                         static_cast<GLint>(inserted.size()),
+                         static_cast<GLint>(src.size() - split) };
+    glShaderSource(stageId, 3, parts, lengths);
+    glCompileShader(stageId);
+  }
+}  // namespace
 
 // Shader constructor. Takes in a vertex and fragment shader source file,
 // generates an id, and creates a program from vert and frag sources.
@@ -25,35 +74,15 @@ Shader::Shader(std::string vertSrcFile, std::string fragSrcFile) {
   GLuint vertId = glCreateShader(GL_VERTEX_SHADER);
   GLuint fragId = glCreateShader(GL_FRAGMENT_SHADER);
 
-  // array to hold src c string
-  char* src = new char[8192];
-
-  // holds number of characters read from ifstream
-  GLint charCnt = 0;
-
-  // Input file stream for source
-  std::ifstream src_file;
+  // Source shared by both stages
+  std::string common = ReadSource(kCommonSrcFile);
 
-  // open vertex source file stream, read chars and char count, close stream.
-  src_file.open("shader/" + vertSrcFile);
-  src_file.get(src, 8192, '\0');
-  charCnt = static_cast<int>(src_file.gcount());
-  src_file.close();
-
-  // Loading vertex shader source, compiling, and attaching shader.
-  glShaderSource(vertId, 1, &src, &charCnt);
-  glCompileShader(vertId);
+  // Compiling and attaching vertex shader
+  CompileStage(vertId, ReadSource(vertSrcFile), common);
   glAttachShader(id, vertId);
 
-  // Open fragment source file stream, read chars and char count, close stream.
-  src_file.open("shader/" + fragSrcFile);
-  src_file.get(src, 8192, '\0');
-  charCnt = static_cast<int>(src_file.gcount());
-  src_file.close();
-
-  // Loading fragment shader source, compiling, and attaching shader.
-  glShaderSource(fragId, 1, &src, &charCnt);
-  glCompileShader(fragId);
+  // Compiling and attaching fragment shader
+  CompileStage(fragId, ReadSource(fragSrcFile), common);
   glAttachShader(id, fragId);
 
   // Link program
@@ -65,6 +94,103 @@ Shader::Shader(std::string vertSrcFile, std::string fragSrcFile) {
   // Delete shaders (the program has them now)
   glDeleteShader(vertId);
   glDeleteShader(fragId);
+
+  // Building uniform and block tables
+  Reflect();
+}
+
+// Asks the program for every active uniform and block, once
+void Shader::Reflect() {
+  GLint numUniforms = 0;
+  GLint maxNameLen = 0;
+  glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &numUniforms);
+  glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLen);
+  std::vector<GLchar> name(std::max(maxNameLen, 1));
+  for (GLint i = 0; i < numUniforms; ++i) {
+    GLsizei nameLen = 0;
+    GLint arraySz = 0;
+    GLenum type = 0;
+    glGetActiveUniform(id, i, static_cast<GLsizei>(name.size()), &nameLen,
+                       &arraySz, &type, name.data());
+
+    // Members of uniform blocks have no location, they're set by buffer
+    GLint location = glGetUniformLocation(id, name.data());
+    if (location == -1) {
+      continue;
+    }
+
+    // Arrays are listed as "name[0]"; they're loaded by plain name
+    std::string uName(name.data(), nameLen);
+    if (uName.size() > 3 && uName.compare(uName.size() - 3, 3, "[0]") == 0) {
+      uName.resize(uName.size() - 3);
+    }
+    uniforms.push_back(UniformEntry{ HashUniform(uName.c_str()), location });
+  }
+
+  GLint numBlocks = 0;
+  glGetProgramiv(id, GL_ACTIVE_UNIFORM_BLOCKS, &numBlocks);
+  glGetProgramiv(id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLen);
+  name.resize(std::max(maxNameLen, 1));
+  for (GLint i = 0; i < numBlocks; ++i) {
+    glGetActiveUniformBlockName(id, i, static_cast<GLsizei>(name.size()),
+                                nullptr, name.data());
+    blocks.push_back(BlockEntry{ HashUniform(name.data()),
+                                 static_cast<GLuint>(i) });
+  }
+
+  // Sorting for lookups. Two names with the same hash would make one of
+  // them unreachable, so that's reported.
+  std::sort(uniforms.begin(), uniforms.end(),
+            [](const UniformEntry& a, const UniformEntry& b) {
+              return a.uId < b.uId;
+            });
+  std::sort(blocks.begin(), blocks.end(),
+            [](const BlockEntry& a, const BlockEntry& b) {
+              return a.uId < b.uId;
+            });
+  for (size_t i = 1; i < uniforms.size(); ++i) {
+    if (uniforms[i].uId == uniforms[i - 1].uId) {
+      std::cerr << "Uniform name hash collision in program " << id
+                << std::endl;
+    }
+  }
+}
+
+// Binary search of the uniform table
+GLint Shader::Location(UniformId uId) const {
+  std::vector<UniformEntry>::const_iterator entry =
+    std::lower_bound(uniforms.begin(), uniforms.end(), uId,
+                     [](const UniformEntry& e, UniformId key) {
+                       return e.uId < key;
+                     });
+  if (entry == uniforms.end() || entry->uId != uId) {
+    return -1;
+  }
+  return entry->location;
+}
+
+// Binary search of the block table
+GLuint Shader::BlockIndex(UniformId uId) const {
+  std::vector<BlockEntry>::const_iterator entry =
+    std::lower_bound(blocks.begin(), blocks.end(), uId,
+                     [](const BlockEntry& e, UniformId key) {
+                       return e.uId < key;
+                     });
+  if (entry == blocks.end() || entry->uId != uId) {
+    return GL_INVALID_INDEX;
+  }
+  return entry->index;
+}
+
+// Binds a uniform block to a binding point
+void Shader::BindBlock(UniformId uId, GLuint binding) {
+  GLuint blockIdx = BlockIndex(uId);
+  if (blockIdx == GL_INVALID_INDEX) {
+    std::cerr << "Uniform block not found: 0x" << std::hex << uId
+              << std::dec << std::endl;
+    return;
+  }
+  glUniformBlockBinding(id, blockIdx, binding);
 }
 
 // Called to use the shader program represented by the object.
@@ -73,12 +199,12 @@ void Shader::Use() {
 }
 
 // Loads integers into shader
-void Shader::LoadInt(int val, std::string uName) {
+void Shader::LoadInt(int val, UniformId uId) {
   // Get location of variable
-  GLint valLoc = glGetUniformLocation(id, uName.c_str());
-  // OpenGL returns -1 if uniform not found, exit.
+  GLint valLoc = Location(uId);
+  // -1 if uniform not found, exit.
   if (valLoc == -1) {
-    std::cerr << "Uniform not found: " << uName << std::endl;
+    PrintMissingUniform(uId);
     return;
   }
   // Load integer into shader
@@ -86,18 +212,24 @@ void Shader::LoadInt(int val, std::string uName) {
 }
 
 // Loads floats into shader
-void Shader::LoadFloat(float val, std::string uName) {
+void Shader::LoadFloat(float val, UniformId uId) {
   // Get location of variable
-  GLint valLoc = glGetUniformLocation(id, uName.c_str());
-  // OpenGL returns -1 if uniform not found, exit.
+  GLint valLoc = Location(uId);
+  // -1 if uniform not found, exit.
   if (valLoc == -1) {
-    std::cerr << "Uniform not found: " << uName << std::endl;
+    PrintMissingUniform(uId);
     return;
   }
   // Load float into shader
   glUniform1f(valLoc, val);
 }
 
+// Prints uniform hash in hex
+void PrintMissingUniform(UniformId uId) {
+  std::cerr << "Uniform not found: 0x" << std::hex << uId << std::dec
+            << std::endl;
+}
+
 void PrintInfoLog(GLuint obj, int type) {
   // Enum for readability
   enum ShaderTypes {
@@ -8,6 +8,9 @@
 // the shader program in the opengl context. Each shader also has utility
 // functions to load matrices, vectors, and floats into it, as well as Use,
 // which sets the shader as the active program in the OpenGL context.
+// After linking, every active uniform and uniform block is looked up once
+// and stored by the hash of its name, so loading a uniform never touches a
+// string or asks OpenGL where it is.
 #pragma once
 #ifndef SHD_MGR
 #define SHD_MGR
@@ -15,6 +18,7 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <string>
@@ -27,7 +31,37 @@ enum objType {
   PROGRAM = 1
 };
 
+// Uniform IDs are 32-bit FNV-1a hashes of uniform names. Being constexpr,
+// HashUniform runs at compile time when given a literal, so callers can
+// keep IDs in constants: constexpr UniformId kGloss = HashUniform("gloss");
+typedef uint32_t UniformId;
+constexpr UniformId HashUniform(const char* name,
+                                UniformId hash = 2166136261u) {
+  return *name == '\0'
+           ? hash
+           : HashUniform(name + 1,
+                         (hash ^ static_cast<unsigned char>(*name)) *
+                           16777619u);
+}
+
 class Shader {
+ private:
+  // Location of each active uniform, and index of each uniform block,
+  // sorted by ID for binary search
+  struct UniformEntry {
+    UniformId uId = 0;
+    GLint location = -1;
+  };
+  struct BlockEntry {
+    UniformId uId = 0;
+    GLuint index = GL_INVALID_INDEX;
+  };
+  std::vector<UniformEntry> uniforms;
+  std::vector<BlockEntry> blocks;
+
+  // Fills the uniform and block tables from the linked program
+  void Reflect();
+
  public:
   GLuint id = 0;  // Shader object's id, given by OpenGL context.
 
@@ -37,34 +71,47 @@ class Shader {
   // Called to use the shader program represented by the object
   void Use();
 
+  // Location of an active uniform, or -1 if the program doesn't use it.
+  // Callers that load the same uniform every frame can keep the result.
+  GLint Location(UniformId uId) const;
+
+  // Index of a uniform block, or GL_INVALID_INDEX if there's no such block
+  GLuint BlockIndex(UniformId uId) const;
+
+  // Points a uniform block at a uniform buffer binding point
+  void BindBlock(UniformId uId, GLuint binding);
+
   // function to load single int into shader
-  void LoadInt(int val, std::string name);
+  void LoadInt(int val, UniformId uId);
 
   // function to load single floats into shader
-  void LoadFloat(float val, std::string name);
+  void LoadFloat(float val, UniformId uId);
 
   // Templated function to take integer vectors of any size 2-4.
   template <int vSz, glm::qualifier Q>
-  void LoadVector(struct glm::vec<vSz, float, Q> vector, std::string uName);
+  void LoadVector(struct glm::vec<vSz, float, Q> vector, UniformId uId);
 
   // Templated function to take float vectors of any size 2-4.
   template <int size, glm::qualifier qual>
-  void LoadVector(struct glm::vec<size, int, qual> vector, std::string uName);
+  void LoadVector(struct glm::vec<size, int, qual> vector, UniformId uId);
 
   // Templated function to take float matrices of any size 2-4.
   template <int col, int row, glm::qualifier qual>
   void LoadMatrix(struct glm::mat<col, row, float, qual> matrix,
-                  std::string uName);
+                  UniformId uId);
 };
 
+// Prints a missing uniform's ID. Only the hash of its name is known here.
+void PrintMissingUniform(UniformId uId);
+
 template <int col, int row, glm::qualifier qual>
 void Shader::LoadMatrix(struct glm::mat<col, row, float, qual> matrix,
-                        std::string uName) {
+                        UniformId uId) {
   // Get location of matrix
-  GLint matLoc = glGetUniformLocation(id, uName.c_str());
-  // OpenGL returns -1 if uniform not found, exit
+  GLint matLoc = Location(uId);
+  // -1 if uniform not found, exit
   if (matLoc == -1) {
-    std::cout << "Uniform not found: " << uName << std::endl;
+    PrintMissingUniform(uId);
     return;
   }
 
@@ -134,13 +181,13 @@ void Shader::LoadMatrix(struct glm::mat<col, row, float, qual> matrix,
 
 template <int vSz, glm::qualifier Q>
 void Shader::LoadVector(struct glm::vec<vSz, float, Q> vector,
-                        std::string uName) {
+                        UniformId uId) {
   // Get location of vector
-  GLint vecLoc = glGetUniformLocation(id, uName.c_str());
+  GLint vecLoc = Location(uId);
 
-  // OpenGL returns -1 if uniform not found, exit
+  // -1 if uniform not found, exit
   if (vecLoc == -1) {
-    std::cout << "Uniform not found: " << uName << std::endl;
+    PrintMissingUniform(uId);
     return;
   }
 
@@ -169,13 +216,13 @@ void Shader::LoadVector(struct glm::vec<vSz, float, Q> vector,
 // Templated function to take float vectors of any size 2-4.
 template <int size, glm::qualifier qual>
 void Shader::LoadVector(struct glm::vec<size, int, qual> vector,
-                        std::string uName) {
+                        UniformId uId) {
   // Get location of vector
-  GLint vecLoc = glGetUniformLocation(id, uName.c_str());
+  GLint vecLoc = Location(uId);
 
-  // OpenGL returns -1 if uniform not found, exit
+  // -1 if uniform not found, exit
   if (vecLoc == -1) {
-    std::cout << "Uniform not found." << std::endl;
+    PrintMissingUniform(uId);
     return;
   }
 
@@ -0,0 +1,126 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The SimLoop class runs the simulation on its own thread at a fixed rate:
+// each tick takes the input the window manager gathered and moves its own
+// camera by one fixed step. After each tick it publishes a snapshot of the
+// scene state through a triple buffer, so the render thread always finds a
+// complete, recent snapshot without waiting on a lock, and the simulation
+// never waits on a frame. How fast the camera moves and how soon it reacts
+// to input no longer depend on how long frames take to draw.
+#include "SimLoop.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+namespace {
+  // Ticks per second, and the length of one tick
+  const int kTickRate = 120;
+  const std::chrono::nanoseconds kTickLength(1000000000 / kTickRate);
+
+  // Ticks the loop runs back to back to catch up after falling behind,
+  // such as after the window was dragged, before it gives up on the lost
+  // time instead
+  const int kMaxCatchUpTicks = 8;
+
+  // Set in the waiting slot index while it holds an unread snapshot
+  const uint32_t kFreshState = 4;
+  const uint32_t kStateMask = 3;
+}  // namespace
+
+SimLoop::SimLoop(WindowManager* winMgr, const Camera& camera)
+    : winMgr(winMgr), camera(camera), waitingState(2), running(false) {
+  states.assign(3, SimState{camera, 0});
+}
+
+SimLoop::~SimLoop() {
+  Stop();
+}
+
+void SimLoop::Start() {
+  if (running) {
+    return;
+  }
+  running = true;
+  thread = std::thread(&SimLoop::Run, this);
+}
+
+void SimLoop::Stop() {
+  running = false;
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+// Sleeping until each tick is due. Ticks keep to a fixed schedule rather
+// than a fixed gap, so time spent ticking doesn't slow the simulation down.
+void SimLoop::Run() {
+  Profiler::SetThreadName("Simulation");
+  std::chrono::steady_clock::time_point nextTick =
+    std::chrono::steady_clock::now();
+  while (running) {
+    Tick(winMgr->TakeInput());
+    Publish();
+
+    nextTick += kTickLength;
+    std::chrono::steady_clock::time_point now =
+      std::chrono::steady_clock::now();
+    if (now - nextTick > kTickLength * kMaxCatchUpTicks) {
+      nextTick = now;
+    }
+    std::this_thread::sleep_until(nextTick);
+  }
+}
+
+void SimLoop::Tick(const WindowManager::InputState& input) {
+  Profiler::Scope cpuScope("SimTick");
+  float step = std::chrono::duration<float>(kTickLength).count();
+  camera.updateTime(step);
+
+  // Turning by all the cursor movement since the last tick at once
+  if (input.lookX != 0.0f || input.lookY != 0.0f) {
+    camera.updateDir(input.lookX, input.lookY);
+  }
+
+  // Each scroll click changes fly speed a notch
+  for (int click = 0; click < input.scrollSteps; ++click) {
+    camera.adjustSpeed(0.0f, 1.0f);
+  }
+  for (int click = 0; click > input.scrollSteps; --click) {
+    camera.adjustSpeed(0.0f, -1.0f);
+  }
+
+  // Moving for one step with whichever keys are held
+  if (input.moveBits != 0) {
+    camera.updatePos(input.moveBits);
+  }
+  if (input.projHeld) {
+    camera.projSwitch();
+  }
+
+  // Building the view matrix once for everything the tick applied
+  camera.resolveView();
+  ++tick;
+}
+
+// Filling the slot only the simulation touches, then swapping it with the
+// waiting one. The release makes the snapshot visible to the render thread
+// before the swap is.
+void SimLoop::Publish() {
+  states[writeState].camera = camera;
+  states[writeState].tick = tick;
+  writeState = waitingState.exchange(writeState | kFreshState,
+                                     std::memory_order_acq_rel) & kStateMask;
+}
+
+// Swapping the read slot for the waiting one only when it holds something
+// new; otherwise the snapshot already being read is still the latest
+const SimLoop::SimState& SimLoop::Latest() {
+  if (waitingState.load(std::memory_order_relaxed) & kFreshState) {
+    readState = waitingState.exchange(readState,
+                                      std::memory_order_acq_rel) & kStateMask;
+  }
+  return states[readState];
+}
@@ -0,0 +1,79 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The SimLoop class runs the simulation on its own thread at a fixed rate:
+// each tick takes the input the window manager gathered and moves its own
+// camera by one fixed step. After each tick it publishes a snapshot of the
+// scene state through a triple buffer, so the render thread always finds a
+// complete, recent snapshot without waiting on a lock, and the simulation
+// never waits on a frame. How fast the camera moves and how soon it reacts
+// to input no longer depend on how long frames take to draw.
+#pragma once
+#ifndef SIM_LOOP
+#define SIM_LOOP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "Camera.h"
+#include "WindowManager.h"
+
+class SimLoop {
+ public:
+    // Scene state as of the end of one tick. Never changed once published.
+    struct SimState {
+      Camera camera;
+      uint64_t tick;  // ticks run before this state
+    };
+
+ private:
+    // Window manager the input comes from
+    WindowManager* winMgr;
+
+    // Camera the simulation moves, copied into each snapshot
+    Camera camera;
+    uint64_t tick = 0;
+
+    // Three snapshot slots. The simulation writes one, the render thread
+    // reads another, and the third is the latest finished snapshot waiting
+    // to be taken. Swapping a slot with the waiting one is a single
+    // exchange, whose fresh bit says whether it holds a snapshot the render
+    // thread hasn't seen.
+    std::vector<SimState> states;
+    uint32_t writeState = 0;
+    uint32_t readState = 1;
+    std::atomic<uint32_t> waitingState;
+
+    // Simulation thread, and whether it should keep running
+    std::thread thread;
+    std::atomic<bool> running;
+
+    // Runs ticks at the fixed rate until stopped
+    void Run();
+
+    // Applies input to the camera and advances it one step
+    void Tick(const WindowManager::InputState& input);
+
+    // Hands the finished snapshot over to the render thread
+    void Publish();
+
+ public:
+    // Starts from a copy of camera, drawn until the first tick is published
+    SimLoop(WindowManager* winMgr, const Camera& camera);
+
+    // Stops the simulation thread if it's still running
+    ~SimLoop();
+
+    // Starts and stops the simulation thread
+    void Start();
+    void Stop();
+
+    // Latest published snapshot. Called from the render thread only; the
+    // snapshot stays valid and unchanged until the next call.
+    const SimState& Latest();
+};
+#endif
@@ -0,0 +1,489 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// SIMD math runs matrix work over whole arrays of transforms at once:
+// products of 4x4 matrices, affine inverses, and normal matrices. Matrices
+// stay in glm's column-major layout in memory, since the rest of the engine
+// reads them that way. Products work a column at a time, and the 3x3 work
+// loads four or eight matrices and transposes them so each register holds
+// one element of every matrix. The instruction set is picked when the
+// program starts: AVX2 where the CPU has it, else SSE, else plain glm.
+#include "SimdMath.h"
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SIMD_MATH_SSE
+#include <xmmintrin.h>
+#endif
+
+// AVX2 is only built for x64, and only run if the CPU reports it. GCC and
+// Clang need each function using it marked; MSVC allows it anywhere.
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_MATH_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_MATH_AVX2_FN
+#else
+#define SIMD_MATH_AVX2_FN __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace {
+  SimdLevel simdLevel = DetectSimdLevel();
+
+  // The glm path, for builds without SIMD and for leftover matrices
+  void ScalarNormal(const glm::mat4& mat, glm::mat3* normMat) {
+    *normMat = glm::transpose(glm::inverse(glm::mat3(mat)));
+  }
+
+#ifdef SIMD_MATH_SSE
+  // Loads column col of four matrices and transposes it, so x, y, and z
+  // each hold that element of all four
+  void LoadColumnSse(const glm::mat4* mats, int col, __m128* x, __m128* y,
+                     __m128* z, __m128* w) {
+    *x = _mm_loadu_ps(&mats[0][col][0]);
+    *y = _mm_loadu_ps(&mats[1][col][0]);
+    *z = _mm_loadu_ps(&mats[2][col][0]);
+    *w = _mm_loadu_ps(&mats[3][col][0]);
+    _MM_TRANSPOSE4_PS(*x, *y, *z, *w);
+  }
+
+  // Cross product of four pairs of vectors, one component per register
+  inline void CrossSse(__m128 ux, __m128 uy, __m128 uz, __m128 vx,
+                       __m128 vy, __m128 vz, __m128* x, __m128* y,
+                       __m128* z) {
+    *x = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+    *y = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+    *z = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+  }
+
+  // Works out the normal matrices of four 3x3 matrices, one element per
+  // register, as m[col * 3 + row]. The transpose of the inverse is the
+  // cofactor matrix over the determinant, and each cofactor column is the
+  // cross product of the other two columns.
+  inline void NormalColumnsSse(const __m128* m, __m128* n) {
+    CrossSse(m[3], m[4], m[5], m[6], m[7], m[8], &n[0], &n[1], &n[2]);
+    CrossSse(m[6], m[7], m[8], m[0], m[1], m[2], &n[3], &n[4], &n[5]);
+    CrossSse(m[0], m[1], m[2], m[3], m[4], m[5], &n[6], &n[7], &n[8]);
+    __m128 det = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(m[0], n[0]), _mm_mul_ps(m[1], n[1])),
+      _mm_mul_ps(m[2], n[2]));
+    __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    for (int elem = 0; elem < 9; ++elem) {
+      n[elem] = _mm_mul_ps(n[elem], invDet);
+    }
+  }
+
+  void MultiplySse(const glm::mat4* a, const uint32_t* aIdx,
+                   const glm::mat4* b, glm::mat4* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      uint32_t ai = aIdx == nullptr ? i : aIdx[i];
+      if (ai == kNoMatrix) {
+        out[i] = b[i];
+        continue;
+      }
+      const float* am = &a[ai][0][0];
+      const float* bm = &b[i][0][0];
+      __m128 a0 = _mm_loadu_ps(am);
+      __m128 a1 = _mm_loadu_ps(am + 4);
+      __m128 a2 = _mm_loadu_ps(am + 8);
+      __m128 a3 = _mm_loadu_ps(am + 12);
+      __m128 cols[4];
+      for (int col = 0; col < 4; ++col) {
+        const float* bc = bm + col * 4;
+        __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+        cols[col] = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+      }
+      float* om = &out[i][0][0];
+      for (int col = 0; col < 4; ++col) {
+        _mm_storeu_ps(om + col * 4, cols[col]);
+      }
+    }
+  }
+
+  // A mat3's columns are three floats apart, so the first two are stored
+  // four wide, each overwriting the spill of the one before it, and the
+  // last as two floats and one
+  inline void StoreMat3Sse(__m128 col0, __m128 col1, __m128 col2,
+                           glm::mat3* normMat) {
+    float* dest = &(*normMat)[0][0];
+    _mm_storeu_ps(dest, col0);
+    _mm_storeu_ps(dest + 3, col1);
+    _mm_storel_pi(reinterpret_cast<__m64*>(dest + 6), col2);
+    _mm_store_ss(dest + 8, _mm_movehl_ps(col2, col2));
+  }
+
+  uint32_t NormalsSse(const glm::mat4* mats, glm::mat3* normMats,
+                      uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      __m128 m[9];
+      __m128 w;
+      LoadColumnSse(mats + i, 0, &m[0], &m[1], &m[2], &w);
+      LoadColumnSse(mats + i, 1, &m[3], &m[4], &m[5], &w);
+      LoadColumnSse(mats + i, 2, &m[6], &m[7], &m[8], &w);
+      __m128 n[9];
+      NormalColumnsSse(m, n);
+
+      // Back to one matrix per register, a column at a time
+      __m128 last[3] = { _mm_setzero_ps(), _mm_setzero_ps(),
+                         _mm_setzero_ps() };
+      _MM_TRANSPOSE4_PS(n[0], n[1], n[2], last[0]);
+      _MM_TRANSPOSE4_PS(n[3], n[4], n[5], last[1]);
+      _MM_TRANSPOSE4_PS(n[6], n[7], n[8], last[2]);
+      for (int lane = 0; lane < 3; ++lane) {
+        StoreMat3Sse(n[lane], n[3 + lane], n[6 + lane], &normMats[i + lane]);
+      }
+      StoreMat3Sse(last[0], last[1], last[2], &normMats[i + 3]);
+    }
+    return i;
+  }
+
+  // The inverse's upper 3x3 is the normal matrix transposed, so its
+  // columns come out of the transpose back to one matrix per register
+  // already in place. The translation is minus the inverse 3x3 times the
+  // old translation.
+  uint32_t InverseSse(const glm::mat4* mats, glm::mat4* out,
+                      uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      __m128 m[9];
+      __m128 tx;
+      __m128 ty;
+      __m128 tz;
+      __m128 w;
+      LoadColumnSse(mats + i, 0, &m[0], &m[1], &m[2], &w);
+      LoadColumnSse(mats + i, 1, &m[3], &m[4], &m[5], &w);
+      LoadColumnSse(mats + i, 2, &m[6], &m[7], &m[8], &w);
+      LoadColumnSse(mats + i, 3, &tx, &ty, &tz, &w);
+      __m128 n[9];
+      NormalColumnsSse(m, n);
+
+      __m128 zero = _mm_setzero_ps();
+      __m128 cols[4][4];
+      for (int col = 0; col < 3; ++col) {
+        cols[col][0] = n[col];
+        cols[col][1] = n[3 + col];
+        cols[col][2] = n[6 + col];
+        cols[col][3] = zero;
+        __m128 dot = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(n[col * 3], tx),
+                     _mm_mul_ps(n[col * 3 + 1], ty)),
+          _mm_mul_ps(n[col * 3 + 2], tz));
+        cols[3][col] = _mm_sub_ps(zero, dot);
+      }
+      cols[3][3] = _mm_set1_ps(1.0f);
+      for (int col = 0; col < 4; ++col) {
+        _MM_TRANSPOSE4_PS(cols[col][0], cols[col][1], cols[col][2],
+                          cols[col][3]);
+      }
+      for (int lane = 0; lane < 4; ++lane) {
+        float* dest = &out[i + lane][0][0];
+        _mm_storeu_ps(dest, cols[0][lane]);
+        _mm_storeu_ps(dest + 4, cols[1][lane]);
+        _mm_storeu_ps(dest + 8, cols[2][lane]);
+        _mm_storeu_ps(dest + 12, cols[3][lane]);
+      }
+    }
+    return i;
+  }
+#endif
+
+#ifdef SIMD_MATH_AVX2
+  // Transposes each 128-bit half of four registers as a 4x4 matrix
+  SIMD_MATH_AVX2_FN inline void TransposeAvx2(__m256* r0, __m256* r1,
+                                              __m256* r2, __m256* r3) {
+    __m256 t0 = _mm256_unpacklo_ps(*r0, *r1);
+    __m256 t1 = _mm256_unpackhi_ps(*r0, *r1);
+    __m256 t2 = _mm256_unpacklo_ps(*r2, *r3);
+    __m256 t3 = _mm256_unpackhi_ps(*r2, *r3);
+    *r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    *r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    *r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    *r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  }
+
+  // Loads column col of eight matrices, pairing matrix k with k + 4 in
+  // each register, and transposes it so x, y, and z each hold that element
+  // of all eight
+  SIMD_MATH_AVX2_FN inline void LoadColumnAvx2(const glm::mat4* mats,
+                                               int col, __m256* x,
+                                               __m256* y, __m256* z,
+                                               __m256* w) {
+    __m256* regs[4] = { x, y, z, w };
+    for (int k = 0; k < 4; ++k) {
+      __m128 low = _mm_loadu_ps(&mats[k][col][0]);
+      __m128 high = _mm_loadu_ps(&mats[k + 4][col][0]);
+      *regs[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+    }
+    TransposeAvx2(x, y, z, w);
+  }
+
+  SIMD_MATH_AVX2_FN inline void CrossAvx2(__m256 ux, __m256 uy, __m256 uz,
+                                          __m256 vx, __m256 vy, __m256 vz,
+                                          __m256* x, __m256* y,
+                                          __m256* z) {
+    *x = _mm256_fmsub_ps(uy, vz, _mm256_mul_ps(uz, vy));
+    *y = _mm256_fmsub_ps(uz, vx, _mm256_mul_ps(ux, vz));
+    *z = _mm256_fmsub_ps(ux, vy, _mm256_mul_ps(uy, vx));
+  }
+
+  // NormalColumnsSse for eight matrices
+  SIMD_MATH_AVX2_FN inline void NormalColumnsAvx2(const __m256* m,
+                                                  __m256* n) {
+    CrossAvx2(m[3], m[4], m[5], m[6], m[7], m[8], &n[0], &n[1], &n[2]);
+    CrossAvx2(m[6], m[7], m[8], m[0], m[1], m[2], &n[3], &n[4], &n[5]);
+    CrossAvx2(m[0], m[1], m[2], m[3], m[4], m[5], &n[6], &n[7], &n[8]);
+    __m256 det = _mm256_mul_ps(m[0], n[0]);
+    det = _mm256_fmadd_ps(m[1], n[1], det);
+    det = _mm256_fmadd_ps(m[2], n[2], det);
+    __m256 invDet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+    for (int elem = 0; elem < 9; ++elem) {
+      n[elem] = _mm256_mul_ps(n[elem], invDet);
+    }
+  }
+
+  // Two output columns per register: each half of a is the same column,
+  // and each half of b's broadcast comes from a different column of b
+  SIMD_MATH_AVX2_FN void MultiplyAvx2(const glm::mat4* a,
+                                      const uint32_t* aIdx,
+                                      const glm::mat4* b, glm::mat4* out,
+                                      uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      uint32_t ai = aIdx == nullptr ? i : aIdx[i];
+      if (ai == kNoMatrix) {
+        out[i] = b[i];
+        continue;
+      }
+      const float* am = &a[ai][0][0];
+      const float* bm = &b[i][0][0];
+      __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(am));
+      __m256 a1 =
+        _mm256_broadcast_ps(reinterpret_cast<const __m128*>(am + 4));
+      __m256 a2 =
+        _mm256_broadcast_ps(reinterpret_cast<const __m128*>(am + 8));
+      __m256 a3 =
+        _mm256_broadcast_ps(reinterpret_cast<const __m128*>(am + 12));
+      __m256 b01 = _mm256_loadu_ps(bm);
+      __m256 b23 = _mm256_loadu_ps(bm + 8);
+
+      __m256 sum01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+      sum01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), sum01);
+      sum01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), sum01);
+      sum01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), sum01);
+      __m256 sum23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+      sum23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), sum23);
+      sum23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), sum23);
+      sum23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), sum23);
+
+      float* om = &out[i][0][0];
+      _mm256_storeu_ps(om, sum01);
+      _mm256_storeu_ps(om + 8, sum23);
+    }
+  }
+
+  // Transposing back leaves matrix k's columns in the low halves and
+  // matrix k + 4's in the high halves
+  SIMD_MATH_AVX2_FN uint32_t NormalsAvx2(const glm::mat4* mats,
+                                         glm::mat3* normMats,
+                                         uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      __m256 m[9];
+      __m256 w;
+      LoadColumnAvx2(mats + i, 0, &m[0], &m[1], &m[2], &w);
+      LoadColumnAvx2(mats + i, 1, &m[3], &m[4], &m[5], &w);
+      LoadColumnAvx2(mats + i, 2, &m[6], &m[7], &m[8], &w);
+      __m256 n[12];
+      NormalColumnsAvx2(m, n);
+      n[9] = _mm256_setzero_ps();
+      n[10] = _mm256_setzero_ps();
+      n[11] = _mm256_setzero_ps();
+
+      // Columns of lane k end up in n[k], n[3 + k], n[6 + k], lane 3's in
+      // the padding
+      __m256 cols[3][4];
+      for (int col = 0; col < 3; ++col) {
+        cols[col][0] = n[col * 3];
+        cols[col][1] = n[col * 3 + 1];
+        cols[col][2] = n[col * 3 + 2];
+        cols[col][3] = n[9 + col];
+        TransposeAvx2(&cols[col][0], &cols[col][1], &cols[col][2],
+                      &cols[col][3]);
+      }
+      for (int k = 0; k < 4; ++k) {
+        StoreMat3Sse(_mm256_castps256_ps128(cols[0][k]),
+                     _mm256_castps256_ps128(cols[1][k]),
+                     _mm256_castps256_ps128(cols[2][k]), &normMats[i + k]);
+        StoreMat3Sse(_mm256_extractf128_ps(cols[0][k], 1),
+                     _mm256_extractf128_ps(cols[1][k], 1),
+                     _mm256_extractf128_ps(cols[2][k], 1),
+                     &normMats[i + k + 4]);
+      }
+    }
+    return i;
+  }
+
+  // InverseSse for eight matrices
+  SIMD_MATH_AVX2_FN uint32_t InverseAvx2(const glm::mat4* mats,
+                                         glm::mat4* out, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      __m256 m[9];
+      __m256 tx;
+      __m256 ty;
+      __m256 tz;
+      __m256 w;
+      LoadColumnAvx2(mats + i, 0, &m[0], &m[1], &m[2], &w);
+      LoadColumnAvx2(mats + i, 1, &m[3], &m[4], &m[5], &w);
+      LoadColumnAvx2(mats + i, 2, &m[6], &m[7], &m[8], &w);
+      LoadColumnAvx2(mats + i, 3, &tx, &ty, &tz, &w);
+      __m256 n[9];
+      NormalColumnsAvx2(m, n);
+
+      __m256 zero = _mm256_setzero_ps();
+      __m256 cols[4][4];
+      for (int col = 0; col < 3; ++col) {
+        cols[col][0] = n[col];
+        cols[col][1] = n[3 + col];
+        cols[col][2] = n[6 + col];
+        cols[col][3] = zero;
+        __m256 dot = _mm256_mul_ps(n[col * 3], tx);
+        dot = _mm256_fmadd_ps(n[col * 3 + 1], ty, dot);
+        dot = _mm256_fmadd_ps(n[col * 3 + 2], tz, dot);
+        cols[3][col] = _mm256_sub_ps(zero, dot);
+      }
+      cols[3][3] = _mm256_set1_ps(1.0f);
+      for (int col = 0; col < 4; ++col) {
+        TransposeAvx2(&cols[col][0], &cols[col][1], &cols[col][2],
+                      &cols[col][3]);
+      }
+      for (int k = 0; k < 4; ++k) {
+        float* low = &out[i + k][0][0];
+        float* high = &out[i + k + 4][0][0];
+        for (int col = 0; col < 4; ++col) {
+          _mm_storeu_ps(low + col * 4, _mm256_castps256_ps128(cols[col][k]));
+          _mm_storeu_ps(high + col * 4,
+                        _mm256_extractf128_ps(cols[col][k], 1));
+        }
+      }
+    }
+    return i;
+  }
+#endif
+}  // namespace
+
+// Asking the CPU for AVX2 and FMA, and on MSVC also checking the OS saves
+// the wide registers on a context switch
+SimdLevel DetectSimdLevel() {
+#ifdef SIMD_MATH_AVX2
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] >= 7) {
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osSaves = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    if (fma && osSaves && avx && avx2 && (_xgetbv(0) & 6) == 6) {
+      return SIMD_AVX2;
+    }
+  }
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SIMD_AVX2;
+  }
+#endif
+#endif
+#ifdef SIMD_MATH_SSE
+  return SIMD_SSE;
+#else
+  return SIMD_SCALAR;
+#endif
+}
+
+SimdLevel GetSimdLevel() {
+  return simdLevel;
+}
+
+void SetSimdLevel(SimdLevel level) {
+  SimdLevel best = DetectSimdLevel();
+  simdLevel = level > best ? best : level;
+}
+
+const char* SimdLevelName(SimdLevel level) {
+  switch (level) {
+    case SIMD_AVX2:
+      return "AVX2";
+    case SIMD_SSE:
+      return "SSE";
+    default:
+      return "scalar";
+  }
+}
+
+void MultiplyMat4(const glm::mat4* a, const uint32_t* aIdx,
+                  const glm::mat4* b, glm::mat4* out, uint32_t count) {
+#ifdef SIMD_MATH_AVX2
+  if (simdLevel == SIMD_AVX2) {
+    MultiplyAvx2(a, aIdx, b, out, count);
+    return;
+  }
+#endif
+#ifdef SIMD_MATH_SSE
+  if (simdLevel >= SIMD_SSE) {
+    MultiplySse(a, aIdx, b, out, count);
+    return;
+  }
+#endif
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t ai = aIdx == nullptr ? i : aIdx[i];
+    out[i] = ai == kNoMatrix ? b[i] : a[ai] * b[i];
+  }
+}
+
+// Running whole groups of four or eight with SIMD, and what's left over
+// with glm
+void NormalMats(const glm::mat4* mats, glm::mat3* normMats, uint32_t count) {
+  uint32_t done = 0;
+#ifdef SIMD_MATH_AVX2
+  if (simdLevel == SIMD_AVX2) {
+    done = NormalsAvx2(mats, normMats, count);
+  }
+#endif
+#ifdef SIMD_MATH_SSE
+  if (simdLevel >= SIMD_SSE) {
+    done += NormalsSse(mats + done, normMats + done, count - done);
+  }
+#endif
+  for (; done < count; ++done) {
+    ScalarNormal(mats[done], &normMats[done]);
+  }
+}
+
+void AffineInverse(const glm::mat4* mats, glm::mat4* out, uint32_t count) {
+  uint32_t done = 0;
+#ifdef SIMD_MATH_AVX2
+  if (simdLevel == SIMD_AVX2) {
+    done = InverseAvx2(mats, out, count);
+  }
+#endif
+#ifdef SIMD_MATH_SSE
+  if (simdLevel >= SIMD_SSE) {
+    done += InverseSse(mats + done, out + done, count - done);
+  }
+#endif
+  for (; done < count; ++done) {
+    out[done] = glm::affineInverse(mats[done]);
+  }
+}
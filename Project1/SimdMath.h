@@ -0,0 +1,54 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// SIMD math runs matrix work over whole arrays of transforms at once:
+// products of 4x4 matrices, affine inverses, and normal matrices. Matrices
+// stay in glm's column-major layout in memory, since the rest of the engine
+// reads them that way. Products work a column at a time, and the 3x3 work
+// loads four or eight matrices and transposes them so each register holds
+// one element of every matrix. The instruction set is picked when the
+// program starts: AVX2 where the CPU has it, else SSE, else plain glm.
+#pragma once
+#ifndef SIMD_MATH
+#define SIMD_MATH
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Instruction sets the kernels can run with, slowest first
+enum SimdLevel {
+  SIMD_SCALAR,
+  SIMD_SSE,
+  SIMD_AVX2
+};
+
+// Marks a missing left matrix in MultiplyMat4's index array
+const uint32_t kNoMatrix = ~0u;
+
+// Best level the CPU and build support
+SimdLevel DetectSimdLevel();
+
+// Level the kernels run with, the detected one unless changed. Setting a
+// level the CPU lacks falls back to the best it has.
+SimdLevel GetSimdLevel();
+void SetSimdLevel(SimdLevel level);
+
+// Name of a level, for reporting
+const char* SimdLevelName(SimdLevel level);
+
+// Sets out[i] = a[aIdx[i]] * b[i] for each i below count, or b[i] where
+// aIdx[i] is kNoMatrix. A null aIdx pairs a[i] with b[i]. out may be b, and
+// may be inside a, as long as no output is also some other entry's input.
+void MultiplyMat4(const glm::mat4* a, const uint32_t* aIdx,
+                  const glm::mat4* b, glm::mat4* out, uint32_t count);
+
+// Sets normMats[i] to the transpose of the inverse of mats[i]'s upper 3x3
+void NormalMats(const glm::mat4* mats, glm::mat3* normMats, uint32_t count);
+
+// Sets out[i] to the inverse of mats[i], which must be affine: a last row
+// of 0, 0, 0, 1
+void AffineInverse(const glm::mat4* mats, glm::mat4* out, uint32_t count);
+#endif
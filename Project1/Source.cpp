@@ -4,15 +4,24 @@
 // demonstrate understanding and not to explain the obvious.
 
 #include "Camera.h"
+#include "GpuProfiler.h"
 #include "Lights.h"
 #include "ModelManager.h"
+#include "Profiler.h"
 #include "Shader.h"
+#include "SimLoop.h"
 #include "WindowManager.h"
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -24,9 +33,20 @@ void PrintProgramInfoLog(Shader* shader);
 // Called every frame, renders models
 void Render(GLFWwindow* window);
 
+// Prints the command line options to std::cerr
+void PrintUsage(const char* program);
+
+// Parses a whole command line argument as a float. False if it's empty or
+// anything but a number.
+bool ParseFloat(const char* arg, float* value);
+
+// Parses a whole command line argument as an unsigned 32-bit count. False
+// if it's empty, signed, out of range, or anything but digits.
+bool ParseCount(const char* arg, uint32_t* value);
+
 namespace {
   // microphone position
-  // (applied to all models involved to move the entire object)
+  // (applied to the mic node, which moves the entire object)
   glm::vec3 micPos = glm::vec3(24.4843, 0.0, -19.2146);
 
   // microphone base rotation, used to position the legs
@@ -51,6 +71,13 @@ namespace {
   // Creates, draws, and stores models
   ModelManager modMgr = ModelManager();
 
+  // Whether to print GL call counters, and when they were last printed
+  bool printStateStats = false;
+  double lastStatsTime = 0.0;
+
+  // Whether large models hide the models behind them on the CPU
+  bool occlusionCulling = true;
+
   // Shader programs. One is used to handle image materials (such as dice),
   // and the other is used to handle property based materials 
   // (such as plain metal).
@@ -62,6 +89,10 @@ namespace {
                            glm::vec3(0.0f, 0.0f, -2.0f),
                            kWinHeight, kWinWidth);
 
+  // Moves the camera on its own thread at a fixed rate. Each frame draws with
+  // a copy of its latest camera.
+  SimLoop simLoop = SimLoop(&winMgr, sceneCam);
+
   // Array of pointers to objects, set as window pointer
   // so objects can talk to each other
   const void* objPtrs[5] = {
@@ -119,23 +150,36 @@ namespace {
     {"desk_tex", "desk_diff.png", "desk_spec.png", 0.64f}
   };
 
+  // Transform nodes grouping models into assemblies. The microphone is
+  // one node; its legs and its upper half each turn about its center.
+  // Format: node name, parent node name, local matrix
+  std::vector<ModelManager::NodeDef> nodes = {
+    {"mic", "", glm::translate(micPos)},
+    {"micLegs", "mic",
+     glm::rotate(glm::radians(micBaseRot), glm::vec3(0.0f, 1.0f, 0.0f))},
+    {"micTop", "mic",
+     glm::rotate(glm::radians(micTopRot), glm::vec3(0.0f, 1.0f, 0.0f))}
+  };
+
   // Definitions for each model used in scene.
-  // Format: model name, mesh name, material/texture name, model matrix
+  // Format: model name, mesh name, material/texture name, model matrix,
+  // parent node name (the model matrix is relative to the parent)
   std::vector<ModelManager::ModelDef> models = {
     {"desk", "desk", "desk_tex", glm::mat4(1.0f)},
     {"wall", "wall", "wall_tex", glm::mat4(1.0f)},
-    {"micFoot1", "mic_feet", "blk_rubber", glm::mat4(1.0f)},
-    {"micFoot2", "mic_feet", "blk_rubber", glm::mat4(1.0f)},
-    {"micFoot3", "mic_feet", "blk_rubber", glm::mat4(1.0f)},
-    {"micLeg1", "mic_leg", "slv_chrome", glm::mat4(1.0f)},
-    {"micLeg2", "mic_leg", "slv_chrome", glm::mat4(1.0f)},
-    {"micLeg3", "mic_leg", "slv_chrome", glm::mat4(1.0f)},
-    {"mic_base", "mic_base", "blk_plastic", glm::mat4(1.0f)},
-    {"mic_swivel", "mic_swivel", "blk_plastic", glm::mat4(1.0f)},
-    {"mic_hold", "mic_hold", "blk_plastic", glm::mat4(1.0f)},
-    {"mic_body", "mic_body", "mic_body_tex", glm::mat4(1.0f)},
-    {"mic_filt_cmp", "mic_filt_cmp", "mic_filt_tex", glm::mat4(1.0f)},
-    {"mic_gain_knob", "mic_gain_knob", "mic_gain_tex", glm::mat4(1.0f)},
+    {"micFoot1", "mic_feet", "blk_rubber", glm::mat4(1.0f), "micLegs"},
+    {"micFoot2", "mic_feet", "blk_rubber", glm::mat4(1.0f), "micLegs"},
+    {"micFoot3", "mic_feet", "blk_rubber", glm::mat4(1.0f), "micLegs"},
+    {"micLeg1", "mic_leg", "slv_chrome", glm::mat4(1.0f), "micLegs"},
+    {"micLeg2", "mic_leg", "slv_chrome", glm::mat4(1.0f), "micLegs"},
+    {"micLeg3", "mic_leg", "slv_chrome", glm::mat4(1.0f), "micLegs"},
+    {"mic_base", "mic_base", "blk_plastic", glm::mat4(1.0f), "mic"},
+    {"mic_swivel", "mic_swivel", "blk_plastic", glm::mat4(1.0f), "micTop"},
+    {"mic_hold", "mic_hold", "blk_plastic", glm::mat4(1.0f), "micTop"},
+    {"mic_body", "mic_body", "mic_body_tex", glm::mat4(1.0f), "micTop"},
+    {"mic_filt_cmp", "mic_filt_cmp", "mic_filt_tex", glm::mat4(1.0f), "micTop"},
+    {"mic_gain_knob", "mic_gain_knob", "mic_gain_tex", glm::mat4(1.0f),
+     "micTop"},
     {"d6", "d6", "d6_tex", glm::mat4(1.0f)},
     {"d8_tophalf", "d8", "d8_tophalf_tex", glm::mat4(1.0f)},
     {"d8_bothalf", "d8", "d8_bothalf_tex", glm::mat4(1.0f)},
@@ -144,98 +188,126 @@ namespace {
 
 };  // namespace
 
-int main() {
+int main(int argc, char** argv) {
   // Putting pointer array in window so other objects can access o
   // Other objects' data.
   glfwSetWindowUserPointer(winMgr.GetWinPtr(), &objPtrs);
+  Profiler::SetThreadName("Main");
+
+  // Command line options
+  // --compact-verts : upload meshes in the 16 byte compact vertex format
+  // --lod-threshold <pixels> : screen error allowed before using finer LODs
+  // --state-stats : print culling, draw, and state change counts once a
+  //                 second
+  // --no-occlusion : send models hidden behind the desk and wall to the GPU
+  //                  anyway
+  // --profile <frames> : write a trace of the first frames drawn (F9 traces
+  //                      the next 120 at any time)
+  // --profile-file <path> : where traces are written, profile.json if unset
+  // F10 writes the last 120 frames' GL counters to gl_stats.csv
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--compact-verts") {
+      modMgr.SetCompactVerts(true);
+    } else if (arg == "--lod-threshold") {
+      float pixels = 0.0f;
+      if (i + 1 >= argc || !ParseFloat(argv[++i], &pixels) || pixels < 0.0f) {
+        std::cerr << "--lod-threshold needs a number of pixels" << std::endl;
+        PrintUsage(argv[0]);
+        return 1;
+      }
+      modMgr.SetLodThreshold(pixels);
+    } else if (arg == "--state-stats") {
+      printStateStats = true;
+    } else if (arg == "--no-occlusion") {
+      occlusionCulling = false;
+    } else if (arg == "--profile") {
+      uint32_t numFrames = 0;
+      if (i + 1 >= argc || !ParseCount(argv[++i], &numFrames)) {
+        std::cerr << "--profile needs a number of frames" << std::endl;
+        PrintUsage(argv[0]);
+        return 1;
+      }
+      Profiler::Capture(numFrames);
+    } else if (arg == "--profile-file") {
+      if (i + 1 >= argc) {
+        std::cerr << "--profile-file needs a path" << std::endl;
+        PrintUsage(argv[0]);
+        return 1;
+      }
+      Profiler::SetTracePath(argv[++i]);
+    }
+  }
+
+  // Starting worker threads now that main is running and every global,
+  // the profiler's included, has been constructed
+  modMgr.Jobs()->Start();
 
   // Calculating matrices for each model, applying appropriate
-  // transformations
+  // transformations. Mic parts are placed relative to their nodes.
 
   // mic foot 1 matrix
   models.at(2).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micBaseRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(7.5326, 0.1429f, -0.0000f))
+    glm::translate(glm::vec3(7.5326, 0.1429f, -0.0000f))
     * glm::rotate(glm::radians(50.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
   // mic foot 2 matrix
   models.at(3).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micBaseRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(-3.7663f, 0.1429f, -6.5234f))
+    glm::translate(glm::vec3(-3.7663f, 0.1429f, -6.5234f))
     * glm::rotate(glm::radians(120.0f), glm::vec3(0.0f, 1.0f, 0.0f))
     * glm::rotate(glm::radians(50.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
   //// mic foot 3 matrix
   models.at(4).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micBaseRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(-3.7663f, 0.1429f, 6.5234f))
+    glm::translate(glm::vec3(-3.7663f, 0.1429f, 6.5234f))
     * glm::rotate(glm::radians(240.0f), glm::vec3(0.0f, 1.0f, 0.0f))
     * glm::rotate(glm::radians(50.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
   //// mic leg 1 matrix
   models.at(5).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micBaseRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(6.5480f, 0.9690f, -0.0043f))
+    glm::translate(glm::vec3(6.5480f, 0.9690f, -0.0043f))
     * glm::rotate(glm::radians(50.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
   // mic leg 2 matrix
   models.at(6).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micBaseRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(-3.2924f, 0.9690f, -5.6941f))
+    glm::translate(glm::vec3(-3.2924f, 0.9690f, -5.6941f))
     * glm::rotate(glm::radians(120.0f), glm::vec3(0.0f, 1.0f, 0.0f))
     * glm::rotate(glm::radians(50.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
   // mic leg 3 matrix
   models.at(7).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micBaseRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(-3.2905f, 0.9690f, 5.6964f))
+    glm::translate(glm::vec3(-3.2905f, 0.9690f, 5.6964f))
     * glm::rotate(glm::radians(240.0f), glm::vec3(0.0f, 1.0f, 0.0f))
     * glm::rotate(glm::radians(50.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
   // mic base matrix
   models.at(8).modelMat =
-    glm::translate(micPos + glm::vec3(0.0f, 4.95f, 0.0f));
+    glm::translate(glm::vec3(0.0f, 4.95f, 0.0f));
 
   // mic swivel matrix
   models.at(9).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micTopRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(0.0000f, 6.1500f, 0.0000f));
+    glm::translate(glm::vec3(0.0000f, 6.1500f, 0.0000f));
 
   // mic holder matrix
   models.at(10).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micTopRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(0.0000f, 9.1533f, 0.000f))
+    glm::translate(glm::vec3(0.0000f, 9.1533f, 0.000f))
     * glm::rotate(glm::radians(56.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
   // mic body matrix
   models.at(11).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micTopRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(2.7499f, 12.9520f, 0.0104f))
+    glm::translate(glm::vec3(2.7499f, 12.9520f, 0.0104f))
     * glm::rotate(glm::radians(56.0f), glm::vec3(0.0f, 0.0f, 1.0f))
     * glm::rotate(glm::radians(90.00f), glm::vec3(0.0f, 1.0f, 0.0f));
 
   // mic filter body
   models.at(12).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micTopRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(-1.394f, 15.752f, 0.0106f))
+    glm::translate(glm::vec3(-1.394f, 15.752f, 0.0106f))
     * glm::rotate(glm::radians(56.0f), glm::vec3(0.0f, 0.0f, 1.0f))
     * glm::scale(glm::vec3(1.33f, 1.0f, 1.125f));
 
   // mic gain knob
   models.at(13).modelMat =
-    glm::translate(micPos)
-    * glm::rotate(glm::radians(micTopRot), glm::vec3(0.0f, 1.0f, 0.0f))
-    * glm::translate(glm::vec3(2.1357f, 15.6f, 0.0106f))
+    glm::translate(glm::vec3(2.1357f, 15.6f, 0.0106f))
     * glm::rotate(glm::radians(-34.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
   // d6 matrix
@@ -264,15 +336,22 @@ int main() {
     * glm::rotate(glm::radians(-30.5f), glm::vec3(0.0f, 0.0f, 1.0f))
     * glm::rotate(glm::radians(66.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 
-  // Creating materials, textures, meshes, and finally models
+  // The desk and wall are big and solid enough to hide things behind them
+  if (occlusionCulling) {
+    modMgr.SetOccluders({"desk", "wall"});
+  }
+
+  // Creating materials, textures, meshes, nodes, and finally models
   // These are all stored, held, and used by the Model Manager class
   modMgr.CreateMaterials(materials);
   modMgr.CreateTextures(textures);
   modMgr.CreateMeshes(meshFiles);
+  modMgr.CreateNodes(nodes);
   modMgr.CreateModels(models);
 
-  // Binding and loading initial camera data.
+  // Binding camera, material, and per-object uniform blocks
   sceneCam.BindCamData(window);
+  modMgr.BindUniformBlocks(window);
 
   // Loading light data into uniform buffers
   LoadDirLights(window);
@@ -282,26 +361,63 @@ int main() {
   glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
 
   // Repeat render loop until we receive a close signal from GLFW
+  // Starting the simulation, which runs until the window closes
+  simLoop.Start();
   while (!winMgr.closeCheck()) {
     Render(window);
   }
+  simLoop.Stop();
+  GpuProfiler::Release();
 }
 
 void Render(GLFWwindow* window) {
-  // Update camera's frame time
-  sceneCam.updateTime();
+  {
+    Profiler::Scope cpuScope("Render");
+    GpuProfiler::Scope gpuScope("Render");
+
+    // Drawing from the simulation's latest camera
+    sceneCam = simLoop.Latest().camera;
 
-  // Clear depth and color buffer back to presets
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Clear depth and color buffer back to presets
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-  // Loops through all the models created earlier, drawing each
-  modMgr.DrawModels(window);
+    // Loops through all the models created earlier, drawing each
+    modMgr.DrawModels(window);
+  }
+
+  // Keeping GL counters for the rolling window F10 dumps
+  winMgr.SampleGLStats();
+
+  // Printing last frame's counters, at most once a second
+  if (printStateStats && glfwGetTime() - lastStatsTime >= 1.0) {
+    const GLStateCache::Counters& counters = modMgr.StateCounters();
+    const CullStats& cullStats = modMgr.CullCounters();
+    const OcclusionStats& occStats = modMgr.OcclusionCounters();
+    double occludedPct = occStats.testedTris == 0 ? 0.0 :
+      100.0 * occStats.occludedTris / occStats.testedTris;
+    std::cout << "Models: " << cullStats.visible << "/" << cullStats.tested
+              << " in view, occluded: " << occStats.occluded << " ("
+              << occludedPct << "% of triangles), draws: " << counters.draws
+              << ", binds issued: " << counters.issued << ", elided: "
+              << counters.elided << std::endl;
+    lastStatsTime = glfwGetTime();
+  }
 
   // Process events in event queue (such as callbacks)
   glfwPollEvents();
 
+  // Handing this frame's held keys to the simulation
+  winMgr.ProcessInput();
+
   // Swap front and back buffers of the window
-  glfwSwapBuffers(window);
+  {
+    Profiler::Scope cpuScope("SwapBuffers");
+    glfwSwapBuffers(window);
+  }
+
+  // Closing the frame's timings
+  GpuProfiler::EndFrame();
+  Profiler::EndFrame();
 }
 
 // Prints program info log when debugging
@@ -318,3 +434,41 @@ void PrintProgramInfoLog(Shader* shader) {
     std::cout << infoLog << std::endl;
   }
 }
+
+// Prints the command line options
+void PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program << " [options]\n"
+            << "  --compact-verts\n"
+            << "  --lod-threshold <pixels>\n"
+            << "  --state-stats\n"
+            << "  --no-occlusion\n"
+            << "  --profile <frames>\n"
+            << "  --profile-file <path>" << std::endl;
+}
+
+// Parses a float, making sure strtof used up the whole argument
+bool ParseFloat(const char* arg, float* value) {
+  char* end = nullptr;
+  float parsed = std::strtof(arg, &end);
+  if (end == arg || *end != '\0' || !std::isfinite(parsed)) {
+    return false;
+  }
+  *value = parsed;
+  return true;
+}
+
+// Parses a count, making sure strtoul used up the whole argument and that
+// it wasn't negative, which strtoul would quietly wrap
+bool ParseCount(const char* arg, uint32_t* value) {
+  if (!std::isdigit(static_cast<unsigned char>(arg[0]))) {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  unsigned long parsed = std::strtoul(arg, &end, 10);
+  if (*end != '\0' || errno == ERANGE || parsed > UINT32_MAX) {
+    return false;
+  }
+  *value = static_cast<uint32_t>(parsed);
+  return true;
+}
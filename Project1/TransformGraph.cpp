@@ -0,0 +1,224 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The TransformGraph class holds a tree of transforms: each node has a
+// local matrix relative to its parent, and a world matrix and normal matrix
+// worked out from its parent's world matrix. Nodes are stored breadth first,
+// so a node's children sit next to each other, and every level of a subtree
+// is one contiguous run of nodes. Changing a local matrix only marks the
+// node dirty; Update then sweeps each dirty subtree one level at a time, so
+// moving an assembly costs its own nodes and nothing else in the scene.
+#include "TransformGraph.h"
+#include "SimdMath.h"
+
+#include <algorithm>
+
+namespace {
+  // Fewest nodes in a level worth splitting across jobs
+  const uint32_t kMinJobNodes = 1024;
+
+  // Once one node in this many is dirty, one sweep down the whole tree
+  // costs little more than sweeping the dirty subtrees, and its levels are
+  // big enough to spread across jobs
+  const uint32_t kFullSweepDivisor = 8;
+
+  // Roots' parent positions go straight to MultiplyMat4
+  static_assert(TransformGraph::kNoNode == kNoMatrix,
+                "Root marker must match SIMD math's missing matrix");
+}  // namespace
+
+// Placing the node at the end until the next Update lays the tree out
+// again; until then only its id means anything
+TransformGraph::NodeId TransformGraph::AddNode(NodeId parent,
+                                               const glm::mat4& local) {
+  NodeId node = NumNodes();
+  parents.push_back(parent);
+  firstChildren.push_back(kNoNode);
+  lastChildren.push_back(kNoNode);
+  nextSiblings.push_back(kNoNode);
+  if (parent != kNoNode) {
+    if (lastChildren[parent] == kNoNode) {
+      firstChildren[parent] = node;
+    } else {
+      nextSiblings[lastChildren[parent]] = node;
+    }
+    lastChildren[parent] = node;
+  }
+  positions.push_back(node);
+  dirty.push_back(1);
+  dirtyNodes.push_back(node);
+
+  ids.push_back(node);
+  parentPos.push_back(kNoNode);
+  childBegin.push_back(0);
+  numChildren.push_back(0);
+  locals.push_back(local);
+  worlds.push_back(local);
+  normMats.push_back(glm::mat3(1.0f));
+  sweptIn.push_back(0);
+  relayout = true;
+  return node;
+}
+
+void TransformGraph::SetLocal(NodeId node, const glm::mat4& local) {
+  locals[positions[node]] = local;
+  if (!dirty[node]) {
+    dirty[node] = 1;
+    dirtyNodes.push_back(node);
+  }
+}
+
+// Visiting nodes in the order they're placed, appending each one's children
+// as it's reached. A node's first child lands right after the last child of
+// the node before it, which is what keeps each level of a subtree together.
+void TransformGraph::Layout() {
+  uint32_t numNodes = NumNodes();
+  std::vector<NodeId> order;
+  order.reserve(numNodes);
+  for (NodeId node = 0; node < numNodes; ++node) {
+    if (parents[node] == kNoNode) {
+      order.push_back(node);
+    }
+  }
+  numRoots = static_cast<uint32_t>(order.size());
+  std::vector<uint32_t> newChildBegin(numNodes);
+  std::vector<uint32_t> newNumChildren(numNodes);
+  for (uint32_t pos = 0; pos < order.size(); ++pos) {
+    newChildBegin[pos] = static_cast<uint32_t>(order.size());
+    NodeId child = firstChildren[order[pos]];
+    for (; child != kNoNode; child = nextSiblings[child]) {
+      order.push_back(child);
+    }
+    newNumChildren[pos] =
+      static_cast<uint32_t>(order.size()) - newChildBegin[pos];
+  }
+
+  // Moving each node's matrices to its new position
+  std::vector<glm::mat4> newLocals(numNodes);
+  std::vector<glm::mat4> newWorlds(numNodes);
+  std::vector<glm::mat3> newNormMats(numNodes);
+  std::vector<uint32_t> newSweptIn(numNodes);
+  for (uint32_t pos = 0; pos < numNodes; ++pos) {
+    uint32_t oldPos = positions[order[pos]];
+    newLocals[pos] = locals[oldPos];
+    newWorlds[pos] = worlds[oldPos];
+    newNormMats[pos] = normMats[oldPos];
+    newSweptIn[pos] = sweptIn[oldPos];
+  }
+  for (uint32_t pos = 0; pos < numNodes; ++pos) {
+    positions[order[pos]] = pos;
+  }
+  std::vector<uint32_t> newParentPos(numNodes);
+  for (uint32_t pos = 0; pos < numNodes; ++pos) {
+    NodeId parent = parents[order[pos]];
+    newParentPos[pos] = parent == kNoNode ? kNoNode : positions[parent];
+  }
+
+  ids.swap(order);
+  parentPos.swap(newParentPos);
+  childBegin.swap(newChildBegin);
+  numChildren.swap(newNumChildren);
+  locals.swap(newLocals);
+  worlds.swap(newWorlds);
+  normMats.swap(newNormMats);
+  sweptIn.swap(newSweptIn);
+}
+
+// Parents sit in earlier levels than the run, so none of the products
+// reads a matrix the run writes
+void TransformGraph::UpdateRange(uint32_t begin, uint32_t end) {
+  uint32_t count = end - begin;
+  MultiplyMat4(worlds.data(), parentPos.data() + begin,
+               locals.data() + begin, worlds.data() + begin, count);
+  NormalMats(worlds.data() + begin, normMats.data() + begin, count);
+  std::fill(sweptIn.begin() + begin, sweptIn.begin() + end, updateCount);
+}
+
+// Each level of the sweep is the children of the one before: the children
+// of a contiguous run of nodes are themselves a contiguous run
+void TransformGraph::Sweep(uint32_t begin, uint32_t end, JobSystem* jobs) {
+  while (begin < end) {
+    if (jobs != nullptr && end - begin >= kMinJobNodes) {
+      jobs->ParallelFor(end - begin,
+                        [this, begin](uint32_t first, uint32_t last) {
+        UpdateRange(begin + first, begin + last);
+      }, kMinJobNodes);
+    } else {
+      UpdateRange(begin, end);
+    }
+    updated.insert(updated.end(), ids.begin() + begin, ids.begin() + end);
+
+    uint32_t nextBegin = childBegin[begin];
+    end = childBegin[end - 1] + numChildren[end - 1];
+    begin = nextBegin;
+  }
+}
+
+// Sweeping dirty nodes in position order. A parent always sits before its
+// children, so a dirty node inside a subtree swept earlier in this Update
+// is already up to date and gets skipped.
+void TransformGraph::Update(JobSystem* jobs) {
+  updated.clear();
+  if (dirtyNodes.empty()) {
+    return;
+  }
+  if (relayout) {
+    Layout();
+    relayout = false;
+  }
+  ++updateCount;
+
+  // The roots are the first level of the whole tree
+  if (dirtyNodes.size() >= NumNodes() / kFullSweepDivisor) {
+    std::vector<NodeId>::iterator nodeIter = dirtyNodes.begin();
+    for (; nodeIter != dirtyNodes.end(); ++nodeIter) {
+      dirty[*nodeIter] = 0;
+    }
+    dirtyNodes.clear();
+    Sweep(0, numRoots, jobs);
+    return;
+  }
+
+  std::vector<uint32_t> dirtyPos;
+  dirtyPos.reserve(dirtyNodes.size());
+  std::vector<NodeId>::iterator nodeIter = dirtyNodes.begin();
+  for (; nodeIter != dirtyNodes.end(); ++nodeIter) {
+    dirtyPos.push_back(positions[*nodeIter]);
+    dirty[*nodeIter] = 0;
+  }
+  dirtyNodes.clear();
+  std::sort(dirtyPos.begin(), dirtyPos.end());
+
+  std::vector<uint32_t>::iterator posIter = dirtyPos.begin();
+  for (; posIter != dirtyPos.end(); ++posIter) {
+    if (sweptIn[*posIter] != updateCount) {
+      Sweep(*posIter, *posIter + 1, jobs);
+    }
+  }
+}
+
+const std::vector<TransformGraph::NodeId>& TransformGraph::Updated() const {
+  return updated;
+}
+
+const glm::mat4& TransformGraph::Local(NodeId node) const {
+  return locals[positions[node]];
+}
+
+const glm::mat4& TransformGraph::World(NodeId node) const {
+  return worlds[positions[node]];
+}
+
+const glm::mat3& TransformGraph::NormalMat(NodeId node) const {
+  return normMats[positions[node]];
+}
+
+TransformGraph::NodeId TransformGraph::Parent(NodeId node) const {
+  return parents[node];
+}
+
+uint32_t TransformGraph::NumNodes() const {
+  return static_cast<uint32_t>(parents.size());
+}
@@ -0,0 +1,101 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The TransformGraph class holds a tree of transforms: each node has a
+// local matrix relative to its parent, and a world matrix and normal matrix
+// worked out from its parent's world matrix. Nodes are stored breadth first,
+// so a node's children sit next to each other, and every level of a subtree
+// is one contiguous run of nodes. Changing a local matrix only marks the
+// node dirty; Update then sweeps each dirty subtree one level at a time, so
+// moving an assembly costs its own nodes and nothing else in the scene.
+#pragma once
+#ifndef TRANSFORM_GRAPH
+#define TRANSFORM_GRAPH
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "JobSystem.h"
+
+class TransformGraph {
+ public:
+  // Stable node identifier. Nodes keep their id however the tree is laid
+  // out.
+  typedef uint32_t NodeId;
+  static constexpr NodeId kNoNode = ~0u;
+
+ private:
+  // Tree structure, by id. Children are linked in the order they're added.
+  std::vector<NodeId> parents;
+  std::vector<NodeId> firstChildren;
+  std::vector<NodeId> lastChildren;
+  std::vector<NodeId> nextSiblings;
+  std::vector<uint32_t> positions;   // where each node sits below
+  std::vector<uint8_t> dirty;        // local changed since the last Update
+
+  // Nodes in breadth first order, roots first. A node's children are
+  // numChildren positions from childBegin; parentPos is kNoNode for roots.
+  std::vector<NodeId> ids;
+  std::vector<uint32_t> parentPos;
+  std::vector<uint32_t> childBegin;
+  std::vector<uint32_t> numChildren;
+  std::vector<glm::mat4> locals;
+  std::vector<glm::mat4> worlds;
+  std::vector<glm::mat3> normMats;
+  uint32_t numRoots = 0;
+
+  // Update each node was last swept in, so dirty nodes inside a subtree
+  // that was already swept are skipped
+  std::vector<uint32_t> sweptIn;
+  uint32_t updateCount = 0;
+
+  // Nodes whose local matrix changed, and nodes added since the layout was
+  // last worked out
+  std::vector<NodeId> dirtyNodes;
+  bool relayout = false;
+
+  // Nodes whose world matrices the last Update recomputed
+  std::vector<NodeId> updated;
+
+  // Reorders every node breadth first, roots in the order they were added
+  void Layout();
+
+  // Recomputes world and normal matrices for a run of positions whose
+  // parents are already up to date
+  void UpdateRange(uint32_t begin, uint32_t end);
+
+  // Updates a run of positions and everything under them, a level at a
+  // time, spreading large levels across jobs unless jobs is null
+  void Sweep(uint32_t begin, uint32_t end, JobSystem* jobs);
+
+ public:
+  // Adds a node under parent, or as a root if parent is kNoNode. Its world
+  // matrix is worked out on the next Update.
+  NodeId AddNode(NodeId parent, const glm::mat4& local);
+
+  // Replaces a node's local matrix, marking its subtree for the next Update
+  void SetLocal(NodeId node, const glm::mat4& local);
+
+  // Brings the world and normal matrices of every dirty subtree up to date,
+  // spreading large levels across jobs unless jobs is null. Nothing is
+  // recomputed if nothing changed, and when much of the tree is dirty all
+  // of it is.
+  void Update(JobSystem* jobs);
+
+  // Nodes the last Update recomputed, each subtree breadth first
+  const std::vector<NodeId>& Updated() const;
+
+  const glm::mat4& Local(NodeId node) const;
+  const glm::mat4& World(NodeId node) const;
+
+  // Transpose of the inverse of the world matrix's upper 3x3, for normals
+  const glm::mat3& NormalMat(NodeId node) const;
+
+  NodeId Parent(NodeId node) const;
+  uint32_t NumNodes() const;
+};
+#endif
@@ -0,0 +1,170 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The UniformRing class holds every uniform block value that changes from
+// frame to frame (camera, materials, per-object matrices) in one uniform
+// buffer. The buffer is split into three frame regions that are written in
+// turn, so the CPU fills one while the GPU may still be reading the other
+// two. A fence at the end of each frame says when its region is free again.
+// Values are copied straight into mapped memory and bound by range. Where
+// GL_ARB_buffer_storage is available the buffer is mapped once, persistently;
+// otherwise it's orphaned and mapped again each frame.
+#include "UniformRing.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+  // Flags for the persistent buffer's storage and its one mapping. Coherent
+  // mapping makes writes visible without explicit flushes.
+  const GLbitfield kPersistentFlags =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  // How long to wait on a fence between checks, in nanoseconds
+  const GLuint64 kFenceTimeout = 1000000;
+}  // namespace
+
+// Querying offset alignment, then creating the buffer
+UniformRing::UniformRing(GLStateCache* glState, GLsizeiptr frameSize)
+    : glState(glState) {
+  GLint align = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+  if (align > 0) {
+    offsetAlign = align;
+  }
+  persistent = GLEW_ARB_buffer_storage && glBufferStorage != nullptr;
+  Create(frameSize);
+  std::cout << "Uniform ring: " << kNumFrames << " x " << this->frameSize
+            << " bytes, " << (persistent ? "persistent" : "orphaned")
+            << std::endl;
+}
+
+// Sizing regions, allocating storage, and mapping it all at once if the
+// buffer is persistent. Orphaned buffers need only one region, since the
+// driver hands out fresh storage on each orphaning.
+void UniformRing::Create(GLsizeiptr minFrameSize) {
+  frameSize = Aligned(std::max<GLsizeiptr>(minFrameSize, offsetAlign));
+  glGenBuffers(1, &UBO);
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, UBO);
+  if (persistent) {
+    glBufferStorage(GL_COPY_WRITE_BUFFER, frameSize * kNumFrames, nullptr,
+                    kPersistentFlags);
+    mapped = static_cast<unsigned char*>(
+               glMapBufferRange(GL_COPY_WRITE_BUFFER, 0,
+                                frameSize * kNumFrames, kPersistentFlags));
+  } else {
+    glBufferData(GL_COPY_WRITE_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+  }
+}
+
+// Blocking until the GPU passes the fence. The first wait flushes the
+// command stream so the fence is sure to be reached.
+void UniformRing::WaitFrame(int waitFrame) {
+  GLsync fence = fences[waitFrame];
+  if (fence == nullptr) {
+    return;
+  }
+  GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  GLenum result = glClientWaitSync(fence, waitFlags, kFenceTimeout);
+  while (result == GL_TIMEOUT_EXPIRED) {
+    waitFlags = 0;
+    result = glClientWaitSync(fence, waitFlags, kFenceTimeout);
+  }
+  if (result == GL_WAIT_FAILED) {
+    std::cout << "Uniform ring: fence wait failed" << std::endl;
+  }
+  glDeleteSync(fence);
+  fences[waitFrame] = nullptr;
+}
+
+// Advancing to the next region, regrowing if it's too small
+void UniformRing::BeginFrame(GLsizeiptr bytesNeeded) {
+  Profiler::Scope cpuScope("UniformRing::BeginFrame");
+  if (bytesNeeded > frameSize) {
+    // Delete waits for every region the GPU may still be reading
+    Delete();
+    Create(std::max(bytesNeeded, frameSize * 2));
+  }
+
+  frame = (frame + 1) % kNumFrames;
+  head = 0;
+  if (persistent) {
+    WaitFrame(frame);
+    frameBase = frameSize * frame;
+  } else {
+    // Orphaning, so the GPU keeps reading the old storage while this
+    // frame's values go into new storage without waiting
+    frameBase = 0;
+    glState->BindBuffer(GL_COPY_WRITE_BUFFER, UBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+    mapped = static_cast<unsigned char*>(
+               glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, frameSize,
+                                GL_MAP_WRITE_BIT |
+                                GL_MAP_INVALIDATE_BUFFER_BIT));
+  }
+}
+
+// Handing out the frame region's next aligned range
+void* UniformRing::Allocate(GLsizeiptr size, GLintptr* offset) {
+  *offset = frameBase + head;
+  head += Aligned(size);
+  return mapped + *offset;
+}
+
+GLintptr UniformRing::Write(const void* data, GLsizeiptr size) {
+  GLintptr offset = 0;
+  std::memcpy(Allocate(size, &offset), data, static_cast<size_t>(size));
+  return offset;
+}
+
+GLsizeiptr UniformRing::Aligned(GLsizeiptr size) const {
+  return (size + offsetAlign - 1) / offsetAlign * offsetAlign;
+}
+
+// Persistent writes are coherent already; per-frame mappings have to be
+// unmapped before the GPU can read them. Either way, everything written
+// this frame counts as uploaded.
+void UniformRing::Flush() {
+  glState->CountBufferUpload(head);
+  if (persistent) {
+    return;
+  }
+  glState->BindBuffer(GL_COPY_WRITE_BUFFER, UBO);
+  if (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_FALSE) {
+    std::cout << "Uniform ring: buffer contents lost while mapped"
+              << std::endl;
+  }
+  mapped = nullptr;
+}
+
+void UniformRing::Bind(GLuint binding, GLintptr offset,
+                       GLsizeiptr size) {
+  glState->BindUniformRange(binding, UBO, offset, size);
+}
+
+// Orphaned buffers don't need fences; the driver tracks their storage
+void UniformRing::EndFrame() {
+  if (persistent) {
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+}
+
+// Unmapping and deleting the buffer. Fences are waited on first so the GPU
+// isn't left reading deleted storage.
+void UniformRing::Delete() {
+  for (int i = 0; i < kNumFrames; ++i) {
+    WaitFrame(i);
+  }
+  if (mapped != nullptr) {
+    glState->BindBuffer(GL_COPY_WRITE_BUFFER, UBO);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    mapped = nullptr;
+  }
+  glState->ForgetBuffer(UBO);
+  glDeleteBuffers(1, &UBO);
+  UBO = 0;
+}
@@ -0,0 +1,100 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// All code follows Google's style guide as closely as possible
+// without sacrificing clarity. Excessive comments are meant to
+// demonstrate understanding and not to explain the obvious.
+
+// The UniformRing class holds every uniform block value that changes from
+// frame to frame (camera, materials, per-object matrices) in one uniform
+// buffer. The buffer is split into three frame regions that are written in
+// turn, so the CPU fills one while the GPU may still be reading the other
+// two. A fence at the end of each frame says when its region is free again.
+// Values are copied straight into mapped memory and bound by range. Where
+// GL_ARB_buffer_storage is available the buffer is mapped once, persistently;
+// otherwise it's orphaned and mapped again each frame.
+#pragma once
+#ifndef UNIFORM_RING
+#define UNIFORM_RING
+
+#include <GL/glew.h>
+
+#include "GLStateCache.h"
+
+class UniformRing {
+ public:
+  // Frames of uniform data in flight at once
+  static const int kNumFrames = 3;
+
+ private:
+  GLuint UBO = 0;
+
+  // Binds go through the owner's state cache
+  GLStateCache* glState = nullptr;
+
+  // Bytes per frame region, a multiple of the offset alignment
+  GLsizeiptr frameSize = 0;
+
+  // Required alignment of glBindBufferRange offsets
+  GLsizeiptr offsetAlign = 256;
+
+  // True if the buffer is persistently mapped; false if it's orphaned and
+  // mapped once per frame
+  bool persistent = false;
+
+  // Start of the mapped buffer. Persistent mappings cover every frame
+  // region; per-frame mappings cover just the one being written.
+  unsigned char* mapped = nullptr;
+
+  // Signalled when the GPU is done with each frame region
+  GLsync fences[kNumFrames] = {};
+
+  // Region being written, its byte offset in the buffer, and bytes used
+  int frame = 0;
+  GLintptr frameBase = 0;
+  GLsizeiptr head = 0;
+
+  // Creates the buffer with frame regions of at least the given size, and
+  // maps it if it's persistent
+  void Create(GLsizeiptr minFrameSize);
+
+  // Waits on and deletes a frame region's fence, if it has one
+  void WaitFrame(int waitFrame);
+
+ public:
+  // Creates a ring with room for the given bytes per frame. Needs a
+  // current GL context.
+  UniformRing(GLStateCache* glState, GLsizeiptr frameSize);
+
+  // GL objects have exactly one owner
+  UniformRing(const UniformRing&) = delete;
+  UniformRing& operator=(const UniformRing&) = delete;
+
+  // Starts writing the next frame region, waiting if the GPU is still
+  // reading it. Regrows the ring first if a frame needs more than
+  // frameSize bytes; bytesNeeded should count Write's alignment padding.
+  void BeginFrame(GLsizeiptr bytesNeeded);
+
+  // Claims size bytes of the frame region for the caller to fill, and sets
+  // offset to their buffer offset for Bind
+  void* Allocate(GLsizeiptr size, GLintptr* offset);
+
+  // Copies a block's value into the frame region, returning its buffer
+  // offset for Bind
+  GLintptr Write(const void* data, GLsizeiptr size);
+
+  // Bytes a Write of size bytes takes up, padding included
+  GLsizeiptr Aligned(GLsizeiptr size) const;
+
+  // Makes this frame's writes visible to the GPU. Must come after the last
+  // Write and before the first draw that reads them.
+  void Flush();
+
+  // Binds a written value to a uniform buffer binding point
+  void Bind(GLuint binding, GLintptr offset, GLsizeiptr size);
+
+  // Fences the frame region once every draw reading it has been issued
+  void EndFrame();
+
+  // Unmaps and deletes the buffer
+  void Delete();
+};
+#endif
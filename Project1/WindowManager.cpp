@@ -9,6 +9,7 @@
 // with dbgMode set to true for debug messages each frame.
 #include "WindowManager.h"
 #include "ModelManager.h"
+#include "Profiler.h"
 
 #include <map>
 #include <iomanip>
@@ -17,6 +18,14 @@
 
 #include "Camera.h"
 
+namespace {
+  // Frames F9 captures to the profiler's trace
+  const uint32_t kProfileFrames = 120;
+
+  // File F10 writes the GL counters to
+  const char* kGLStatsFile = "gl_stats.csv";
+}  // namespace
+
 // Window manager ctor. All parameters necessary to make a window.
 WindowManager::WindowManager(GLfloat height, GLfloat width,
                              std::string title, bool dbgMode) {
@@ -51,6 +60,12 @@ void WindowManager::initWindow() {
   // and centering cursor.
   glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
   glfwSetCursorPos(window, windowWidth / 2, windowHeight / 2);
+
+  // Using unscaled, unaccelerated mouse motion where the platform has it,
+  // which only applies while the cursor is disabled
+  if (glfwRawMouseMotionSupported()) {
+    glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+  }
   glfwSetCursorPosCallback(window, mouseMoveCallback);
   glfwSetScrollCallback(window, mouseScrollCallback);
 
@@ -73,26 +88,46 @@ void WindowManager::resizeCallback(GLFWwindow* window, int width, int height) {
   glViewport(0, 0, width, height);
 }
 
-// Called on mouse scroll, adjusts camera fly speed
+// Called on mouse scroll, counts clicks for the camera's fly speed
 void WindowManager::mouseScrollCallback(GLFWwindow* window,
-                                        double xOffset, double yOffset) {
-  // Getting camera pointer from object array
-  Camera* camPtr = reinterpret_cast<Camera*>(
-                     reinterpret_cast<void**>(
-                       glfwGetWindowUserPointer(window))[4]);
-
-  camPtr->adjustSpeed(static_cast<float>(xOffset), static_cast<float>(yOffset));
+                                        double /*xOffset*/, double yOffset) {
+  // Getting window manager pointer from object array
+  WindowManager* winMgrPtr = reinterpret_cast<WindowManager*>(
+                               reinterpret_cast<void**>(
+                                 glfwGetWindowUserPointer(window))[0]);
+
+  // The camera only reacts to whole clicks up or down
+  std::lock_guard<std::mutex> lock(winMgrPtr->inputLock);
+  if (yOffset == -1) {
+    --winMgrPtr->input.scrollSteps;
+  } else if (yOffset == 1) {
+    ++winMgrPtr->input.scrollSteps;
+  }
 }
 
-// Called when a mouse move is detected, updates camera pitch and yaw
+// Called when a mouse move is detected, adds the movement to what the
+// camera turns by on its next step. However many events arrive, the camera
+// turns once by their sum.
 void WindowManager::mouseMoveCallback(GLFWwindow* window,
                                       double x, double y) {
-  // Getting camera pointer from object array
-  Camera* camPtr = reinterpret_cast<Camera*>(
-                     reinterpret_cast<void**>(
-                       glfwGetWindowUserPointer(window))[4]);
+  // Getting window manager pointer from object array
+  WindowManager* winMgrPtr = reinterpret_cast<WindowManager*>(
+                               reinterpret_cast<void**>(
+                                 glfwGetWindowUserPointer(window))[0]);
+
+  // Only GLFW's thread touches the last position, so it needs no lock
+  double xOffset = x - winMgrPtr->lastCursorX;
+  double yOffset = y - winMgrPtr->lastCursorY;
+  winMgrPtr->lastCursorX = x;
+  winMgrPtr->lastCursorY = y;
+  if (winMgrPtr->firstCursor) {
+    winMgrPtr->firstCursor = false;
+    return;
+  }
 
-  camPtr->updateDir(static_cast<float>(x), static_cast<float>(y));
+  std::lock_guard<std::mutex> lock(winMgrPtr->inputLock);
+  winMgrPtr->input.lookX += static_cast<float>(xOffset);
+  winMgrPtr->input.lookY += static_cast<float>(yOffset);
 }
 
 // Debug printing callback. BAD FOR PERFORMANCE
@@ -174,6 +209,22 @@ bool WindowManager::closeCheck() {
   return glfwWindowShouldClose(window);
 }
 
+// Sampled after drawing and before the next frame starts, so the counters
+// are the frame just drawn
+void WindowManager::SampleGLStats() {
+  void** objArr = reinterpret_cast<void**>(glfwGetWindowUserPointer(window));
+  ModelManager* modMgrPtr = reinterpret_cast<ModelManager*>(objArr[1]);
+  glStats.Add(modMgrPtr->StateCounters());
+}
+
+const GLStats& WindowManager::GetGLStats() const {
+  return glStats;
+}
+
+bool WindowManager::DumpGLStats(const std::string& path) const {
+  return glStats.WriteCsv(path);
+}
+
 // Returns window pointer.
 GLFWwindow* WindowManager::GetWinPtr() {
   return window;
@@ -184,14 +235,14 @@ GLFWwindow* WindowManager::GetWinPtr() {
 // A/D : left/right
 // Q/E : up/down
 // P   : switch perspective
+// F9  : write a trace of the next kProfileFrames frames
+// F10 : write the last GLStats::kWindowFrames frames' GL counters
 // Esc : exit program
 
 void WindowManager::ProcessInput() {
-  void** objArr = reinterpret_cast<void**>(glfwGetWindowUserPointer(window));
-  Camera* camPtr = reinterpret_cast<Camera*>(objArr[4]);
   unsigned int moveBits = 0;
   // Move on WASD and Q/E keys. W and S are forward and reverse,
-    // A and D are left and right, Q and E are up and down.
+  // A and D are left and right, Q and E are up and down.
   if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
     moveBits ^= 0b000001;
   }
@@ -210,15 +261,48 @@ void WindowManager::ProcessInput() {
   if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
     moveBits ^= 0b100000;
   }
-  if (moveBits != 0) {
-    camPtr->updatePos(moveBits);
+  // Toggle ortho/persp projection
+  bool projHeld = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+
+  // Handing held keys to the simulation thread, which moves the camera
+  {
+    std::lock_guard<std::mutex> lock(inputLock);
+    input.moveBits = moveBits;
+    input.projHeld = projHeld;
   }
+
+  // Capturing a trace when F9 goes down
+  bool profileKey = glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS;
+  if (profileKey && !profileKeyHeld) {
+    Profiler::Capture(kProfileFrames);
+  }
+  profileKeyHeld = profileKey;
+
+  // Dumping GL counters when F10 goes down
+  bool statsKey = glfwGetKey(window, GLFW_KEY_F10) == GLFW_PRESS;
+  if (statsKey && !statsKeyHeld) {
+    if (DumpGLStats(kGLStatsFile)) {
+      std::cout << "Wrote " << glStats.Size() << " frames of GL stats to "
+                << kGLStatsFile << std::endl;
+    } else {
+      std::cout << "Couldn't write GL stats to " << kGLStatsFile
+                << std::endl;
+    }
+  }
+  statsKeyHeld = statsKey;
+
   // Set whether window should close. Exits program.
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
     glfwSetWindowShouldClose(window, true);
   }
-  // Toggle ortho/persp projection
-  if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
-    camPtr->projSwitch();
-  }
+}
+
+// Copying out pending input and clearing what's been used up
+WindowManager::InputState WindowManager::TakeInput() {
+  std::lock_guard<std::mutex> lock(inputLock);
+  InputState taken = input;
+  input.lookX = 0.0f;
+  input.lookY = 0.0f;
+  input.scrollSteps = 0;
+  return taken;
 }
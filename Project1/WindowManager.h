@@ -14,13 +14,26 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <mutex>
 #include <string>
 
 #include <glm/glm.hpp>
 
+#include "GLStats.h"
 
 // Window manager. Handles callbacks, input, and of course drawing the window.
 class WindowManager {
+ public:
+    // Input gathered on the main thread, where GLFW delivers it, for the
+    // simulation thread to apply to the camera
+    struct InputState {
+      unsigned int moveBits = 0;  // movement keys held, Camera::moveDir bits
+      bool projHeld = false;      // P held
+      float lookX = 0.0f;         // cursor movement since input was last
+      float lookY = 0.0f;         // taken, summed over every event
+      int scrollSteps = 0;        // scroll clicks since input was last taken
+    };
+
  private:
     // True to enable debug output, prints logs.(Debug output is awful for
     // performance due to the pretty printing function I wrote!)
@@ -34,6 +47,24 @@ class WindowManager {
     // window pointer
     GLFWwindow* window = nullptr;
 
+    // Input not yet taken by the simulation thread
+    std::mutex inputLock;
+    InputState input;
+
+    // Last cursor position, which each cursor event is measured from. The
+    // first event only sets it, so the camera doesn't jump to wherever the
+    // cursor started.
+    bool firstCursor = true;
+    double lastCursorX = 0.0;
+    double lastCursorY = 0.0;
+
+    // Whether F9 was down last frame, so holding it starts one capture
+    bool profileKeyHeld = false;
+
+    // GL counters of recent frames, and whether F10 was down last frame
+    GLStats glStats;
+    bool statsKeyHeld = false;
+
     // Sets up and creates window. Initializes GLFW and GLW
     void initWindow();
 
@@ -64,9 +95,27 @@ class WindowManager {
     // Check whether window ought to close
     bool closeCheck();
 
-    // Processes keyboard input. WASDQE to move, Esc to exit.
+    // Processes keyboard input. WASDQE to move, F9 to profile, F10 to dump
+    // GL stats, Esc to exit. Called once a frame on the main thread, after
+    // polling events.
     void ProcessInput();
 
+    // Returns the input gathered since the last call, clearing the cursor
+    // movement and scroll clicks. Held keys stay held until they're released.
+    // Safe to call from any thread.
+    InputState TakeInput();
+
+    // Adds the GL counters of the frame just drawn to the rolling window.
+    // Called once a frame, after drawing.
+    void SampleGLStats();
+
+    // GL counters over the last GLStats::kWindowFrames frames
+    const GLStats& GetGLStats() const;
+
+    // Writes the GL counters' window to a CSV file, returning false if it
+    // can't be written
+    bool DumpGLStats(const std::string& path) const;
+
     // Returns window pointer
     GLFWwindow* GetWinPtr();
 };
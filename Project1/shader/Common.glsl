@@ -0,0 +1,16 @@
+// Alice Norris, SNHU, Project 1 of CS-330 23EW3
+// Excessive comments are meant to demonstrate understanding and not to explain
+// the obvious. 
+
+// Functions shared by every shader program. The Shader class inserts this
+// right after each stage's #version line, since GLSL 3.3 has no #include.
+// No #version here, and nothing but functions, so any stage can take it.
+
+// unfolds an octahedral encoded normal back onto the unit sphere
+vec3 octDecode(vec2 oct) {
+  vec3 norm = vec3(oct, 1.0 - abs(oct.x) - abs(oct.y));
+  float fold = max(-norm.z, 0.0);
+  norm.x += norm.x >= 0.0 ? -fold : fold;
+  norm.y += norm.y >= 0.0 ? -fold : fold;
+  return normalize(norm);
+}
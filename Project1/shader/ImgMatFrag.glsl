@@ -47,13 +47,23 @@ in vec2 texCoord;
 // position of camera
 in vec3 viewPos;
 
-//// UNIFORM: LOADED BY LOAD CALL
+//// UNIFORM: SET ONCE AT STARTUP
 // sampler for diffuse texture
 uniform sampler2D diffSamp;
 // sampler for specular texture
 uniform sampler2D specSamp;
-// material gloss
-uniform float gloss;
+
+//// UNIFORM: LOADED BY BUFFER RANGE, ONCE PER TEXTURE
+// Material for the model. Only gloss is used; colors come from the
+// textures, but the layout matches the property shader's.
+layout(std140) uniform matData{
+  // Material colors
+  vec3 amb;
+  vec3 diff;
+  vec3 spec;
+  // Material shininess factor
+  float gloss;
+} material;
 
 
 //// UNIFORM: LOADED BY BUFFER
@@ -109,7 +119,7 @@ vec3 dirLightCalc(DirLight light, vec3 viewDir) {
   float diffVal = max(dot(normVec, lightDir), 0.0);
 
   // calculating specular factor
-  float specVal = pow(max(dot(viewDir, reflectDir), 0.0), gloss);
+  float specVal = pow(max(dot(viewDir, reflectDir), 0.0), material.gloss);
 
   // calculating ambient, diffuse, specular colors
   vec3 ambient = vec3(light.amb)
@@ -141,7 +151,7 @@ vec3 pntLightCalc(PntLight light, vec3 viewDir) {
 
   // calculating diff and spec factors
   float diff = max(dot(normVec, lightDir), 0.0);
-  float spec = pow(max(dot(viewDir, reflectDir), 0.0), gloss);
+  float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.gloss);
 
   // calculating ambient, diffuse, and sepcular colors
   vec3 ambient = vec3(light.amb) * vec3(texture(diffSamp, texCoord));
@@ -14,11 +14,24 @@ layout(location = 1) in vec3 inNorm;
 // texture coordinate
 layout(location = 2) in vec2 inTex;
 
-//// UNIFORMS LOADED BY LOAD CALLS
-// model matrix
-uniform mat4 modelMat;
-// normal matrix
-uniform mat3 normMat; 
+//// UNIFORMS LOADED BY BUFFER RANGE, ONCE PER INSTANCED DRAW
+// Must match kMaxInstances in ModelManager.cpp
+#define MAX_INSTANCES 128
+
+// Per-instance data
+struct ObjData {
+  // model matrix
+  mat4 modelMat;
+  // normal matrix
+  mat3 normMat;
+  // true if inNorm holds an octahedral encoded normal in xy (compact verts)
+  bool octNorm;
+};
+
+// One entry per instance of the draw, indexed by gl_InstanceID
+layout(std140) uniform objData{
+  ObjData objs[MAX_INSTANCES];
+};
 
 //// UNIFORMS LOADED BY BUFFER
 layout(std140) uniform camData{
@@ -40,12 +53,17 @@ out vec2 texCoord;
 // camera position
 out vec3 viewPos;
 
+// octDecode comes from Common.glsl, inserted by the Shader class
+
 void main()
 {
+  // this instance's transforms
+  ObjData obj = objs[gl_InstanceID];
   // casting frag position to vec3 after calculating from model matrix
-  fragPosVec = vec3(modelMat * vec4(inPos, 1.0f));
+  fragPosVec = vec3(obj.modelMat * vec4(inPos, 1.0f));
   // calculating normal vector 
-  normVec = normalize(normMat * inNorm);
+  normVec = normalize(obj.normMat *
+                    (obj.octNorm ? octDecode(inNorm.xy) : inNorm));
   // sending on tex coordinate as is
   texCoord = inTex;
   // sending on camera position as vec3
@@ -7,16 +7,6 @@
 #version 330 core
 #define MAX_P_LIGHTS 8
 #define MAX_D_LIGHTS 8
-// Defines material attributes
-struct Material {
-  // Material colors
-  vec3 amb;
-  vec3 diff;
-  vec3 spec;
-  // Material shininess factor
-  float gloss;
-};
-
 // Defines directional light attributes
 struct DirLight {
   // Light direction
@@ -53,9 +43,16 @@ in vec3 normVec;
 // position of camera
 in vec3 viewPos;
 
-////// UNIFORM: LOADED BY LOAD CALL
+//// UNIFORM: LOADED BY BUFFER RANGE, ONCE PER MATERIAL
 // Material for the model
-uniform Material material;
+layout(std140) uniform matData{
+  // Material colors
+  vec3 amb;
+  vec3 diff;
+  vec3 spec;
+  // Material shininess factor
+  float gloss;
+} material;
 
 //// UNIFORM: LOADED BY BUFFER
 // Dirlight data and number of dir lights